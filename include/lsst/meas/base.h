@@ -26,10 +26,18 @@
 
 #include "lsst/meas/base/exceptions.h"
 #include "lsst/meas/base/FluxUtilities.h"
+#include "lsst/meas/base/AffineWcsGrid.h"
+#include "lsst/meas/base/ApplyApCorr.h"
+#include "lsst/meas/base/FootprintTransformer.h"
+#include "lsst/meas/base/SourceFamilies.h"
+#include "lsst/meas/base/CoaddInputCoverage.h"
 #include "lsst/meas/base/CentroidUtilities.h"
 #include "lsst/meas/base/ShapeUtilities.h"
 #include "lsst/meas/base/FlagHandler.h"
 #include "lsst/meas/base/InputUtilities.h"
+#include "lsst/meas/base/PsfImageCache.h"
+#include "lsst/meas/base/ScratchArena.h"
+#include "lsst/meas/base/FastMath.h"
 #include "lsst/meas/base/Algorithm.h"
 #include "lsst/meas/base/PsfFlux.h"
 #include "lsst/meas/base/SdssCentroid.h"
@@ -43,6 +51,10 @@
 #include "lsst/meas/base/ScaledApertureFlux.h"
 #include "lsst/meas/base/CircularApertureFlux.h"
 #include "lsst/meas/base/Blendedness.h"
+#include "lsst/meas/base/Variance.h"
+#include "lsst/meas/base/Jacobian.h"
+#include "lsst/meas/base/FPPosition.h"
+#include "lsst/meas/base/SkyCoord.h"
 
 // These are necessary to build Swig modules that %import meas/base/baseLib.i,
 // so it's neighborly to include them here so downstream code can just
@@ -0,0 +1,118 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_AffineWcsGrid_h_INCLUDED
+#define LSST_MEAS_BASE_AffineWcsGrid_h_INCLUDED
+
+#include <vector>
+
+#include "lsst/afw/geom/Angle.h"
+#include "lsst/afw/geom/Box.h"
+#include "lsst/afw/geom/AffineTransform.h"
+#include "lsst/afw/coord/Coord.h"
+#include "lsst/afw/image/Wcs.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  A grid of local affine approximations to a Wcs's pixel-to-sky transformation.
+ *
+ *  Evaluating or linearizing a distorted (e.g. TAN-SIP) Wcs at every source of a catalog can dominate
+ *  the cost of transforming measurements to celestial coordinates.  AffineWcsGrid covers a region of
+ *  the image with square cells, and linearizes the Wcs once at the centre of each.  Every cell's
+ *  approximation is checked against the full Wcs at the cell's corners, and cells where it is off by
+ *  more than the tolerance (and points outside the grid) fall back to the full Wcs.  Only the corners
+ *  are checked: for a smoothly varying distortion they are where a linearization about the centre is
+ *  worst, so positions within a cell are normally within the tolerance too, but that isn't guaranteed
+ *  for a Wcs whose distortion has structure on scales smaller than a cell.  A grid whose Wcs is not in
+ *  ICRS, or whose tolerance is not positive, always uses the full Wcs.
+ *
+ *  Sky coordinates are (ra, dec) in radians, as returned by
+ *  Wcs::linearizePixelToSky(position, afw::geom::radians).
+ */
+class AffineWcsGrid {
+public:
+
+    /**
+     *  Construct the grid.
+     *
+     *  @param[in] wcs        Wcs to approximate; must outlive the grid.
+     *  @param[in] bbox       Region (in parent pixel coordinates) to cover.
+     *  @param[in] cellSize   Size (pixels) of the square grid cells.
+     *  @param[in] tolerance  Largest allowed on-sky error of a cell's approximation at its corners.
+     */
+    AffineWcsGrid(
+        afw::image::Wcs const & wcs,
+        afw::geom::Box2D const & bbox,
+        double cellSize,
+        afw::geom::Angle tolerance
+    );
+
+    /**
+     *  Return a grid covering an exposure, reusing the one returned by the previous call on this thread
+     *  if it was for the same Wcs, region and parameters.
+     *
+     *  This lets several algorithms that measure the same exposure one source at a time share a single
+     *  grid.  The cache does not keep the Wcs alive, so the returned grid must not be used after it is
+     *  destroyed.
+     */
+    static PTR(AffineWcsGrid const) getCached(
+        PTR(afw::image::Wcs const) wcs,
+        afw::geom::Box2D const & bbox,
+        double cellSize,
+        afw::geom::Angle tolerance
+    );
+
+    /// Return true if the grid approximates any part of the Wcs (i.e. it isn't just the full Wcs).
+    bool isEnabled() const { return !_valid.empty(); }
+
+    /// Return the sky position of a point, from its cell's approximation or the full Wcs.
+    afw::coord::IcrsCoord pixelToSky(afw::geom::Point2D const & position) const;
+
+    /// Return the local linearization (to radians) at a point, from its cell or the full Wcs.
+    afw::geom::AffineTransform linearizePixelToSky(afw::geom::Point2D const & position) const;
+
+    /// Return the number of cells whose approximation is within the tolerance.
+    int getValidCellCount() const;
+
+    /// Return the total number of cells.
+    int getCellCount() const { return _nx*_ny; }
+
+private:
+
+    // Return the index of the cell containing a point, or -1 if it is outside the grid or the
+    // cell's approximation isn't within the tolerance.
+    int _findCell(afw::geom::Point2D const & position) const;
+
+    afw::image::Wcs const & _wcs;
+    afw::geom::Point2D _origin;
+    double _cellSize;
+    int _nx;
+    int _ny;
+    std::vector<afw::geom::AffineTransform> _transforms;
+    std::vector<bool> _valid;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_AffineWcsGrid_h_INCLUDED
@@ -291,6 +291,7 @@ public:
                             afw::image::Wcs const & wcs,
                             afw::image::Calib const & calib) const;
 private:
+    std::vector<FluxResultKey> _fluxKeys;
     std::vector<MagResultKey> _magKeys;
     Control _ctrl;
 };
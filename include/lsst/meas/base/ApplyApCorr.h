@@ -0,0 +1,100 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_ApplyApCorr_h_INCLUDED
+#define LSST_MEAS_BASE_ApplyApCorr_h_INCLUDED
+
+#include <string>
+
+#include "lsst/afw/math/BoundedField.h"
+#include "lsst/afw/table/Source.h"
+#include "lsst/meas/base/constants.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  Apply an aperture correction to one flux field of a whole catalog.
+ *
+ *  This is the inner loop of the Python ApplyApCorrTask.  The aperture correction models are
+ *  evaluated at every source's centroid slot in a single call, rather than one source at a time,
+ *  and the fluxes and flags are updated record by record in C++.
+ */
+class ApCorrApplier {
+public:
+
+    /**
+     *  Look up the fields for a flux measurement that is aperture corrected.
+     *
+     *  @param[in] schema  Schema holding {name}_flux, {name}_fluxSigma and {name}_flag, and the
+     *                     {name}_apCorr, {name}_apCorrSigma and {name}_flag_apCorr fields added by
+     *                     ApplyApCorrTask.  The flux's {name}_flag is normally a Flag, but (as the
+     *                     Python implementation allowed) may also be a double holding 0 or 1.
+     *  @param[in] name    Field name prefix of the flux, e.g. "base_PsfFlux".
+     *
+     *  @throw pex::exceptions::TypeError if {name}_flag is neither a Flag nor a double.
+     */
+    ApCorrApplier(afw::table::Schema const & schema, std::string const & name);
+
+    /**
+     *  Apply aperture corrections to every record in a catalog.
+     *
+     *  Records for which the correction can't be evaluated (the model raises DomainError) or isn't
+     *  positive keep their fluxes, and have {name}_flag_apCorr set; if doFlagApCorrFailures, the flux's
+     *  general failure flag is set too.
+     *
+     *  @param[in,out] catalog               Catalog to correct; must have a centroid slot.
+     *  @param[in]     apCorrModel           Model of the aperture correction.
+     *  @param[in]     apCorrSigmaModel      Model of the aperture correction's uncertainty; not
+     *                                       evaluated if useNaiveFluxSigma.
+     *  @param[in]     doFlagApCorrFailures  Set the flux failure flag when correction fails?
+     *  @param[in]     useNaiveFluxSigma     Scale the flux uncertainty by the correction, rather than
+     *                                       adding the correction's uncertainty in quadrature?
+     */
+    void apply(
+        afw::table::SourceCatalog & catalog,
+        afw::math::BoundedField const & apCorrModel,
+        afw::math::BoundedField const & apCorrSigmaModel,
+        bool doFlagApCorrFailures,
+        bool useNaiveFluxSigma
+    ) const;
+
+    /// Set the aperture correction failure flag on every record in a catalog.
+    void flagAll(afw::table::SourceCatalog & catalog) const;
+
+private:
+
+    bool _getFluxFlag(afw::table::BaseRecord const & record) const;
+    void _setFluxFlag(afw::table::BaseRecord & record, bool value) const;
+
+    afw::table::Key<Flux> _fluxKey;
+    afw::table::Key<FluxErrElement> _fluxSigmaKey;
+    afw::table::Key<afw::table::Flag> _fluxFlagKey;     // valid if {name}_flag is a Flag
+    afw::table::Key<double> _fluxFlagAsDoubleKey;       // valid if {name}_flag is a double
+    afw::table::Key<double> _apCorrKey;
+    afw::table::Key<double> _apCorrSigmaKey;
+    afw::table::Key<afw::table::Flag> _apCorrFlagKey;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_ApplyApCorr_h_INCLUDED
@@ -27,6 +27,7 @@
 #include "lsst/meas/base/constants.h"
 #include "lsst/afw/table/aggregates.h"
 #include "lsst/meas/base/Transform.h"
+#include "lsst/meas/base/AffineWcsGrid.h"
 
 namespace lsst { namespace meas { namespace base {
 
@@ -181,7 +182,17 @@ private:
  */
 class CentroidTransform : public BaseTransform {
 public:
-    CentroidTransform(std::string const & name, afw::table::SchemaMapper & mapper);
+    /**
+     *  @param[in]     name              Name of the centroid algorithm whose outputs are transformed.
+     *  @param[in,out] mapper            SchemaMapper to which the output fields are added.
+     *  @param[in]     wcsGridCellSize   Size (pixels) of the cells of the AffineWcsGrid used in place of
+     *                                   the full Wcs.
+     *  @param[in]     wcsGridTolerance  Largest allowed on-sky error of the AffineWcsGrid; if zero, the
+     *                                   full Wcs is evaluated at every source.
+     */
+    CentroidTransform(std::string const & name, afw::table::SchemaMapper & mapper,
+                      double wcsGridCellSize=64.0,
+                      afw::geom::Angle wcsGridTolerance=0.0*afw::geom::radians);
 
     /*
      * @brief Perform transformation from inputCatalog to outputCatalog.
@@ -196,9 +207,27 @@ public:
                             afw::table::BaseCatalog & outputCatalog,
                             afw::image::Wcs const & wcs,
                             afw::image::Calib const & calib) const;
+
+    /**
+     *  Return an AffineWcsGrid covering the centroids of inputCatalog.
+     *
+     *  The grid is disabled (it falls back to the full Wcs everywhere) if the tolerance is zero, or if
+     *  there are too few sources for it to be cheaper than evaluating the Wcs at each of them.
+     */
+    AffineWcsGrid makeWcsGrid(afw::table::SourceCatalog const & inputCatalog,
+                              afw::image::Wcs const & wcs) const;
+
+    /// Transform the centroids in inputCatalog to outputCatalog, using the given AffineWcsGrid.
+    void transformCentroids(afw::table::SourceCatalog const & inputCatalog,
+                            afw::table::BaseCatalog & outputCatalog,
+                            AffineWcsGrid const & grid) const;
+
 private:
+    CentroidResultKey _centroidResultKey;
     afw::table::CoordKey _coordKey;
     afw::table::CovarianceMatrixKey<ErrElement,2> _coordErrKey;
+    double _wcsGridCellSize;
+    afw::geom::Angle _wcsGridTolerance;
 };
 
 class CentroidChecker {
@@ -0,0 +1,106 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_CoaddInputCoverage_h_INCLUDED
+#define LSST_MEAS_BASE_CoaddInputCoverage_h_INCLUDED
+
+#include <vector>
+
+#include "lsst/afw/geom/Box.h"
+#include "lsst/afw/image/Wcs.h"
+#include "lsst/afw/image/CoaddInputs.h"
+#include "lsst/afw/table/Exposure.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  A low-resolution map of the number of coadd inputs covering each part of a coadd.
+ *
+ *  Counting the inputs that contain a point with ExposureCatalog::subsetContaining transforms the point
+ *  into every input's pixel coordinates, which dominates the cost of counting inputs for every source
+ *  on a deep coadd.  CoaddInputCoverage covers the coadd with square cells and counts the inputs
+ *  containing each cell corner once.  Cells whose corners all lie in the same inputs, and which contain
+ *  no input corner, are taken to have that many inputs everywhere; points in any other cell (or outside
+ *  the grid) are counted exactly.  Inputs are tested against their bounding boxes, as in
+ *  subsetContaining with includeValidPolygon=false.  The map can only miss an input's boundary if it
+ *  passes through a cell without separating its corners, i.e. if the input is narrower than a cell.
+ */
+class CoaddInputCoverage {
+public:
+
+    /**
+     *  Construct the map.
+     *
+     *  @param[in] ccds      Catalog of coadd inputs; every record must have a Wcs.
+     *  @param[in] wcs       Wcs of the coadd.
+     *  @param[in] bbox      Region of the coadd (in parent pixel coordinates) to cover.
+     *  @param[in] cellSize  Size (pixels) of the square grid cells.
+     */
+    CoaddInputCoverage(
+        afw::table::ExposureCatalog const & ccds,
+        afw::image::Wcs const & wcs,
+        afw::geom::Box2I const & bbox,
+        int cellSize
+    );
+
+    /**
+     *  Return a map of the CCD inputs to a coadd, reusing the one returned by the previous call on this
+     *  thread if it was for the same inputs, Wcs, region and cell size.
+     */
+    static PTR(CoaddInputCoverage const) getCached(
+        PTR(afw::image::CoaddInputs const) inputs,
+        PTR(afw::image::Wcs const) wcs,
+        afw::geom::Box2I const & bbox,
+        int cellSize
+    );
+
+    /// Return the number of inputs containing a point.
+    int countContaining(afw::geom::Point2D const & position) const;
+
+    /**
+     *  Return the smallest number of inputs at any grid cell corner in a region, or -1 if the region
+     *  contains no cell corners.
+     */
+    int computeMinCount(afw::geom::Box2D const & region) const;
+
+    /// Return the number of cells whose count is the same everywhere within them.
+    int getUniformCellCount() const;
+
+    /// Return the total number of cells.
+    int getCellCount() const { return _nx*_ny; }
+
+private:
+
+    afw::table::ExposureCatalog _ccds;
+    PTR(afw::image::Wcs const) _wcs;
+    afw::geom::Point2D _origin;
+    int _cellSize;
+    int _nx;
+    int _ny;
+    std::vector<int> _counts;    ///< number of inputs at each cell corner, (_nx + 1)*(_ny + 1)
+    std::vector<bool> _uniform;  ///< whether each cell's corners are in the same inputs, _nx*_ny
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_CoaddInputCoverage_h_INCLUDED
@@ -0,0 +1,82 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_FPPosition_h_INCLUDED
+#define LSST_MEAS_BASE_FPPosition_h_INCLUDED
+
+#include "lsst/pex/config.h"
+#include "lsst/afw/image/Exposure.h"
+#include "lsst/afw/table/aggregates.h"
+#include "lsst/meas/base/Algorithm.h"
+#include "lsst/meas/base/FlagHandler.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  @brief A C++ control class to handle FPPositionAlgorithm's configuration
+ *
+ *  The algorithm has no configuration parameters.
+ */
+class FPPositionControl {
+public:
+    FPPositionControl() {}
+};
+
+/**
+ *  @brief Compute the position of a source's centroid on the focal plane
+ *
+ *  Sources measured on an exposure without a Detector get NaN positions and the missingDetector flag.
+ */
+class FPPositionAlgorithm : public SimpleAlgorithm {
+public:
+
+    enum {
+        FAILURE=FlagHandler::FAILURE,
+        MISSING_DETECTOR,
+        N_FLAGS
+    };
+
+    /// A typedef to the Control object for this algorithm, defined above.
+    /// The control object contains the configuration parameters for this algorithm.
+    typedef FPPositionControl Control;
+
+    FPPositionAlgorithm(Control const & ctrl, std::string const & name, afw::table::Schema & schema);
+
+    virtual void measure(
+        afw::table::SourceRecord & measRecord,
+        afw::image::Exposure<float> const & exposure
+    ) const;
+
+    virtual void fail(
+        afw::table::SourceRecord & measRecord,
+        MeasurementError * error=NULL
+    ) const;
+
+private:
+    afw::table::PointKey<double> _focalPlaneKey;
+    FlagHandler _flagHandler;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_FPPosition_h_INCLUDED
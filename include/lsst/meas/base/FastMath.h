@@ -0,0 +1,71 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_FastMath_h_INCLUDED
+#define LSST_MEAS_BASE_FastMath_h_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  @brief Single-precision exp(x) for x <= 0, cheap enough to evaluate for every pixel
+ *
+ *  Range-reduces to 2^n e^g with |g| <= ln(2)/2 (ln(2) split in two so the reduction is exact) and uses
+ *  a degree-6 Taylor series for e^g; the relative error is below 3e-7.  Arguments below the float range
+ *  give 2^-126 rather than zero, and NaN gives NaN; positive arguments are not supported.
+ */
+inline float fastExp(float x) {
+    if (std::isnan(x)) {
+        return x;
+    }
+    x = (x > -87.0f) ? x : -87.0f;
+    float const n = std::floor(x*1.44269504f + 0.5f);
+    float const g = (x - n*0.693359375f) + n*2.12194440e-4f;
+    float const p = 1.0f + g*(1.0f + g*(1.0f/2.0f + g*(1.0f/6.0f + g*(1.0f/24.0f
+                                                                    + g*(1.0f/120.0f + g*(1.0f/720.0f))))));
+    std::int32_t const bits = (static_cast<std::int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(float));
+    return p*scale;
+}
+
+/**
+ *  @brief Single-precision erfc(x), given expMinusX2 = exp(-x^2)
+ *
+ *  Callers usually have exp(-x^2) already for their own Gaussian terms, so it is passed in rather than
+ *  recomputed.  Uses Abramowitz & Stegun 7.1.26; the absolute error is below 1e-6 when expMinusX2 comes
+ *  from fastExp.
+ */
+inline float fastErfc(float x, float expMinusX2) {
+    float const t = 1.0f/(1.0f + 0.3275911f*std::abs(x));
+    float const r = expMinusX2*t*(0.254829592f + t*(-0.284496736f
+                                                    + t*(1.421413741f + t*(-1.453152027f + t*1.061405429f))));
+    return (x < 0.0f) ? 2.0f - r : r;
+}
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_FastMath_h_INCLUDED
@@ -24,10 +24,13 @@
 #ifndef LSST_MEAS_BASE_FlagHandler_h_INCLUDED
 #define LSST_MEAS_BASE_FlagHandler_h_INCLUDED
 
+#include <cstdint>
 #include <vector>
 
 #include "lsst/afw/table/Schema.h"
 #include "lsst/afw/table/BaseRecord.h"
+#include "lsst/afw/table/Catalog.h"
+#include "lsst/afw/table/Source.h"
 #include "lsst/meas/base/exceptions.h"
 
 namespace lsst { namespace meas { namespace base {
@@ -200,11 +203,81 @@ public:
      */
     void handleFailure(afw::table::BaseRecord & record, MeasurementError const * error=NULL) const;
 
+    /**
+     *  Return a mask selecting the flags with the given enum values, for use with setValues(),
+     *  clearAll() and anySet().
+     *
+     *  The batch methods only address the first 64 flags; bit i of a mask corresponds to enum value i.
+     *
+     *  @throws pex::exceptions::LengthError if i >= 64.
+     */
+    static std::uint64_t makeMask(std::size_t i) {
+        if (i >= 64) {
+            throw LSST_EXCEPT(
+                pex::exceptions::LengthError,
+                "Only the first 64 flags of a FlagHandler can be selected by a mask"
+            );
+        }
+        return std::uint64_t(1) << i;
+    }
+
+    /// Return a mask selecting all of the flags (or the first 64, if there are more).
+    std::uint64_t getAllMask() const {
+        return _vector.size() >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << _vector.size()) - 1;
+    }
+
+    /**
+     *  Set or clear several flags in a record at once.
+     *
+     *  Flag fields are stored as bits in 64-bit words; all of the selected flags that share a word
+     *  are updated with a single masked write, rather than one record.set() call per flag.
+     *
+     *  @param[in,out] record  Record to modify.
+     *  @param[in]     mask    Flags to modify, as a bitwise OR of makeMask() values.
+     *  @param[in]     value   Value to give the selected flags.
+     */
+    void setValues(afw::table::BaseRecord & record, std::uint64_t mask, bool value) const;
+
+    /// Return true if any of the selected flags (by default, any of them) is set in the record.
+    bool anySet(afw::table::BaseRecord const & record, std::uint64_t mask=~std::uint64_t(0)) const;
+
+    /**
+     *  Clear all of the flags in a range of records of a catalog.
+     *
+     *  Unlike the other batch methods, this also clears any flags beyond the first 64 (one at a time).
+     *
+     *  @param[in,out] catalog  Catalog to modify.
+     *  @param[in]     begin    Index of the first record to clear.
+     *  @param[in]     end      One past the index of the last record to clear.
+     */
+    void clearAll(afw::table::BaseCatalog & catalog, std::size_t begin, std::size_t end) const;
+
+    /// @copydoc clearAll(afw::table::BaseCatalog &, std::size_t, std::size_t) const
+    void clearAll(afw::table::SourceCatalog & catalog, std::size_t begin, std::size_t end) const;
+
 private:
 
     typedef std::vector< std::pair<FlagDefinition, afw::table::Key<afw::table::Flag> > > Vector;
 
+    // A storage word holding some of the flags, with the key of one of them (to locate the word in
+    // records), and the selection mask of the flags it holds.
+    struct FlagWord {
+        afw::table::Key<afw::table::Flag> key;
+        std::uint64_t flags;
+    };
+
+    // Group the flags by storage word; called whenever _vector is filled.
+    void _makeWords();
+
+    // Return the bits of a storage word that correspond to the selected flags.
+    std::int64_t _getWordBits(FlagWord const & word, std::uint64_t mask) const;
+
+    // Implementation of the clearAll overloads.
+    template <typename Catalog>
+    void _clearAll(Catalog & catalog, std::size_t begin, std::size_t end) const;
+
     Vector _vector;
+    std::vector<FlagWord> _words;
 };
 
 }}} // lsst::meas::base
@@ -172,6 +172,12 @@ public:
     /// Set a MagResult in the record given the result of `afw::image::Calib::getMagnitude(double, double)`.
     virtual void set(afw::table::BaseRecord & record, std::pair<double,double> const & magPair) const;
 
+    /// Return the underlying mag Key
+    afw::table::Key<Mag> getMag() const { return _magKey; }
+
+    /// Return the underlying magErr Key
+    afw::table::Key<MagErrElement> getMagErr() const { return _magErrKey; }
+
 private:
     afw::table::Key<Mag> _magKey;
     afw::table::Key<MagErrElement> _magErrKey;
@@ -206,6 +212,7 @@ public:
                             afw::image::Wcs const & wcs,
                             afw::image::Calib const & calib) const;
 private:
+    FluxResultKey _fluxKey;
     MagResultKey _magKey;
 };
 
@@ -224,6 +231,29 @@ private:
     bool _throwOnNegative;
 };
 
+/**
+ *  Convert the fluxes in a column of a catalog to magnitudes in a column of another
+ *
+ *  Both catalogs must be of the same size.  When both are contiguous (as the catalogs passed to
+ *  transformations usually are) the flux and magnitude columns are accessed directly as arrays rather
+ *  than record by record; otherwise the records are visited one at a time.  Either way, each magnitude is
+ *  still computed individually by Calib::getMagnitude.  Negative fluxes are converted to NaN magnitudes
+ *  rather than throwing.
+ *
+ *  @param[in]     inputCatalog   Catalog holding the fluxes
+ *  @param[in]     fluxKey        Key for the fluxes and their uncertainties in inputCatalog
+ *  @param[in,out] outputCatalog  Catalog to hold the magnitudes
+ *  @param[in]     magKey         Key for the magnitudes and their uncertainties in outputCatalog
+ *  @param[in]     calib          Photometric calibration used to compute magnitudes
+ */
+void transformFluxColumns(
+    afw::table::SourceCatalog const & inputCatalog,
+    FluxResultKey const & fluxKey,
+    afw::table::BaseCatalog & outputCatalog,
+    MagResultKey const & magKey,
+    afw::image::Calib const & calib
+);
+
 }}} // lsst::meas::base
 
 #endif // !LSST_MEAS_BASE_FluxUtilities_h_INCLUDED
@@ -0,0 +1,118 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_FootprintTransformer_h_INCLUDED
+#define LSST_MEAS_BASE_FootprintTransformer_h_INCLUDED
+
+#include "lsst/base.h"
+#include "lsst/afw/geom/Box.h"
+#include "lsst/afw/image/Wcs.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/detection/Footprint.h"
+#include "lsst/afw/table/Source.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  Transform Footprints from the pixel coordinate system of one Wcs to that of another.
+ *
+ *  Footprint::transform maps every pixel of the target bounding box back through both Wcss.
+ *  FootprintTransformer instead linearizes the source-to-target pixel mapping once per Footprint,
+ *  about the centre of its bounding box, and maps the target pixels back through that affine
+ *  transform.  Footprints for which the linearization is off by more than maxError pixels at the
+ *  corners of their bounding boxes are transformed exactly, with Footprint::transform.
+ *
+ *  If keepHeavy is true, HeavyFootprints are transformed to HeavyFootprints, with each target pixel
+ *  taking the (nearest) source pixel's image, mask and variance values; image and variance values
+ *  are scaled by the ratio of the pixel areas, so the total flux is preserved.  Otherwise (and for
+ *  Footprints transformed exactly) the results are regular Footprints.  Those resampled pixels still
+ *  belong to the source (reference) image, so they must not be inserted into the target image as
+ *  they are; transformCatalog() can instead use them as deblend weights for the target's own pixels.
+ */
+class FootprintTransformer {
+public:
+
+    /**
+     *  The Wcss are held by shared pointer, so the transformer may outlive the caller's references.
+     *
+     *  @param[in] source     Wcs of the pixel coordinate system the Footprints are in.
+     *  @param[in] target     Wcs of the pixel coordinate system to transform them to.
+     *  @param[in] region     Region (in target parent pixels) to which the results are clipped.
+     *  @param[in] maxError   Largest error (target pixels) allowed for a Footprint's linearization;
+     *                        if zero, all Footprints are transformed exactly.
+     *  @param[in] keepHeavy  Transform HeavyFootprints to HeavyFootprints?
+     */
+    FootprintTransformer(
+        CONST_PTR(afw::image::Wcs) source,
+        CONST_PTR(afw::image::Wcs) target,
+        afw::geom::Box2I const & region,
+        double maxError,
+        bool keepHeavy
+    );
+
+    /// Transform a single Footprint.
+    PTR(afw::detection::Footprint) operator()(afw::detection::Footprint const & footprint) const;
+
+    /**
+     *  Set the Footprint of each record in targetCat to the transformed Footprint of the corresponding
+     *  record in sourceCat; records in sourceCat without Footprints are skipped.
+     *
+     *  @throws pex::exceptions::LengthError if the catalogs do not have the same size.
+     */
+    void transformCatalog(
+        afw::table::SourceCatalog const & sourceCat,
+        afw::table::SourceCatalog & targetCat
+    ) const;
+
+    /**
+     *  Transform the Footprints of sourceCat into targetCat as above, and then, if keepHeavy is true,
+     *  replace the resampled HeavyFootprints of each family's children with HeavyFootprints of the
+     *  target image's pixels, each weighted by the child's share of the (positive) resampled source
+     *  pixels of all the children.  Families in which any child's Footprint couldn't be resampled get
+     *  regular Footprints for all their children.
+     *
+     *  @param[in]     sourceCat  Catalog with Footprints in the source pixel coordinate system; its
+     *                            parent IDs define the families.
+     *  @param[in,out] targetCat  Catalog whose records correspond to those of sourceCat.
+     *  @param[in]     image      Target image the children's pixels are taken from; it must contain
+     *                            the transformer's region.
+     *
+     *  @throws pex::exceptions::LengthError if the catalogs do not have the same size.
+     */
+    void transformCatalog(
+        afw::table::SourceCatalog const & sourceCat,
+        afw::table::SourceCatalog & targetCat,
+        afw::image::MaskedImage<float> const & image
+    ) const;
+
+private:
+    CONST_PTR(afw::image::Wcs) _source;
+    CONST_PTR(afw::image::Wcs) _target;
+    afw::geom::Box2I _region;
+    double _maxError;
+    bool _keepHeavy;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_FootprintTransformer_h_INCLUDED
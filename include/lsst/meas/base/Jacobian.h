@@ -0,0 +1,89 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_Jacobian_h_INCLUDED
+#define LSST_MEAS_BASE_Jacobian_h_INCLUDED
+
+#include "lsst/pex/config.h"
+#include "lsst/afw/image/Exposure.h"
+#include "lsst/meas/base/Algorithm.h"
+#include "lsst/meas/base/FlagHandler.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  @brief A C++ control class to handle JacobianAlgorithm's configuration
+ */
+class JacobianControl {
+public:
+
+    LSST_CONTROL_FIELD(pixelScale, double, "Nominal pixel size (arcsec)");
+    LSST_CONTROL_FIELD(wcsGridCellSize, double,
+                       "Size (pixels) of the cells within which the Wcs is linearized once per exposure");
+    LSST_CONTROL_FIELD(wcsGridTolerance, double,
+                       "Largest on-sky error (arcsec) allowed for a cell's linearized Wcs before falling "
+                       "back to the full Wcs; <= 0 always uses the full Wcs");
+
+    JacobianControl() : pixelScale(0.5), wcsGridCellSize(64.0), wcsGridTolerance(0.0) {}
+};
+
+/**
+ *  @brief Compute the Jacobian of the Wcs at a source, relative to the area of a nominal pixel
+ *
+ *  This allows one to compare relative instead of absolute areas of pixels.  The Wcs is linearized
+ *  through an AffineWcsGrid shared with the other algorithms measuring the same exposure.
+ */
+class JacobianAlgorithm : public SimpleAlgorithm {
+public:
+
+    enum {
+        FAILURE=FlagHandler::FAILURE,
+        N_FLAGS
+    };
+
+    /// A typedef to the Control object for this algorithm, defined above.
+    /// The control object contains the configuration parameters for this algorithm.
+    typedef JacobianControl Control;
+
+    JacobianAlgorithm(Control const & ctrl, std::string const & name, afw::table::Schema & schema);
+
+    virtual void measure(
+        afw::table::SourceRecord & measRecord,
+        afw::image::Exposure<float> const & exposure
+    ) const;
+
+    virtual void fail(
+        afw::table::SourceRecord & measRecord,
+        MeasurementError * error=NULL
+    ) const;
+
+private:
+    Control _ctrl;
+    afw::table::Key<double> _valueKey;
+    FlagHandler _flagHandler;
+    double _scale;  ///< one over the area of a nominal pixel, in radians^-2
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_Jacobian_h_INCLUDED
@@ -53,14 +53,25 @@ namespace lsst { namespace meas { namespace base {
  *   a sinc interpolation (via a warping kernel) we can evaluate this function at any point.
  *   We use this technique to compute the peak of the function, which is assumed to be
  *   at the centroid of the filtered source.
+ * * If warpingShiftSteps > 0, the warping kernel is tabulated on that many shifts per half pixel and
+ *   interpolated linearly, rather than evaluated at every source.  With 256 steps the interpolated
+ *   lanczos4 taps are within about 2e-6 of the exact ones, which changes the fluxes of well-sampled
+ *   sources by up to about 1e-6 (relative).
  */
 class PeakLikelihoodFluxControl {
 public:
 
     LSST_CONTROL_FIELD(warpingKernelName, std::string,
         "Name of warping kernel (e.g. \"lanczos4\") used to compute the peak");
-
-    PeakLikelihoodFluxControl() : warpingKernelName("lanczos4") {}
+    LSST_CONTROL_FIELD(warpingShiftSteps, int,
+        "Number of shifts per half pixel on which the warping kernel is tabulated and interpolated; "
+        "<= 0 evaluates it exactly at every source");
+    LSST_CONTROL_FIELD(psfAreaCacheTileSize, int,
+        "Size (pixels) of the cells within which the PSF effective area is cached and treated as "
+        "constant; <= 0 computes it at every source");
+
+    PeakLikelihoodFluxControl() :
+        warpingKernelName("lanczos4"), warpingShiftSteps(0), psfAreaCacheTileSize(0) {}
 };
 
 
@@ -94,10 +105,32 @@ public:
 
 private:
 
+    /// Normalized 1-D taps of the separable warping kernel, optionally tabulated on a grid of shifts
+    struct WarpingTaps {
+        std::string name;
+        int shiftSteps;          ///< grid steps per half pixel; if <= 0, nothing is tabulated
+        int width;
+        int height;
+        afw::geom::Point2I ctr;  ///< kernel center for non-negative shifts; one more for negative shifts
+        std::vector<double> x;   ///< x taps, indexed by [shift < 0][grid step][tap]
+        std::vector<double> y;   ///< y taps, indexed by [shift < 0][grid step][tap]
+
+        WarpingTaps(std::string const & warpingKernelName, int shiftSteps);
+
+        /// Compute (or interpolate) the taps for a shift in [-0.5, 0.5] in each dimension; returns the
+        /// kernel center.
+        afw::geom::Extent2I compute(afw::geom::Point2D const & fracShift,
+                                    double * xTaps, double * yTaps) const;
+
+        /// Interpolate the taps for a shift in [-0.5, 0.5]; returns the offset to add to the center.
+        int interpolate(std::vector<double> const & table, int size, double fracShift, double * taps) const;
+    };
+
     Control _ctrl;
     FluxResultKey _fluxResultKey;
     FlagHandler _flagHandler;
     SafeCentroidExtractor _centroidExtractor;
+    WarpingTaps _warpingTaps;
 };
 
 class PeakLikelihoodFluxTransform : public FluxTransform {
@@ -80,10 +80,18 @@ public:
 
     typedef std::map<std::string, afw::table::Key<afw::table::Flag>> KeyMap;
 
+    /// A flag field set when any bit of a mask plane is set in the pixels it summarizes
+    struct MaskFlag {
+        std::string plane;
+        afw::image::MaskPixel bits;  ///< plane bitmask, or 0 if the plane wasn't defined at construction
+        afw::table::Key<afw::table::Flag> key;
+    };
+
 private:
     Control _ctrl;
-    KeyMap _centerKeys;
-    KeyMap _anyKeys;
+    std::vector<MaskFlag> _centerFlags;
+    std::vector<MaskFlag> _anyFlags;
+    afw::table::Key<afw::table::Flag> _edgeKey;
     afw::table::Key<afw::table::Flag> _generalFailureKey;
     afw::table::Key<afw::table::Flag> _offImageKey;
 };
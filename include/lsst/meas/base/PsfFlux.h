@@ -48,13 +48,19 @@ public:
 
     LSST_CONTROL_FIELD(badMaskPlanes, std::vector<std::string>,
                        "Mask planes that indicate pixels that should be excluded from the fit");
+    LSST_CONTROL_FIELD(psfCacheTileSize, int,
+                       "Size (pixels) of the cells within which the PSF model image is cached and treated as "
+                       "constant; <= 0 realises the PSF model at every source");
+    LSST_CONTROL_FIELD(psfCachePhaseSteps, int,
+                       "Number of quantised sub-pixel phases (per pixel, per dimension) for which cached "
+                       "PSF model images are realised");
 
     /**
      *  @brief Default constructor
      *
      *  All control classes should define a default constructor that sets all fields to their default values.
      */
-    PsfFluxControl() {}
+    PsfFluxControl() : psfCacheTileSize(0), psfCachePhaseSteps(10) {}
 };
 
 /**
@@ -86,6 +92,22 @@ public:
         afw::image::Exposure<float> const & exposure
     ) const;
 
+    /**
+     *  @brief Simultaneously fit the PSF fluxes of all the sources in a blend family
+     *
+     *  The PSF models of all the children are fit jointly by linear least squares over the union of
+     *  their model boxes (on the full image, with all the family's pixels present), so overlapping
+     *  neighbours share their flux rather than each absorbing it.  For a single isolated source this
+     *  is identical to measure().
+     *
+     *  The results overwrite those from measure(), flags included; a child whose centroid or PSF model
+     *  can't be obtained is failed individually and left out of the fit.
+     */
+    virtual void measureN(
+        afw::table::SourceCatalog const & measCat,
+        afw::image::Exposure<float> const & exposure
+    ) const;
+
     virtual void fail(
         afw::table::SourceRecord & measRecord,
         MeasurementError * error=NULL
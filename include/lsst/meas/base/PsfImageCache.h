@@ -0,0 +1,136 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_PsfImageCache_h_INCLUDED
+#define LSST_MEAS_BASE_PsfImageCache_h_INCLUDED
+
+#include <array>
+#include <list>
+#include <map>
+#include <memory>
+
+#include "lsst/afw/geom/Point.h"
+#include "lsst/afw/detection/Psf.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  A cache of PSF model images, realised on a grid of positions and quantised sub-pixel phases.
+ *
+ *  Realising a PSF model image (for CoaddPsf or PcaPsf, a full kernel realisation and a sub-pixel shift)
+ *  can easily cost more than the measurement that uses it.  Within a tileSize x tileSize cell of the
+ *  image, PsfImageCache instead treats the PSF model as constant, and realises it only once for each
+ *  sub-pixel phase, with the phase quantised to 1/phaseSteps of a pixel.  Those two parameters set how
+ *  stale a cached image is allowed to be, and are chosen by each caller; images cached for different
+ *  parameters are stored separately.
+ *
+ *  Images are only valid for the Psf they were realised from: the cache is flushed whenever it is asked
+ *  about a different Psf, which usually means a new exposure.  The cache does not keep that Psf alive.
+ *  The total number of cached pixels is capped, with the least recently used images evicted first.
+ *
+ *  PsfImageCache is not thread-safe; the measurement algorithms share a per-thread instance, obtained
+ *  from getThreadCache().
+ */
+class PsfImageCache {
+public:
+
+    typedef afw::detection::Psf::Image Image;
+
+    /// Default maximum number of cached pixels (32MB of double-precision images).
+    static std::size_t const DEFAULT_MAX_PIXELS = 1 << 22;
+
+    explicit PsfImageCache(std::size_t maxPixels=DEFAULT_MAX_PIXELS);
+
+    /// Return the cache shared by all of the measurement algorithms run in the calling thread.
+    static PsfImageCache & getThreadCache();
+
+    /**
+     *  Return an image of the PSF model, centred on the given position, as Psf::computeImage would.
+     *
+     *  @param[in] psf        Psf model to realise.
+     *  @param[in] position   Position (in parent pixel coordinates) to centre the image on.
+     *  @param[in] tileSize   Size (pixels) of the grid cells within which the PSF model is treated as
+     *                        constant.  If <= 0, the image is computed exactly, without the cache.
+     *  @param[in] phaseSteps Number of sub-pixel phases per pixel in each dimension.  Phases are
+     *                        always within half a pixel of the pixel Psf::computeImage would centre the
+     *                        image on, so the image always has the same bbox; with an even phaseSteps,
+     *                        that means residuals just short of +0.5 pixel are rounded down a step.
+     *
+     *  The returned image shares its pixels with the cache, and must not be modified.
+     */
+    CONST_PTR(Image) computeImage(
+        CONST_PTR(afw::detection::Psf) const & psf,
+        afw::geom::Point2D const & position,
+        int tileSize,
+        int phaseSteps
+    );
+
+    /// Remove all cached images (but do not reset the counters).
+    void clear();
+
+    /// Maximum number of pixels in all cached images; exceeding this evicts the least recently used.
+    std::size_t getMaxPixels() const { return _maxPixels; }
+    void setMaxPixels(std::size_t maxPixels);
+
+    /// Number of images currently cached.
+    std::size_t getSize() const { return _entries.size(); }
+
+    /// Number of pixels in all currently cached images.
+    std::size_t getPixelCount() const { return _pixelCount; }
+
+    /// Number of cached images reused, new images realised, and images evicted, since the last reset.
+    std::size_t getHitCount() const { return _hitCount; }
+    std::size_t getMissCount() const { return _missCount; }
+    std::size_t getEvictionCount() const { return _evictionCount; }
+
+    /// Reset the hit, miss and eviction counts to zero.
+    void resetCounts();
+
+private:
+
+    typedef std::array<int, 6> Key;     // tileSize, phaseSteps, tile x, tile y, phase x, phase y
+
+    struct Entry {
+        Key key;
+        afw::geom::Point2I anchor;      // the integer pixel the image was realised relative to
+        PTR(Image) image;
+    };
+
+    typedef std::list<Entry> EntryList; // most recently used first
+    typedef std::map<Key, EntryList::iterator> EntryMap;
+
+    void _evict();
+
+    std::weak_ptr<afw::detection::Psf const> _psf;
+    std::size_t _maxPixels;
+    std::size_t _pixelCount;
+    std::size_t _hitCount;
+    std::size_t _missCount;
+    std::size_t _evictionCount;
+    EntryList _entries;
+    EntryMap _index;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_PsfImageCache_h_INCLUDED
@@ -0,0 +1,172 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_ScratchArena_h_INCLUDED
+#define LSST_MEAS_BASE_ScratchArena_h_INCLUDED
+
+#include <memory>
+#include <vector>
+
+#include "ndarray.h"
+#include "lsst/afw/geom/Box.h"
+#include "lsst/afw/image/Image.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  A bump allocator for the short-lived images and buffers the algorithms need while measuring a source.
+ *
+ *  Allocating a temporary image from the heap for every source is cheap on its own, but when several
+ *  threads measure at once they all contend for the allocator.  ScratchArena hands out memory from a
+ *  few large blocks instead, simply by advancing an offset into the current block; nothing is freed
+ *  individually.  The measurement driver calls reset() on each thread's arena when it's done with a
+ *  family, which makes all of that memory available again.  If a family needed more than one block,
+ *  reset() replaces them with a single block big enough for all of them, so after the first few
+ *  families the arena itself no longer touches the heap.
+ *
+ *  That doesn't make measuring a source allocation-free: only the buffers algorithms take from the
+ *  arena avoid the heap.  SdssCentroid takes its kernel and binned pixels from the arena, but still
+ *  allocates in Psf::getLocalKernel for every kernel it realises (by default, one per source), and the
+ *  sinc aperture path still allocates in afw::math::offsetImage and for the coefficient images it caches.
+ *
+ *  Algorithms that want their memory back sooner can use a ScratchScope, which rewinds the arena to
+ *  where it was when the scope was created.
+ *
+ *  Images and arrays from the arena don't own their pixels: they must not be used after the arena is
+ *  reset (or their scope ends), and so must never be stored in a cache or returned to the caller.
+ *  Pixels are not initialized.
+ *
+ *  ScratchArena is not thread-safe; the measurement algorithms share a per-thread instance, obtained
+ *  from getThreadArena().
+ */
+class ScratchArena {
+public:
+
+    /// Default size (bytes) of the blocks the arena allocates from the heap.
+    static std::size_t const DEFAULT_BLOCK_SIZE = 1 << 22;
+
+    /// Alignment (bytes) of every allocation.
+    static std::size_t const ALIGNMENT = 32;
+
+    explicit ScratchArena(std::size_t blockSize=DEFAULT_BLOCK_SIZE);
+
+    ScratchArena(ScratchArena const &) = delete;
+    ScratchArena & operator=(ScratchArena const &) = delete;
+
+    /// Return the arena shared by all of the measurement algorithms run in the calling thread.
+    static ScratchArena & getThreadArena();
+
+    /// Return a pointer to at least the given number of uninitialized, aligned bytes.
+    void * allocate(std::size_t bytes);
+
+    /// Return an uninitialized 2-d array with the given dimensions (width, height).
+    template <typename T>
+    ndarray::Array<T,2,2> makeArray(afw::geom::Extent2I const & dimensions) {
+        T * data = static_cast<T*>(allocate(sizeof(T)*dimensions.getX()*dimensions.getY()));
+        return ndarray::external(data, ndarray::makeVector(dimensions.getY(), dimensions.getX()),
+                                 ndarray::makeVector(dimensions.getX(), 1));
+    }
+
+    /// Return an uninitialized image covering the given box (in parent pixel coordinates).
+    template <typename PixelT>
+    afw::image::Image<PixelT> makeImage(afw::geom::Box2I const & bbox) {
+        return afw::image::Image<PixelT>(makeArray<PixelT>(bbox.getDimensions()), false, bbox.getMin());
+    }
+
+    /**
+     *  Make all of the arena's memory available again, invalidating everything allocated from it.
+     *
+     *  Must not be called while an algorithm is still using the arena; the measurement drivers call it
+     *  between families.
+     */
+    void reset();
+
+    /// Size (bytes) of the blocks the arena allocates from the heap, unless a larger one is needed.
+    std::size_t getBlockSize() const { return _blockSize; }
+
+    /// Number of bytes allocated since the last reset.
+    std::size_t getBytesInUse() const { return _bytesInUse; }
+
+    /// Largest number of bytes that has been in use at once.
+    std::size_t getHighWaterMark() const { return _highWaterMark; }
+
+    /// Total size (bytes) of all of the arena's blocks.
+    std::size_t getCapacity() const;
+
+    /// Number of blocks the arena currently holds.
+    std::size_t getBlockCount() const { return _blocks.size(); }
+
+    /// Number of blocks the arena has ever allocated from the heap.
+    std::size_t getHeapAllocationCount() const { return _heapAllocationCount; }
+
+private:
+
+    friend class ScratchScope;
+
+    struct Block {
+        explicit Block(std::size_t size_);
+
+        std::unique_ptr<char[]> storage;
+        char * data;                    // start of the usable (aligned) part of storage
+        std::size_t size;               // usable size
+    };
+
+    std::size_t _blockSize;
+    std::size_t _current;               // index of the block we're allocating from
+    std::size_t _offset;                // offset of the next allocation in the current block
+    std::size_t _bytesInUse;
+    std::size_t _highWaterMark;
+    std::size_t _heapAllocationCount;
+    std::size_t _resetCount;            // lets a ScratchScope tell whether it's been reset under it
+    std::vector<Block> _blocks;
+};
+
+/**
+ *  Rewind a ScratchArena to where it was when the scope was created, when the scope ends.
+ *
+ *  This should logically be an inner class of ScratchArena, but Swig doesn't know how to parse those.
+ */
+class ScratchScope {
+public:
+
+    explicit ScratchScope(ScratchArena & arena=ScratchArena::getThreadArena());
+
+    ScratchScope(ScratchScope const &) = delete;
+    ScratchScope & operator=(ScratchScope const &) = delete;
+
+    ~ScratchScope();
+
+    /// Return the arena this scope rewinds.
+    ScratchArena & getArena() const { return _arena; }
+
+private:
+    ScratchArena & _arena;
+    std::size_t _current;
+    std::size_t _offset;
+    std::size_t _bytesInUse;
+    std::size_t _resetCount;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_ScratchArena_h_INCLUDED
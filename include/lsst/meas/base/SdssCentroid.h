@@ -53,13 +53,27 @@ public:
                        "Do check that the centroid is contained in footprint.");
     LSST_CONTROL_FIELD(maxDistToPeak, double,
                        "If set > 0, Centroid Check also checks distance from footprint peak.");
+    LSST_CONTROL_FIELD(kernelCacheCellSize, int,
+                       "Size (pixels) of the grid cells on which local PSF kernels are cached and reused; "
+                       "if <= 0, the kernel is realised at each source's peak pixel, without caching");
+    LSST_CONTROL_FIELD(kernelCacheMaxPixels, int,
+                       "Largest total number of kernel pixels cached per thread; the least recently used "
+                       "kernels are evicted beyond this");
+    LSST_CONTROL_FIELD(wcsGridCellSize, double,
+                       "Size (pixels) of the grid cells on which the Wcs is linearized when transforming "
+                       "outputs to celestial coordinates");
+    LSST_CONTROL_FIELD(wcsGridTolerance, double,
+                       "Largest on-sky error (arcsec) allowed for the gridded Wcs approximation at the cell "
+                       "corners; if 0, the full Wcs is evaluated at every source");
     /**
      *  @brief Default constructor
      *
      *  All control classes should define a default constructor that sets all fields to their default values.
      */
 
-    SdssCentroidControl() : binmax(16), peakMin(-1.0), wfac(1.5), doFootprintCheck(true), maxDistToPeak(-1.0) {}
+    SdssCentroidControl() : binmax(16), peakMin(-1.0), wfac(1.5), doFootprintCheck(true), maxDistToPeak(-1.0),
+                            kernelCacheCellSize(0), kernelCacheMaxPixels(1 << 18),
+                            wcsGridCellSize(64.0), wcsGridTolerance(0.0) {}
 };
 
 /**
@@ -55,10 +55,16 @@ public:
     LSST_CONTROL_FIELD(tol1, float, "Convergence tolerance for e1,e2");
     LSST_CONTROL_FIELD(tol2, float, "Convergence tolerance for FWHM");
     LSST_CONTROL_FIELD(doMeasurePsf, bool, "Whether to also compute the shape of the PSF model");
+    LSST_CONTROL_FIELD(wcsGridCellSize, double,
+                       "Size (pixels) of the grid cells on which the Wcs is linearized when transforming "
+                       "outputs to celestial coordinates");
+    LSST_CONTROL_FIELD(wcsGridTolerance, double,
+                       "Largest on-sky error (arcsec) allowed for the gridded Wcs approximation at the cell "
+                       "corners; if 0, the full Wcs is evaluated at every source");
 
     /// @copydoc SdssShapeControl::SdssShapeControl
     SdssShapeControl() : background(0.0), maxIter(100), maxShift(), tol1(1E-5), tol2(1E-4),
-                         doMeasurePsf(true) {}
+                         doMeasurePsf(true), wcsGridCellSize(64.0), wcsGridTolerance(0.0) {}
 };
 
 /**
@@ -280,6 +286,9 @@ public:
 private:
     FluxTransform _fluxTransform;
     CentroidTransform _centroidTransform;
+    CentroidResultKey _centroidKey;
+    ShapeResultKey _inShapeKey;
+    afw::table::QuadrupoleKey _inPsfShapeKey;
     ShapeResultKey _outShapeKey;
     afw::table::QuadrupoleKey _outPsfShapeKey;
     bool _transformPsf;
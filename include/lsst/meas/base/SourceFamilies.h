@@ -0,0 +1,75 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_SourceFamilies_h_INCLUDED
+#define LSST_MEAS_BASE_SourceFamilies_h_INCLUDED
+
+#include <vector>
+
+#include "lsst/afw/table/Source.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  The parent/child structure of a SourceCatalog, built once in O(N log N).
+ *
+ *  Records are referred to by their indices in the catalog, which need not be sorted.  The
+ *  constructor checks that the parent chain of every record leads to a record with no parent
+ *  without leaving the catalog, which is required by the NoiseReplacer.
+ */
+class SourceFamilies {
+public:
+
+    /**
+     *  Build the family structure of a catalog.
+     *
+     *  @throws pex::exceptions::RuntimeError if a record's parent chain includes a record that is
+     *          not in the catalog (or is circular).
+     */
+    explicit SourceFamilies(afw::table::SourceCatalog const & catalog);
+
+    /// Return the indices of the records with no parent, in catalog order.
+    std::vector<std::size_t> const & getParentIndices() const { return _parents; }
+
+    /// Return the indices of the direct children of the record at the given index, in catalog order.
+    std::vector<std::size_t> getChildIndices(std::size_t index) const {
+        return std::vector<std::size_t>(_children.begin() + _childOffsets[index],
+                                        _children.begin() + _childOffsets[index + 1]);
+    }
+
+    /// Return the index of the parent of the record at the given index, or -1 if it has no parent.
+    long getParentIndex(std::size_t index) const { return _parentIndex[index]; }
+
+    /// Return the number of records.
+    std::size_t size() const { return _parentIndex.size(); }
+
+private:
+    std::vector<long> _parentIndex;
+    std::vector<std::size_t> _parents;
+    std::vector<std::size_t> _childOffsets;
+    std::vector<std::size_t> _children;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_SourceFamilies_h_INCLUDED
@@ -70,11 +70,18 @@ namespace lsst { namespace meas { namespace base {
  *  @skip operator()
  *  @until // operator()
  *
- *  Note that it is safe to assume that both catalogs passed to `operator()`
- *  are contiguous in memory. It is good practice to ensure that they are
+ *  The catalogs passed to `operator()` are usually, but not necessarily,
+ *  contiguous in memory. It is good practice to ensure that they are
  *  equal in size: this may be conveniently achieved by calling
  *  `BaseTransform::checkCatalogSize()`.
  *
+ *  Transformations are run over entire catalogs, so keys should be looked up
+ *  in the SchemaMapper's input schema once, at construction, rather than on
+ *  every call, and columns should be processed as arrays through the
+ *  catalogs' `getColumnView()` where possible, falling back to visiting the
+ *  records when a catalog isn't contiguous (see, for example,
+ *  `transformFluxColumns()`).
+ *
  *  `operator()` may throw `LengthError` if the transformation is impossible
  *  to complete. In this case, the contents of `outputCatalog` is not
  *  guaranteed.
@@ -0,0 +1,92 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_BASE_Variance_h_INCLUDED
+#define LSST_MEAS_BASE_Variance_h_INCLUDED
+
+#include <vector>
+
+#include "lsst/pex/config.h"
+#include "lsst/afw/image/Exposure.h"
+#include "lsst/meas/base/Algorithm.h"
+#include "lsst/meas/base/FlagHandler.h"
+
+namespace lsst { namespace meas { namespace base {
+
+/**
+ *  @brief A C++ control class to handle VarianceAlgorithm's configuration
+ */
+class VarianceControl {
+public:
+
+    LSST_CONTROL_FIELD(scale, double, "Scale factor to apply to shape for aperture");
+    LSST_CONTROL_FIELD(mask, std::vector<std::string>, "Mask planes to ignore");
+
+    VarianceControl() : scale(5.0), mask({"DETECTED", "DETECTED_NEGATIVE", "BAD", "SAT"}) {}
+};
+
+/**
+ *  @brief Compute the median variance within a Footprint scaled from the object shape
+ *
+ *  The aperture is large enough that the value is not terribly influenced by the object and instead
+ *  represents the variance in the background near the object.  Pixels with any of the configured mask
+ *  planes set are ignored.  The median is found with a partial sort of the surviving pixels, read
+ *  directly from the variance plane span by span, without making a HeavyFootprint copy.
+ */
+class VarianceAlgorithm : public SimpleAlgorithm {
+public:
+
+    enum {
+        FAILURE=FlagHandler::FAILURE,
+        EMPTY_FOOTPRINT,
+        N_FLAGS,
+        /// Not a field of its own: reported through the "<name>_flag_badCentroid" alias to the
+        /// slot centroid's flag, along with the general failure flag.
+        BAD_CENTROID=N_FLAGS
+    };
+
+    /// A typedef to the Control object for this algorithm, defined above.
+    /// The control object contains the configuration parameters for this algorithm.
+    typedef VarianceControl Control;
+
+    VarianceAlgorithm(Control const & ctrl, std::string const & name, afw::table::Schema & schema);
+
+    virtual void measure(
+        afw::table::SourceRecord & measRecord,
+        afw::image::Exposure<float> const & exposure
+    ) const;
+
+    virtual void fail(
+        afw::table::SourceRecord & measRecord,
+        MeasurementError * error=NULL
+    ) const;
+
+private:
+    Control _ctrl;
+    afw::table::Key<double> _valueKey;
+    FlagHandler _flagHandler;
+};
+
+}}} // namespace lsst::meas::base
+
+#endif // !LSST_MEAS_BASE_Variance_h_INCLUDED
@@ -1,5 +1,7 @@
 from collections import namedtuple
 
+import numpy
+
 import lsst.pipe.base
 import lsst.pex.config
 import lsst.daf.base
@@ -31,6 +33,9 @@ class AfterburnerPlugin(BasePlugin):
     # The value defaults to single for a single source, set to multi when the plugin expects the whole
     # catalog. If The plugin is of type multi, the fail method should be implemented to accept the whole
     # catalog. If the plugin is of type the fail method should accept a single source record.
+    # Plugins of type catalog implement burnCatalog, which works on the columns of a whole (contiguous)
+    # catalog at once, as well as burn for a single source record, which is used for catalogs that
+    # are not contiguous; their fail method accepts a single source record.
 
     plugType = 'single'
 
@@ -67,6 +72,21 @@ class AfterburnerPlugin(BasePlugin):
         """
         raise NotImplementedError()
 
+    def burnCatalog(self, cat, **kwargs):
+        """!
+        Process a whole contiguous catalog at once, working on its columns as numpy arrays
+
+        Only called for plugins with plugType 'catalog'.  Rather than raising for the rows it cannot
+        process, the plugin returns a mask of them, and the afterburner task calls fail on each of them.
+
+        @param[in,out] cat  A contiguous lsst source catalog. Results should be written through the
+                            arrays returned by cat.getColumnView().
+        @param[in] kwargs   Any additional kwargs that may be passed through the afterburner task.
+
+        @return a boolean numpy array, True for the rows of cat on which the plugin failed
+        """
+        raise NotImplementedError()
+
 
 class AbContext(object):
     '''
@@ -141,14 +161,14 @@ class AfterburnerTask(lsst.pipe.base.Task):
         Initialize the plugins according to the configuration.
         '''
 
-        pluginType = namedtuple('pluginType', 'single multi')
+        pluginType = namedtuple('pluginType', 'single multi catalog')
         self.executionDict = {}
         # Read the properties for each plugin. Allocate a dictionary entry for each run level. Verify that
         # the plugins are above the minimum run level for an afterburner plugin. For each run level, the
         # plugins are sorted into either single record, or multi record groups to later be run appropriately
         for executionOrder, name, config, PluginClass in self.config.plugins.apply():
             if executionOrder not in self.executionDict:
-                self.executionDict[executionOrder] = pluginType(single=[], multi=[])
+                self.executionDict[executionOrder] = pluginType(single=[], multi=[], catalog=[])
             if PluginClass.getExecutionOrder() >= BasePlugin.DEFAULT_AFTERBURNER:
                 plug = PluginClass(config, name, self.schema, metadata=self.plugMetadata)
                 self.plugins[name] = plug
@@ -156,6 +176,8 @@ class AfterburnerTask(lsst.pipe.base.Task):
                     self.executionDict[executionOrder].single.append(plug)
                 elif plug.plugType == 'multi':
                     self.executionDict[executionOrder].multi.append(plug)
+                elif plug.plugType == 'catalog':
+                    self.executionDict[executionOrder].catalog.append(plug)
             else:
                 raise ValueError("{} has an execution order less than the minimum for an afterburner plugin."
                                  "Value {} : Minimum {}".format(PluginClass, PluginClass.getExecutionOrder(),
@@ -173,13 +195,42 @@ class AfterburnerTask(lsst.pipe.base.Task):
         Run each of the plugins on the catalog
         @param[in] catalog  The catalog on which the plugins will operate
         '''
+        contiguous = catalog.isContiguous()
         for runlevel in sorted(self.executionDict):
             # Run all of the plugins which take a whole catalog first
             for plug in self.executionDict[runlevel].multi:
                 with AbContext(plug, catalog, self.log):
                     plug.burn(catalog)
+            singlePlugins = list(self.executionDict[runlevel].single)
+            if contiguous:
+                for plug in self.executionDict[runlevel].catalog:
+                    self.callBurnCatalog(plug, catalog)
+            else:
+                singlePlugins += self.executionDict[runlevel].catalog
             # Run all the plugins which take single catalog entries
+            if singlePlugins:
+                for measRecord in catalog:
+                    for plug in singlePlugins:
+                        with AbContext(plug, measRecord, self.log):
+                            plug.burn(measRecord)
+
+    def callBurnCatalog(self, plug, catalog):
+        '''
+        Run a plugin of type catalog on the columns of a whole catalog, and call its fail method on the
+        rows it could not process.  If the plugin raises MeasurementError, every row is failed.
+        @param[in] plug     The plugin to run
+        @param[in] catalog  The contiguous catalog on which the plugin will operate
+        '''
+        try:
+            failed = plug.burnCatalog(catalog)
+        except FATAL_EXCEPTIONS:
+            raise
+        except MeasurementError as error:
             for measRecord in catalog:
-                for plug in self.executionDict[runlevel].single:
-                    with AbContext(plug, measRecord, self.log):
-                        plug.burn(measRecord)
+                plug.fail(measRecord, error)
+            return
+        except Exception as error:
+            self.log.warn("Error in {}.burnCatalog: {}".format(plug.name, error))
+            return
+        for i in numpy.flatnonzero(failed):
+            plug.fail(catalog[int(i)])
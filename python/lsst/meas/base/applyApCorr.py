@@ -20,8 +20,6 @@ from __future__ import absolute_import, division
 # the GNU General Public License along with this program.  If not,
 # see <http://www.lsstcorp.org/LegalNotices/>.
 #
-import math
-
 import numpy
 
 import lsst.pex.config
@@ -29,6 +27,7 @@ import lsst.pex.exceptions
 import lsst.afw.image
 import lsst.pipe.base
 from .apCorrRegistry import getApCorrNameSet
+from .baseLib import ApCorrApplier
 
 # If True then scale flux sigma by apCorr; if False then use a more complex computation
 # that over-estimates flux error (often grossly so) because it double-counts photon noise.
@@ -65,6 +64,7 @@ class ApCorrInfo(object):
         - apCorrKey: key to new aperture correction field
         - apCorrSigmaKey: key to new aperture correction sigma field
         - apCorrFlagKey: key to new aperture correction flag field
+        - applier: ApCorrApplier that corrects the flux over a whole catalog
         """
         self.name = name
         self.fluxName = name + "_flux"
@@ -87,6 +87,7 @@ class ApCorrInfo(object):
             doc = "set if unable to aperture correct %s" % (name,),
             type = "Flag",
         )
+        self.applier = ApCorrApplier(schema, name)
 
 class ApplyApCorrConfig(lsst.pex.config.Config):
     ignoreList = lsst.pex.config.ListField(
@@ -150,50 +151,20 @@ class ApplyApCorrTask(lsst.pipe.base.Task):
                 missingNames = [(apCorrInfo.fluxName, apCorrInfo.fluxSigmaName)[i]
                     for i, model in enumerate((apCorrModel, apCorrSigmaModel)) if model is None]
                 self.log.warn("Could not find %s in apCorrMap" % (" or ".join(missingNames),))
-                for source in catalog:
-                    source.set(apCorrInfo.apCorrFlagKey, True)
+                apCorrInfo.applier.flagAll(catalog)
                 continue
 
-            for source in catalog:
-                center = source.getCentroid()
-                # say we've failed when we start; we'll unset these flags when we succeed
-                source.set(apCorrInfo.apCorrFlagKey, True)
-                oldFluxFlagState = False
-                if self.config.doFlagApCorrFailures:
-                    oldFluxFlagState = source.get(apCorrInfo.fluxFlagKey)
-                    source.set(apCorrInfo.fluxFlagKey, True)
-
-                apCorr = 1.0
-                apCorrSigma = 0.0
-                try:
-                    apCorr = apCorrModel.evaluate(center)
-                    if not UseNaiveFluxSigma:
-                        apCorrSigma = apCorrSigmaModel.evaluate(center)
-                except lsst.pex.exceptions.DomainError:
-                    continue
-
-                source.set(apCorrInfo.apCorrKey, apCorr)
-                source.set(apCorrInfo.apCorrSigmaKey, apCorrSigma)
-                if apCorr <= 0.0 or apCorrSigma < 0.0:
-                    continue
-
-                flux = source.get(apCorrInfo.fluxKey)
-                fluxSigma = source.get(apCorrInfo.fluxSigmaKey)
-                source.set(apCorrInfo.fluxKey, flux*apCorr)
-                if UseNaiveFluxSigma:
-                    source.set(apCorrInfo.fluxSigmaKey, fluxSigma*apCorr)
-                else:
-                    a = fluxSigma/flux
-                    b = apCorrSigma/apCorr
-                    source.set(apCorrInfo.fluxSigmaKey, abs(flux*apCorr)*math.sqrt(a*a + b*b))
-                source.set(apCorrInfo.apCorrFlagKey, False)
-                if self.config.doFlagApCorrFailures:
-                    source.set(apCorrInfo.fluxFlagKey, oldFluxFlagState)
+            apCorrInfo.applier.apply(catalog, apCorrModel, apCorrSigmaModel,
+                                     self.config.doFlagApCorrFailures, UseNaiveFluxSigma)
 
             if self.log.getThreshold() <= self.log.DEBUG:
                 # log statistics on the effects of aperture correction
-                apCorrArr = numpy.array([s.get(apCorrInfo.apCorrKey) for s in catalog])
-                apCorrSigmaArr = numpy.array([s.get(apCorrInfo.apCorrSigmaKey) for s in catalog])
+                if catalog.isContiguous():
+                    apCorrArr = catalog.get(apCorrInfo.apCorrKey)
+                    apCorrSigmaArr = catalog.get(apCorrInfo.apCorrSigmaKey)
+                else:
+                    apCorrArr = numpy.array([s.get(apCorrInfo.apCorrKey) for s in catalog])
+                    apCorrSigmaArr = numpy.array([s.get(apCorrInfo.apCorrSigmaKey) for s in catalog])
                 self.log.logdebug("For flux field %r: mean apCorr=%s, stdDev apCorr=%s,"
                     " mean apCorrSigma=%s, stdDev apCorrSigma=%s for %s sources" %
                     (apCorrInfo.name, apCorrArr.mean(), apCorrArr.std(),
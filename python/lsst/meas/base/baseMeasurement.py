@@ -27,7 +27,7 @@ import traceback
 import lsst.pipe.base
 import lsst.pex.config
 
-from .pluginRegistry import PluginMap
+from .pluginRegistry import PluginGraph, PluginMap
 from .baseLib import FatalAlgorithmError, MeasurementError
 from .pluginsBase import BasePluginConfig, BasePlugin
 from .noiseReplacer import NoiseReplacerConfig
@@ -121,6 +121,12 @@ class BaseMeasurementConfig(lsst.pex.config.Config):
         doc="configuration that sets how to replace neighboring sources with noise"
         )
 
+    requestedPlugins = lsst.pex.config.ListField(
+        dtype=str, default=None, optional=True,
+        doc="If set, only run these plugins, the slot plugins, and the plugins they depend on; other "
+            "plugins in plugins.names are skipped and add no fields to the schema"
+        )
+
     def validate(self):
         lsst.pex.config.Config.validate(self)
         if self.slots.centroid is not None and self.slots.centroid not in self.plugins.names:
@@ -191,8 +197,13 @@ class BaseMeasurementTask(lsst.pipe.base.Task):
         # actual Plugin).
         if self.config.slots.centroid != None:
             self.plugins[self.config.slots.centroid] = None
-        # Init the plugins, sorted by execution order.  At the same time add to the schema
-        for executionOrder, name, config, PluginClass in sorted(self.config.plugins.apply()):
+        # Init the plugins, sorted by their dependencies and then by execution order.  At the same time
+        # add to the schema
+        graph = PluginGraph(self.config.plugins.apply(), self.config.slots)
+        names = None
+        if self.config.requestedPlugins is not None:
+            names = graph.getRequired(self.config.requestedPlugins)
+        for executionOrder, name, config, PluginClass in graph.sort(names):
             self.plugins[name] = PluginClass(config, name, metadata=self.algMetadata, **kwds)
         # In rare circumstances (usually tests), the centroid slot not be coming from an algorithm,
         # which means we'll have added something we don't want to the plugins map, and we should
@@ -226,7 +237,7 @@ class BaseMeasurementTask(lsst.pipe.base.Task):
             if beginOrder is not None and plugin.getExecutionOrder() < beginOrder:
                 continue
             if endOrder is not None and plugin.getExecutionOrder() >= endOrder:
-                break
+                continue
             try:
                 plugin.measure(measRecord, *args, **kwds)
             except FATAL_EXCEPTIONS:
@@ -269,7 +280,7 @@ class BaseMeasurementTask(lsst.pipe.base.Task):
             if beginOrder is not None and plugin.getExecutionOrder() < beginOrder:
                 continue
             if endOrder is not None and plugin.getExecutionOrder() >= endOrder:
-                break
+                continue
             try:
                 plugin.measureN(measCat, *args, **kwds)
             except FATAL_EXCEPTIONS:
@@ -58,6 +58,7 @@ class AfterburnerClassificationPlugin(AfterburnerPlugin):
     """
 
     ConfigClass = AfterburnerClassificationConfig
+    plugType = 'catalog'
 
     @classmethod
     def getExecutionOrder(cls):
@@ -94,5 +95,24 @@ class AfterburnerClassificationPlugin(AfterburnerPlugin):
         else:
             measRecord.set(self.keyProbability, 0.0 if flux1 < flux2 else 1.0)
 
+    def burnCatalog(self, catalog):
+        table = catalog.getTable()
+        columns = catalog.getColumnView()
+        flux1 = self.config.fluxRatio*columns[table.getModelFluxKey()]
+        if self.config.modelErrFactor != 0:
+            flux1 += self.config.modelErrFactor*columns[table.getModelFluxErrKey()]
+        flux2 = numpy.array(columns[table.getPsfFluxKey()], dtype=float)
+        if not self.config.psfErrFactor == 0:
+            flux2 += self.config.psfErrFactor*columns[table.getPsfFluxErrKey()]
+
+        # The same failure modes as burn: either FluxFlag set, or either calculated flux value NAN
+        failed = numpy.isnan(flux1) | numpy.isnan(flux2)
+        for flagKey in (table.getModelFluxFlagKey(), table.getPsfFluxFlagKey()):
+            if flagKey.isValid():
+                failed |= columns[flagKey]
+        good = numpy.logical_not(failed)
+        columns[self.keyProbability][good] = numpy.where(flux1[good] < flux2[good], 0.0, 1.0)
+        return failed
+
     def fail(self, measRecord, error=None):
         measRecord.set(self.keyFlag, True)
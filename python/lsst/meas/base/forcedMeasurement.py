@@ -49,11 +49,13 @@ ForcedPhotImageTask, ForcedPhotCcdTask, and ForcedPhotCoaddTask.
 
 import lsst.pex.config
 import lsst.pipe.base
+import lsst.afw.table
 
 from .pluginRegistry import PluginRegistry
 from .baseMeasurement import (BaseMeasurementPluginConfig, BaseMeasurementPlugin,
                               BaseMeasurementConfig, BaseMeasurementTask)
 from .noiseReplacer import NoiseReplacer, DummyNoiseReplacer
+from .baseLib import FootprintTransformer, SourceFamilies, ScratchArena
 
 __all__ = ("ForcedPluginConfig", "ForcedPlugin",
            "ForcedMeasurementConfig", "ForcedMeasurementTask")
@@ -163,6 +165,23 @@ class ForcedMeasurementConfig(BaseMeasurementConfig):
         default = "raise",
         )
 
+    footprintTransformMaxError = lsst.pex.config.Field(
+        doc = "Largest error (pixels) allowed for the local linearization of the reference-to-exposure "
+              "pixel mapping used by attachTransformedFootprints; if 0, Footprints are transformed through "
+              "the full Wcs at every pixel",
+        dtype = float,
+        default = 0.0,
+        )
+
+    doKeepHeavyFootprints = lsst.pex.config.Field(
+        doc = "Keep the deblend weights of HeavyFootprints in attachTransformedFootprints, rather than "
+              "degrading them to Footprints: children get HeavyFootprints of the exposure's pixels, weighted "
+              "by their share of the resampled reference pixels (only for Footprints transformed by local "
+              "linearization)",
+        dtype = bool,
+        default = False,
+        )
+
     def setDefaults(self):
         self.slots.centroid = "base_TransformedCentroid"
         self.slots.shape = "base_TransformedShape"
@@ -274,16 +293,9 @@ class ForcedMeasurementTask(BaseMeasurementTask):
         # parent is broken and raises an exception if it occurs.
         #
         # I.e. this code checks that this precondition is satisfied by whatever reference
-        # catalog provider is being paired with it.
-        refCatIdDict = {ref.getId(): ref.getParent() for ref in refCat}
-        for ref in refCat:
-            refId = ref.getId()
-            topId = refId
-            while(topId > 0):
-                if not topId in refCatIdDict.keys():
-                    raise RuntimeError("Reference catalog contains a child for which at least "
-                                       "one parent in its parent chain is not in the catalog.")
-                topId = refCatIdDict[topId]
+        # catalog provider is being paired with it.  SourceFamilies does so while building
+        # the parent/child structure used to loop over the families below.
+        families = SourceFamilies(refCat)
 
         # Construct a footprints dict which looks like
         # {ref.getId(): (ref.getParent(), source.getFootprint())}
@@ -305,13 +317,16 @@ class ForcedMeasurementTask(BaseMeasurementTask):
         else:
             noiseReplacer = DummyNoiseReplacer()
 
-        # Create parent cat which slices both the refCat and measCat (sources)
-        # first, get the reference and source records which have no parent
-        refParentCat, measParentCat = refCat.getChildren(0, measCat)
-        for parentIdx, (refParentRecord, measParentRecord) in enumerate(zip(refParentCat,measParentCat)):
+        # Loop over the families using the structure built above; the catalogs need not be sorted.
+        scratchArena = ScratchArena.getThreadArena()
+        for parentIdx in families.getParentIndices():
+            refParentRecord = refCat[parentIdx]
+            measParentRecord = measCat[parentIdx]
 
             # first process the records which have the current parent as children
-            refChildCat, measChildCat = refCat.getChildren(refParentRecord.getId(), measCat)
+            childIndices = families.getChildIndices(parentIdx)
+            refChildCat = self._makeSubset(refCat, childIndices)
+            measChildCat = self._makeSubset(measCat, childIndices)
             # TODO: skip this loop if there are no plugins configured for single-object mode
             for refChildRecord, measChildRecord in zip(refChildCat, measChildCat):
                 noiseReplacer.insertSource(refChildRecord.getId())
@@ -323,16 +338,28 @@ class ForcedMeasurementTask(BaseMeasurementTask):
             noiseReplacer.insertSource(refParentRecord.getId())
             self.callMeasure(measParentRecord, exposure, refParentRecord, refWcs,
                     beginOrder=beginOrder, endOrder=endOrder)
-            self.callMeasureN(measParentCat[parentIdx:parentIdx+1], exposure,
-                    refParentCat[parentIdx:parentIdx+1],
+            self.callMeasureN(measCat[parentIdx:parentIdx+1], exposure,
+                    refCat[parentIdx:parentIdx+1],
                     beginOrder=beginOrder, endOrder=endOrder)
             # measure all the children simultaneously
             self.callMeasureN(measChildCat, exposure, refChildCat,
                     beginOrder=beginOrder, endOrder=endOrder)
             noiseReplacer.removeSource(refParentRecord.getId())
+            # release the temporary images the algorithms made for this family
+            scratchArena.reset()
         noiseReplacer.end()
 
 
+    @staticmethod
+    def _makeSubset(catalog, indices):
+        """Return a catalog view of the records of catalog at the given (increasing) indices."""
+        if len(indices) == 0 or indices[-1] - indices[0] + 1 == len(indices):
+            begin = indices[0] if len(indices) else 0
+            return catalog[begin:begin + len(indices)]
+        subset = type(catalog)(catalog.getTable())
+        subset.extend(catalog[i] for i in indices)
+        return subset
+
     def generateMeasCat(self, exposure, refCat, refWcs, idFactory=None):
         """!Initialize an output SourceCatalog using information from the reference catalog.
 
@@ -367,7 +394,11 @@ class ForcedMeasurementTask(BaseMeasurementTask):
         measured, while the actual detections may start out in a different coordinate system.
         This default implementation transforms the Footprints from the reference catalog from the
         refWcs to the exposure's Wcs, which downgrades HeavyFootprints into regular Footprints,
-        destroying deblend information.
+        destroying deblend information, unless config.doKeepHeavyFootprints is set and
+        config.footprintTransformMaxError allows the Footprint to be transformed by linearizing the
+        mapping between the Wcss (see FootprintTransformer).  In that case the children's reference
+        pixels are used only as weights: their HeavyFootprints carry the exposure's pixels, divided
+        between the children of each family in proportion to their resampled reference pixels.
 
         Note that ForcedPhotImageTask delegates to this method in its own attachFootprints method.
         attachFootprints can then be overridden by its subclasses to define how their Footprints
@@ -378,5 +409,19 @@ class ForcedMeasurementTask(BaseMeasurementTask):
         """
         exposureWcs = exposure.getWcs()
         region = exposure.getBBox(lsst.afw.image.PARENT)
-        for srcRecord, refRecord in zip(sources, refCat):
-            srcRecord.setFootprint(refRecord.getFootprint().transform(refWcs, exposureWcs, region))
+        transformer = FootprintTransformer(refWcs, exposureWcs, region,
+                                           self.config.footprintTransformMaxError,
+                                           self.config.doKeepHeavyFootprints)
+        if self.config.doKeepHeavyFootprints:
+            if not isinstance(refCat, lsst.afw.table.SourceCatalog):
+                refList = list(refCat)
+                if not refList:
+                    return
+                refCat = lsst.afw.table.SourceCatalog(refList[0].getTable())
+                refCat.extend(refList)
+            transformer.transformCatalog(refCat, sources, exposure.getMaskedImage())
+        elif isinstance(refCat, lsst.afw.table.SourceCatalog):
+            transformer.transformCatalog(refCat, sources)
+        else:
+            for srcRecord, refRecord in zip(sources, refCat):
+                srcRecord.setFootprint(transformer(refRecord.getFootprint()))
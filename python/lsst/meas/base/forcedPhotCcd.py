@@ -30,7 +30,7 @@ import lsst.afw.image
 import lsst.afw.table
 from lsst.geom import convexHull
 
-from .forcedPhotImage import ProcessImageForcedTask, ProcessImageForcedConfig
+from .forcedPhotImage import ProcessImageForcedTask, ProcessImageForcedTaskRunner, ProcessImageForcedConfig
 
 try:
     from lsst.meas.mosaic import applyMosaicResults
@@ -175,7 +175,7 @@ class ForcedPhotCcdTask(ProcessImageForcedTask):
     """
 
     ConfigClass = ForcedPhotCcdConfig
-    RunnerClass = lsst.pipe.base.ButlerInitializedTaskRunner
+    RunnerClass = ProcessImageForcedTaskRunner
     _DefaultName = "forcedPhotCcd"
     dataPrefix = ""
 
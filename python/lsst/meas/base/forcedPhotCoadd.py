@@ -25,7 +25,7 @@ import lsst.pipe.base
 import lsst.coadd.utils
 import lsst.afw.table
 
-from .forcedPhotImage import ProcessImageForcedConfig, ProcessImageForcedTask
+from .forcedPhotImage import ProcessImageForcedConfig, ProcessImageForcedTaskRunner, ProcessImageForcedTask
 
 __all__ = ("ForcedPhotCoaddConfig", "ForcedPhotCoaddTask")
 
@@ -83,7 +83,7 @@ class ForcedPhotCoaddTask(ProcessImageForcedTask):
     """
 
     ConfigClass = ForcedPhotCoaddConfig
-    RunnerClass = lsst.pipe.base.ButlerInitializedTaskRunner
+    RunnerClass = ProcessImageForcedTaskRunner
     _DefaultName = "forcedPhotCoadd"
     dataPrefix = "deepCoadd_"
 
@@ -127,6 +127,19 @@ class ForcedPhotCoaddTask(ProcessImageForcedTask):
         references.extend(self.references.fetchInPatches(dataRef, patchList=[patchInfo]))
         return references
 
+    def getReferenceKey(self, dataRef):
+        """References depend only on the tract and patch, so they are shared by all bands of a patch."""
+        return (dataRef.dataId["tract"], dataRef.dataId["patch"])
+
+    def getFootprintKey(self, dataRef):
+        """Transformed Footprints are shared by all bands of a patch (whose coadds have the same Wcs and
+        bounding box), but deblended Footprints are read for each band, and transformed HeavyFootprints
+        carry each band's pixels (see ForcedMeasurementConfig.doKeepHeavyFootprints).
+        """
+        if self.config.footprintDatasetName is None and not self.measurement.config.doKeepHeavyFootprints:
+            return self.getReferenceKey(dataRef)
+        return None
+
     def attachFootprints(self, sources, refCat, exposure, refWcs, dataRef):
         """For coadd forced photometry, we use the deblended HeavyFootprints from the single-band
         measurements of the same band - because we've guaranteed that the peaks (and hence child sources)
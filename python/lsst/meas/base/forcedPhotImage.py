@@ -37,7 +37,7 @@ from .forcedMeasurement import ForcedMeasurementTask
 from .applyApCorr import ApplyApCorrTask
 from .afterburner import AfterburnerTask
 
-__all__ = ("ProcessImageForcedConfig", "ProcessImageForcedTask")
+__all__ = ("ProcessImageForcedConfig", "ProcessImageForcedTaskRunner", "ProcessImageForcedTask")
 
 class ProcessImageForcedConfig(lsst.pex.config.Config):
     """!Config class for forced measurement driver task."""
@@ -78,6 +78,28 @@ class ProcessImageForcedConfig(lsst.pex.config.Config):
         # ForcedMeasurementTask
         self.afterburners.plugins.names = []
 
+class ProcessImageForcedTaskRunner(lsst.pipe.base.ButlerInitializedTaskRunner):
+    """!Task runner that reuses one ProcessImageForcedTask for all the data references of a process.
+
+    When running in a single process, makeTask() constructs the task only once, so consecutive
+    exposures can share references and Footprints (see ProcessImageForcedTask.measureExposure).  The
+    task's metadata (and that of its subtasks) is replaced by an empty PropertyList each time it is
+    handed out again, so each data reference gets only its own metadata.  With multiple processes, each
+    data reference gets a new task, as with ButlerInitializedTaskRunner.
+    """
+
+    def makeTask(self, parsedCmd=None, args=None):
+        if self.numProcesses > 1:
+            return lsst.pipe.base.ButlerInitializedTaskRunner.makeTask(self, parsedCmd=parsedCmd, args=args)
+        task = getattr(self, "_task", None)
+        if task is None:
+            task = lsst.pipe.base.ButlerInitializedTaskRunner.makeTask(self, parsedCmd=parsedCmd, args=args)
+            self._task = task
+        else:
+            for subtask in task.getTaskDict().itervalues():
+                subtask.metadata = lsst.daf.base.PropertyList()
+        return task
+
 ## @addtogroup LSST_task_documentation
 ## @{
 ## @page ProcessImageForcedTask
@@ -122,6 +144,8 @@ class ProcessImageForcedTask(lsst.pipe.base.CmdLineTask):
         if self.config.doApCorr:
             self.makeSubtask("applyApCorr", schema=self.measurement.schema)
         self.makeSubtask('afterburners', schema=self.measurement.schema)
+        # references (and Footprints) of the last exposure run() measured; see measureExposure()
+        self._referenceCache = {}
 
     def run(self, dataRef):
         """!Measure a single exposure using forced detection for a reference catalog.
@@ -139,15 +163,50 @@ class ProcessImageForcedTask(lsst.pipe.base.CmdLineTask):
                               which writes the outputs.  See derived class documentation for which
                               datasets and data ID keys are used.
         """
-        refWcs = self.references.getWcs(dataRef)
         exposure = self.getExposure(dataRef)
-        refCat = self.fetchReferences(dataRef, exposure)
+        measCat = self.measureExposure(dataRef, exposure, cache=self._referenceCache)
+        self.writeOutput(dataRef, measCat)
+
+    def measureExposure(self, dataRef, exposure, cache=None):
+        """!Measure a single exposure that has already been read, returning the forced source catalog.
+
+        @param[in]  dataRef   An lsst.daf.persistence.ButlerDataRef; see run().
+        @param[in]  exposure  The exposure to measure, as returned by getExposure(dataRef).
+        @param[in,out] cache  A dict in which the references (and Footprints) of this exposure are kept
+                              for the next call, if getReferenceKey() (and getFootprintKey()) are not
+                              None (optional).  Only the most recent exposure's are kept; run() uses
+                              one that lasts as long as the task.
+
+        The output catalog is always generated anew, as measurement fills it in and its IDs come from
+        this exposure's IdFactory; only the Footprints attached to it are reused.
+        """
+        if cache is None:
+            cache = {}
+        refKey = self.getReferenceKey(dataRef)
+        if refKey is None or cache.get("refKey") != refKey:
+            cache.clear()
+            refWcs = self.references.getWcs(dataRef)
+            refCat = self.fetchReferences(dataRef, exposure)
+            if refKey is not None:
+                cache.update(refKey=refKey, refWcs=refWcs, refCat=refCat)
+        else:
+            refWcs = cache["refWcs"]
+            refCat = cache["refCat"]
         measCat = self.measurement.generateMeasCat(exposure, refCat, refWcs,
                                                    idFactory=self.makeIdFactory(dataRef))
+        exposureId = self.getExposureId(dataRef)
         self.log.info("Performing forced measurement on %s" % dataRef.dataId)
-        self.attachFootprints(measCat, refCat, exposure, refWcs, dataRef)
-
-        self.measurement.run(measCat, exposure, refCat, refWcs, exposureId=self.getExposureId(dataRef))
+        footprintKey = self.getFootprintKey(dataRef)
+        if footprintKey is not None and cache.get("footprintKey") == footprintKey:
+            for record, footprint in zip(measCat, cache["footprints"]):
+                record.setFootprint(footprint)
+        else:
+            self.attachFootprints(measCat, refCat, exposure, refWcs, dataRef)
+            if refKey is not None and footprintKey is not None:
+                cache.update(footprintKey=footprintKey,
+                             footprints=[record.getFootprint() for record in measCat])
+
+        self.measurement.run(measCat, exposure, refCat, refWcs, exposureId=exposureId)
 
         if self.config.doApCorr:
             self.applyApCorr.run(
@@ -155,9 +214,25 @@ class ProcessImageForcedTask(lsst.pipe.base.CmdLineTask):
                     apCorrMap=exposure.getInfo().getApCorrMap()
                     )
         self.afterburners.run(measCat)
+        return measCat
 
+    def getReferenceKey(self, dataRef):
+        """!Hook for derived classes to say which exposures share references.
 
-        self.writeOutput(dataRef, measCat)
+        Return a hashable key such that exposures whose dataRefs have equal keys have the same reference
+        Wcs and the same fetchReferences() result (which must then be a reusable container, not an
+        iterator), or None (the default) if references must be fetched for each exposure.
+        """
+        return None
+
+    def getFootprintKey(self, dataRef):
+        """!Hook for derived classes to say which exposures share Footprints.
+
+        Return a hashable key such that exposures whose dataRefs have equal keys (and equal
+        getReferenceKey()) are given the same Footprints by attachFootprints(), or None (the default)
+        if Footprints must be attached for each exposure.
+        """
+        return None
 
     def makeIdFactory(self, dataRef):
         """!Hook for derived classes to define how to make an IdFactory for forced sources.
@@ -172,6 +172,24 @@ class NoiseReplacer(object):
             # Also set the OTHERDET bit
             afwDet.setMaskFromFootprint(mask, fp, self.otherbitmask)
 
+        # Cache of the ids whose HeavyFootprints are used by insertSource and removeSource for each id
+        self.usedIds = {}
+
+    def getUsedId(self, id):
+        """!
+        Return the id of the source whose HeavyFootprint is used to insert or remove a given source
+
+        This is either the source itself, or the first parent in its parent chain which has a heavy
+        footprint (or the topmost parent, which always has one).  It is looked up once per source.
+        """
+        usedid = self.usedIds.get(id)
+        if usedid is None:
+            usedid = id
+            while self.footprints[usedid][0] != 0 and usedid not in self.heavies:
+                usedid = self.footprints[usedid][0]
+            self.usedIds[id] = usedid
+        return usedid
+
     def insertSource(self, id):
         """!
         Insert the heavy footprint of a given source into the exposure
@@ -187,10 +205,7 @@ class NoiseReplacer(object):
         # usedid can point either to this source, or to the first parent in the
         # parent chain which has a heavy footprint (or to the topmost parent,
         # which always has one)
-        usedid = id
-        while self.footprints[usedid][0] != 0 and not usedid in self.heavies.keys():
-            usedid = self.footprints[usedid][0]
-        fp = self.heavies[usedid]
+        fp = self.heavies[self.getUsedId(id)]
         fp.insert(im)
         afwDet.setMaskFromFootprint(mask, fp, self.thisbitmask)
         afwDet.clearMaskFromFootprint(mask, fp, self.otherbitmask)
@@ -210,13 +225,9 @@ class NoiseReplacer(object):
         im = mi.getImage()
         mask = mi.getMask()
 
-        # use the same algorithm as in remove Source to find the heavy noise footprint
-        # which will undo what insertSource(id) does
-        usedid = id
-        while self.footprints[usedid][0] != 0 and not usedid in self.heavies.keys():
-            usedid = self.footprints[usedid][0]
+        # use the same heavy noise footprint as insertSource, which will undo what insertSource(id) does
         # Re-insert the noise pixels
-        fp = self.heavyNoise[usedid]
+        fp = self.heavyNoise[self.getUsedId(id)]
         fp.insert(im)
         # Clear the THISDET mask plane.
         afwDet.clearMaskFromFootprint(mask, fp, self.thisbitmask)
@@ -246,6 +257,7 @@ class NoiseReplacer(object):
         del self.otherbitmask
         del self.heavies
         del self.heavyNoise
+        del self.usedIds
 
     def getNoiseGenerator(self, exposure, noiseImage, noiseMeanVar, exposureId=None):
         """!
@@ -20,16 +20,17 @@
 # the GNU General Public License along with this program.  If not,
 # see <http://www.lsstcorp.org/LegalNotices/>.
 #
-"""Registry for measurement plugins and associated utilities generateAlgorithmName and PluginMap
+"""Registry for measurement plugins and associated utilities generateAlgorithmName, PluginGraph and PluginMap
 """
 
 import collections
+import heapq
 
 import lsst.pipe.base
 import lsst.pex.config
 from .apCorrRegistry import addApCorrName
 
-__all__ = ("generateAlgorithmName", "PluginRegistry", "register",  "PluginMap")
+__all__ = ("generateAlgorithmName", "PluginRegistry", "register", "PluginGraph", "PluginMap")
 
 def generateAlgorithmName(AlgClass):
     """Generate a string name for an algorithm class that strips away terms that are generally redundant
@@ -141,13 +142,138 @@ def register(name, shouldApCorr=False, apCorrList=()):
     return decorate
 
 
+class PluginGraph(object):
+    """!
+    Dependency graph of the plugins configured for a measurement task
+
+    Each plugin's dependencies are given by its PluginClass.getDependencies(): the names of other
+    plugins, or of slots (e.g. "slot_Centroid"), which are resolved to the plugins that fill them using
+    a SourceSlotConfig.  Dependencies on slots that aren't set, and a slot plugin's dependency on its
+    own slot, are ignored; a dependency on a plugin that isn't configured is an error.  A
+    getDependencies() that returns None depends on every plugin with a smaller execution order.
+    """
+
+    def __init__(self, entries, slots=None):
+        """!
+        Build the graph.
+
+        @param[in] entries  Iterable of (executionOrder, name, config, PluginClass) tuples, as returned by
+                            the apply() method of a plugin RegistryField.
+        @param[in] slots    SourceSlotConfig used to resolve slot dependencies, or None if there are no
+                            slots.
+        """
+        self.entries = dict((entry[1], entry) for entry in entries)
+        self.slotPlugins = set()
+        if slots is not None:
+            for field in slots.keys():
+                name = self._resolveSlot(slots, field)
+                if name is not None:
+                    self.slotPlugins.add(name)
+        self.dependencies = {}
+        for name, (executionOrder, _, config, PluginClass) in self.entries.iteritems():
+            requested = PluginClass.getDependencies()
+            if requested is None:
+                self.dependencies[name] = set(other for other, entry in self.entries.iteritems()
+                                              if entry[0] < executionOrder)
+                continue
+            dependencies = set()
+            for dependency in requested:
+                if dependency.startswith("slot_"):
+                    field = dependency[len("slot_"):]
+                    field = field[:1].lower() + field[1:]
+                    if slots is None or field not in slots.keys():
+                        raise ValueError("Plugin '%s' depends on unknown slot '%s'" % (name, dependency))
+                    dependency = self._resolveSlot(slots, field)
+                    if dependency is None:
+                        continue
+                elif dependency not in self.entries:
+                    raise ValueError("Plugin '%s' depends on plugin '%s', which is not being run"
+                                     % (name, dependency))
+                if dependency != name:
+                    dependencies.add(dependency)
+            self.dependencies[name] = dependencies
+
+    def _resolveSlot(self, slots, field):
+        """Return the name of the configured plugin that fills a slot, or None if the slot isn't set.
+
+        Flux slots may name a field prefix that is longer than the plugin name (e.g.
+        base_CircularApertureFlux_3_0), so the plugin is matched by prefix, as in
+        BaseMeasurementConfig.validate().
+        """
+        target = getattr(slots, field)
+        if target is None:
+            return None
+        if target in self.entries:
+            return target
+        for name in self.entries:
+            if target.startswith(name):
+                return name
+        return None
+
+    def getRequired(self, names):
+        """!
+        Return the names of the given plugins, the slot plugins, and everything they depend on.
+
+        @param[in] names  Names of the plugins whose outputs are requested.
+        """
+        unknown = [name for name in names if name not in self.entries]
+        if unknown:
+            raise ValueError("Requested plugins %s are not being run" % unknown)
+        required = set()
+        pending = list(names) + list(self.slotPlugins)
+        while pending:
+            name = pending.pop()
+            if name not in required:
+                required.add(name)
+                pending.extend(self.dependencies[name])
+        return required
+
+    def sort(self, names=None):
+        """!
+        Return the (executionOrder, name, config, PluginClass) entries in an order that satisfies all
+        dependencies.
+
+        Among plugins whose dependencies have all been satisfied, those with the smallest
+        (executionOrder, name) come first.  With the default BasePlugin.getDependencies(), centroid
+        plugins depend on the centroid slot, so the slot centroid plugin comes before the other
+        plugins with the same execution order; otherwise the order is that of a plain sort.  This is
+        the order measurement tasks have always run plugins in: before PluginGraph, they reserved the
+        slot centroid's place at the front of their PluginMap and sorted the rest.
+
+        @param[in] names  Names of the plugins to include (which must include all their
+                          dependencies); all plugins if None.
+        """
+        if names is None:
+            names = self.entries.keys()
+        names = set(names)
+        remaining = dict((name, len(self.dependencies[name] & names)) for name in names)
+        dependents = collections.defaultdict(list)
+        for name in names:
+            for dependency in self.dependencies[name] & names:
+                dependents[dependency].append(name)
+        ready = [self.entries[name][:2] for name, count in remaining.iteritems() if count == 0]
+        heapq.heapify(ready)
+        result = []
+        while ready:
+            executionOrder, name = heapq.heappop(ready)
+            result.append(self.entries[name])
+            for dependent in dependents[name]:
+                remaining[dependent] -= 1
+                if remaining[dependent] == 0:
+                    heapq.heappush(ready, self.entries[dependent][:2])
+        if len(result) != len(names):
+            cycle = sorted(name for name, count in remaining.iteritems() if count > 0)
+            raise ValueError("Plugins %s have circular dependencies" % cycle)
+        return result
+
+
 class PluginMap(collections.OrderedDict):
     """!
     Map of plugins (instances of subclasses of BasePlugin) to be run for a task
 
-    We assume plugins are added to the PluginMap according to their "Execution Order", so this
-    class doesn't actually do any of the sorting (though it does have to maintain that order,
-    which it does by inheriting from OrderedDict).
+    We assume plugins are added to the PluginMap in an order that satisfies their dependencies (see
+    PluginGraph), so this class doesn't actually do any of the sorting (though it does have to maintain
+    that order, which it does by inheriting from OrderedDict).
     """
 
     def iter(self):
@@ -36,7 +36,7 @@ from . import baseLib as bl
 from .pluginsBase import BasePlugin
 from .sfm import SingleFramePluginConfig, SingleFramePlugin
 from .forcedMeasurement import ForcedPluginConfig, ForcedPlugin
-from .wrappers import wrapSimpleAlgorithm
+from .wrappers import wrapSingleFrameAlgorithm, wrapSimpleAlgorithm
 from .transforms import SimpleCentroidTransform
 
 __all__ = (
@@ -54,7 +54,8 @@ __all__ = (
 # --- Wrapped C++ Plugins ---
 
 wrapSimpleAlgorithm(bl.PsfFluxAlgorithm, Control=bl.PsfFluxControl,
-                TransformClass=bl.PsfFluxTransform, executionOrder=BasePlugin.FLUX_ORDER, shouldApCorr=True)
+                TransformClass=bl.PsfFluxTransform, executionOrder=BasePlugin.FLUX_ORDER, shouldApCorr=True,
+                hasMeasureN=True, measureNArg=False, doMeasureN=False)
 wrapSimpleAlgorithm(bl.PeakLikelihoodFluxAlgorithm, Control=bl.PeakLikelihoodFluxControl,
                 TransformClass=bl.PeakLikelihoodFluxTransform, executionOrder=BasePlugin.FLUX_ORDER)
 wrapSimpleAlgorithm(bl.GaussianFluxAlgorithm, Control=bl.GaussianFluxControl,
@@ -76,149 +77,35 @@ wrapSimpleAlgorithm(bl.CircularApertureFluxAlgorithm, needsMetadata=True, Contro
 wrapSimpleAlgorithm(bl.BlendednessAlgorithm, Control=bl.BlendednessControl,
                 TransformClass=bl.BaseTransform, executionOrder=BasePlugin.SHAPE_ORDER)
 
-# --- Single-Frame Measurement Plugins ---
-class SingleFrameFPPositionConfig(SingleFramePluginConfig):
-    pass
-
-@register("base_FPPosition")
-class SingleFrameFPPositionPlugin(SingleFramePlugin):
-    '''
-    Algorithm to calculate the position of a centroid on the focal plane
-    '''
-
-    ConfigClass = SingleFrameFPPositionConfig
-
-    @classmethod
-    def getExecutionOrder(cls):
-        return cls.SHAPE_ORDER
-
-    def __init__(self, config, name, schema, metadata):
-        SingleFramePlugin.__init__(self, config, name, schema, metadata)
-        self.focalValue = lsst.afw.table.Point2DKey.addFields(schema, name, "Position on the focal plane",
-                                                              "mm")
-        self.focalFlag = schema.addField(name + "_flag", type="Flag", doc="Set to True for any fatal failure")
-        self.detectorFlag = schema.addField(name + "_missingDetector_flag", type="Flag",
-                                            doc="Set to True if detector object is missing")
-
-    def measure(self, measRecord, exposure):
-        det = exposure.getDetector()
-        if not det:
-            measRecord.set(self.detectorFlag, True)
-            fp = lsst.afw.geom.Point2D(numpy.nan, numpy.nan)
-        else:
-            center = measRecord.getCentroid()
-            posInPix = det.makeCameraPoint(center, lsst.afw.cameraGeom.PIXELS)
-            fp = det.transform(posInPix, lsst.afw.cameraGeom.FOCAL_PLANE).getPoint()
-        measRecord.set(self.focalValue, fp)
-
-    def fail(self, measRecord, error=None):
-        measRecord.set(self.focalFlag, True)
-
-class SingleFrameJacobianConfig(SingleFramePluginConfig):
-    pixelScale = lsst.pex.config.Field(dtype=float, default=0.5, doc="Nominal pixel size (arcsec)")
-
-@register("base_Jacobian")
-class SingleFrameJacobianPlugin(SingleFramePlugin):
-    '''
-    Algorithm which computes the Jacobian about a source and computes its ratio with a nominal pixel area.
-    This allows one to compare relative instead of absolute areas of pixels.
-    '''
-
-    ConfigClass = SingleFrameJacobianConfig
-
-    @classmethod
-    def getExecutionOrder(cls):
-        return cls.SHAPE_ORDER
-
-    def __init__(self, config, name, schema, metadata):
-        SingleFramePlugin.__init__(self, config, name, schema, metadata)
-        self.jacValue = schema.addField(name + '_value', type="D", doc="Jacobian correction")
-        self.jacFlag = schema.addField(name + '_flag', type="Flag", doc="Set to 1 for any fatal failure")
-        # Calculate one over the area of a nominal reference pixel
-        self.scale = pow(self.config.pixelScale, -2)
-
-    def measure(self, measRecord, exposure):
-        center = measRecord.getCentroid()
-        # Compute the area of a pixel at the center of a source records centroid, and take the
-        # ratio of that with the defined reference pixel area.
-        result = numpy.abs(self.scale*exposure.getWcs().linearizePixelToSky(center,
-                           lsst.afw.geom.arcseconds).getLinear().computeDeterminant())
-        measRecord.set(self.jacValue, result)
-
-    def fail(self, measRecord, error=None):
-        measRecord.set(self.jacFlag, True)
-
-
-class SingleFrameVarianceConfig(SingleFramePluginConfig):
-        scale = lsst.pex.config.Field(dtype=float, default=5.0, optional=True,
-                                      doc="Scale factor to apply to shape for aperture")
-        mask = lsst.pex.config.ListField(doc="Mask planes to ignore", dtype=str,
-                                         default=["DETECTED", "DETECTED_NEGATIVE", "BAD", "SAT"])
-
-@register("base_Variance")
-class SingleFrameVariancePlugin(SingleFramePlugin):
-    '''
-    Calculate the median variance within a Footprint scaled from the object shape so
-    the value is not terribly influenced by the object and instead represents the
-    variance in the background near the object.
-    '''
-    ConfigClass = SingleFrameVarianceConfig
-    FAILURE_BAD_CENTROID = 1
-    FAILURE_EMPTY_FOOTPRINT = 2
-
-    @classmethod
-    def getExecutionOrder(cls):
-        return cls.FLUX_ORDER
-
-    def __init__(self, config, name, schema, metadata):
-        SingleFramePlugin.__init__(self, config, name, schema, metadata)
-        self.varValue = schema.addField(name + '_value', type="D", doc="Variance at object position")
-        self.varFlag = schema.addField(name + '_flag', type="Flag", doc="Set to True for any fatal failure")
-        self.emptyFootprintFlag = schema.addField(name + '_flag_emptyFootprint', type="Flag", 
-                                                  doc="Set to True when the footprint has no usable pixels")
-
-        # Alias the badCentroid flag to that which is defined for the target of the centroid slot.
-        # We do not simply rely on the alias because that could be changed post-measurement.
-        schema.getAliasMap().set(name + '_flag_badCentroid', schema.getAliasMap().apply("slot_Centroid_flag"))
-
-    def measure(self, measRecord, exposure):
-        if measRecord.getCentroidFlag():
-            raise bl.MeasurementError("Source record has a bad centroid.", self.FAILURE_BAD_CENTROID)
-        center = measRecord.getCentroid()
-        # Create an aperture and grow it by scale value defined in config to ensure there are enough
-        # pixels around the object to get decent statistics
-        aperture = lsst.afw.geom.ellipses.Ellipse(measRecord.getShape(), measRecord.getCentroid())
-        aperture.scale(self.config.scale)
-        foot = lsst.afw.detection.Footprint(aperture)
-        foot.clipTo(exposure.getBBox(lsst.afw.image.PARENT))
-        # Filter out any pixels which have mask bits set corresponding to the planes to be excluded
-        # (defined in config.mask)
-        maskedImage = exposure.getMaskedImage()
-        pixels = lsst.afw.detection.makeHeavyFootprint(foot, maskedImage)
-        maskBits = maskedImage.getMask().getPlaneBitMask(self.config.mask)
-        logicalMask = numpy.logical_not(pixels.getMaskArray() & maskBits)
-        # Compute the median variance value for each pixel not excluded by the mask and write the record.
-        # Numpy median is used here instead of afw.math makeStatistics because of an issue with data types
-        # being passed into the C++ layer (DM-2379).
-        if numpy.any(logicalMask):
-            medVar = numpy.median(pixels.getVarianceArray()[logicalMask])
-            measRecord.set(self.varValue, medVar)
-        else:
-            raise bl.MeasurementError("Footprint empty, or all pixels are masked, can't compute median",
-                                      self.FAILURE_EMPTY_FOOTPRINT)
-
-    def fail(self, measRecord, error=None):
-        # Check that we have a error object and that it is of type MeasurementError
-        if isinstance(error, bl.MeasurementError):
-            assert error.getFlagBit() in (self.FAILURE_BAD_CENTROID, self.FAILURE_EMPTY_FOOTPRINT)
-            # FAILURE_BAD_CENTROID handled by alias to centroid record.
-            if error.getFlagBit() == self.FAILURE_EMPTY_FOOTPRINT:
-                measRecord.set(self.emptyFootprintFlag, True)
-        measRecord.set(self.varValue, numpy.nan)
-        measRecord.set(self.varFlag, True)
+# Single-frame only: these have no forced counterparts.
+SingleFrameFPPositionPlugin = wrapSingleFrameAlgorithm(bl.FPPositionAlgorithm, Control=bl.FPPositionControl,
+                                                       executionOrder=BasePlugin.SHAPE_ORDER)
+SingleFrameFPPositionConfig = SingleFrameFPPositionPlugin.ConfigClass
+SingleFrameJacobianPlugin = wrapSingleFrameAlgorithm(bl.JacobianAlgorithm, Control=bl.JacobianControl,
+                                                     executionOrder=BasePlugin.SHAPE_ORDER)
+SingleFrameJacobianConfig = SingleFrameJacobianPlugin.ConfigClass
+SingleFrameVariancePlugin = wrapSingleFrameAlgorithm(bl.VarianceAlgorithm, Control=bl.VarianceControl,
+                                                     executionOrder=BasePlugin.FLUX_ORDER)
+SingleFrameVarianceConfig = SingleFrameVariancePlugin.ConfigClass
+SingleFrameSkyCoordPlugin = wrapSingleFrameAlgorithm(bl.SkyCoordAlgorithm, Control=bl.SkyCoordControl,
+                                                     executionOrder=BasePlugin.SHAPE_ORDER)
+SingleFrameSkyCoordConfig = SingleFrameSkyCoordPlugin.ConfigClass
 
+# --- Single-Frame Measurement Plugins ---
 class SingleFrameInputCountConfig(SingleFramePluginConfig):
-    pass
+    useCoverageMap = lsst.pex.config.Field(
+        dtype=bool, default=False,
+        doc="Count inputs with a coverage map of the coadd (CoaddInputCoverage), built once per exposure, "
+            "instead of testing every input for every source; sources near input boundaries are still "
+            "counted exactly"
+    )
+    coverageCellSize = lsst.pex.config.Field(dtype=int, default=64,
+                                             doc="Size (pixels) of the coverage map's cells")
+    doFootprintMin = lsst.pex.config.Field(
+        dtype=bool, default=False,
+        doc="Also record the smallest number of inputs over the Footprint's bounding box, sampled at "
+            "the center and the coverage map's cell corners"
+    )
 
 @register("base_InputCount")
 class SingleFrameInputCountPlugin(SingleFramePlugin):
@@ -226,7 +113,7 @@ class SingleFrameInputCountPlugin(SingleFramePlugin):
     Plugin to count how many input images contributed to each source. This information
     is in the exposure's coaddInputs. Some limitations:
     * This is only for the pixel containing the center, not for all the pixels in the
-      Footprint
+      Footprint (but see the doFootprintMin config option)
     * This does not account for any clipping in the coadd
     """
 
@@ -246,6 +133,13 @@ class SingleFrameInputCountPlugin(SingleFramePlugin):
         self.numberFlag = schema.addField(name + '_flag', type="Flag", doc="Set to True for fatal failure")
         self.noInputsFlag = schema.addField(name + '_flag_noInputs', type="Flag",
                                             doc="No coadd inputs available")
+        if self.config.doFootprintMin:
+            self.footprintMinKey = schema.addField(name + '_footprintMin', type="I",
+                                                   doc="Smallest number of images contributing anywhere "
+                                                       "in the Footprint's bounding box, sampled at the "
+                                                       "coverage map's resolution")
+        else:
+            self.footprintMinKey = None
         # Alias the badCentroid flag to that which is defined for the target of the centroid slot.
         # We do not simply rely on the alias because that could be changed post-measurement.
         schema.getAliasMap().set(name + '_flag_badCentroid', schema.getAliasMap().apply("slot_Centroid_flag"))
@@ -257,11 +151,21 @@ class SingleFrameInputCountPlugin(SingleFramePlugin):
             raise bl.MeasurementError("Source has a bad centroid.", self.FAILURE_BAD_CENTROID)
 
         center = measRecord.getCentroid()
-        # Promote bounding box of the Footprint to type D to ensure
-        # the ability to compare the Footprint and center (they may be of mixed types I and D)
-        fpBbox = lsst.afw.geom.Box2D(measRecord.getFootprint().getBBox())
-        ccds = exposure.getInfo().getCoaddInputs().ccds
-        measRecord.set(self.numberKey, len(ccds.subsetContaining(center, exposure.getWcs())))
+        coaddInputs = exposure.getInfo().getCoaddInputs()
+        if self.config.useCoverageMap or self.footprintMinKey is not None:
+            coverage = bl.CoaddInputCoverage.getCached(coaddInputs, exposure.getWcs(), exposure.getBBox(),
+                                                       self.config.coverageCellSize)
+        if self.config.useCoverageMap:
+            count = coverage.countContaining(center)
+        else:
+            count = len(coaddInputs.ccds.subsetContaining(center, exposure.getWcs()))
+        measRecord.set(self.numberKey, count)
+        if self.footprintMinKey is not None:
+            # Promote bounding box of the Footprint to type D to ensure
+            # the ability to compare the Footprint and center (they may be of mixed types I and D)
+            fpBbox = lsst.afw.geom.Box2D(measRecord.getFootprint().getBBox())
+            cornerMin = coverage.computeMinCount(fpBbox)
+            measRecord.set(self.footprintMinKey, count if cornerMin < 0 else min(count, cornerMin))
 
     def fail(self, measRecord, error=None):
         measRecord.set(self.numberFlag, True)
@@ -306,36 +210,6 @@ class SingleFramePeakCentroidPlugin(SingleFramePlugin):
     def getTransformClass():
         return SimpleCentroidTransform
 
-class SingleFrameSkyCoordConfig(SingleFramePluginConfig):
-    pass
-
-@register("base_SkyCoord")
-class SingleFrameSkyCoordPlugin(SingleFramePlugin):
-    """
-    A measurement plugin that sets the "coord" field (part of the Source minimal schema)
-    using the slot centroid and the Wcs attached to the Exposure.
-    """
-
-    ConfigClass = SingleFrameSkyCoordConfig
-
-    @classmethod
-    def getExecutionOrder(cls):
-        return cls.SHAPE_ORDER
-
-    def measure(self, measRecord, exposure):
-        # there should be a base class method for handling this exception. Put this on a later ticket
-        # Also, there should be a python Exception of the appropriate type for this error
-        if not exposure.hasWcs():
-            raise Exception("Wcs not attached to exposure.  Required for " + self.name + " algorithm")
-        measRecord.updateCoord(exposure.getWcs())
-
-    def fail(self, measRecord, error=None):
-        # Override fail() to do nothing in the case of an exception: this is not ideal,
-        # but we don't have a place to put failures because we don't allocate any fields.
-        # Should consider fixing as part of DM-1011
-        pass
-
-
 # --- Forced Plugins ---
 
 class ForcedPeakCentroidConfig(ForcedPluginConfig):
@@ -64,14 +64,34 @@ class BasePlugin(object):
 
         Must be reimplemented as a class method by concrete derived classes.
 
-        This approach was chosen instead of a full graph-based analysis of dependencies
-        because algorithm dependencies are usually both quite simple and entirely substitutable:
-        an algorithm that requires a centroid can typically make use of any centroid algorithms
-        outputs.  That makes it relatively easy to figure out the correct value to use for any
-        particular algorithm.
+        Measurement tasks run plugins in an order determined by getDependencies(), which by
+        default is derived from the execution order; the execution order then only breaks ties.
+        Because algorithm dependencies are usually both quite simple and entirely substitutable
+        (an algorithm that requires a centroid can typically make use of any centroid algorithm's
+        outputs), most plugins need only set the execution order.
         """
         raise NotImplementedError("All plugins must implement getExecutionOrder()")
 
+    @classmethod
+    def getDependencies(cls):
+        """Return the names of the slots (e.g. "slot_Centroid") and other plugins this plugin reads.
+
+        These are used by measurement tasks to build a PluginGraph, which determines the order plugins
+        are run in, and which plugins are needed when only some outputs are requested.  None means
+        the plugin depends on every plugin with a smaller execution order.
+
+        The default follows the meanings of the execution order constants: centroid and shape
+        algorithms depend on the centroid slot, flux algorithms on the centroid and shape slots, and
+        anything later on everything run before it.  Plugins that read other plugins' outputs
+        directly, or that need less than their execution order implies, should reimplement this.
+        """
+        executionOrder = cls.getExecutionOrder()
+        if executionOrder < cls.FLUX_ORDER:
+            return ("slot_Centroid",)
+        if executionOrder < cls.APCORR_ORDER:
+            return ("slot_Centroid", "slot_Shape")
+        return None
+
     def __init__(self, config, name):
         """!
         Initialize the plugin object.
@@ -102,3 +102,15 @@
 
 %feature("notabstract") lsst::meas::base::PixelFlagsAlgorithm;
 %include "lsst/meas/base/PixelFlags.h"
+
+%feature("notabstract") lsst::meas::base::VarianceAlgorithm;
+%include "lsst/meas/base/Variance.h"
+
+%feature("notabstract") lsst::meas::base::JacobianAlgorithm;
+%include "lsst/meas/base/Jacobian.h"
+
+%feature("notabstract") lsst::meas::base::FPPositionAlgorithm;
+%include "lsst/meas/base/FPPosition.h"
+
+%feature("notabstract") lsst::meas::base::SkyCoordAlgorithm;
+%include "lsst/meas/base/SkyCoord.h"
@@ -24,11 +24,18 @@
 Subtasks for creating the reference catalogs used in forced measurement.
 """
 
+import itertools
+import math
+from collections import OrderedDict
+
+import numpy
+
 import lsst.afw.geom
+import lsst.afw.table
 import lsst.pex.config
 import lsst.pipe.base
 
-__all__ = ("BaseReferencesTask", "CoaddSrcReferencesTask")
+__all__ = ("BaseReferencesTask", "CoaddSrcReferencesTask", "ReferenceIndex")
 
 class BaseReferencesConfig(lsst.pex.config.Config):
     removePatchOverlaps = lsst.pex.config.Field(
@@ -41,6 +48,128 @@ class BaseReferencesConfig(lsst.pex.config.Config):
         dtype = str,
         optional = True
     )
+    indexBucketSize = lsst.pex.config.Field(
+        doc = "Size (arcsec) of the sky buckets in which reference parents are indexed",
+        dtype = float,
+        default = 30.0,
+    )
+    indexCacheSize = lsst.pex.config.Field(
+        doc = "Number of per-patch reference indexes retained for reuse by later calls to fetchInBox",
+        dtype = int,
+        default = 4,
+    )
+
+
+class ReferenceIndex(object):
+    """!
+    A sky-coordinate index over the parent objects of a reference catalog.
+
+    Parents are bucketed by their coordinates on a grid of declination bands, each divided into
+    right ascension bins of (roughly) equal area, so a query only has to look at the parents in the
+    buckets that overlap the region of interest.  The children of each parent are stored with it,
+    so queries return whole families, as required by ReplaceWithNoise in measurement.
+
+    An index is built once (e.g. per patch) and may be queried for any number of boxes.
+    """
+
+    def __init__(self, sources, schema, bucketSize):
+        """!Build the index.
+
+        @param[in] sources     input iterable of SourceRecords
+        @param[in] schema      Schema of the sources
+        @param[in] bucketSize  afw.geom.Angle; size of the sky buckets
+        """
+        # We're passed an arbitrary iterable, but we need a catalog so we can iterate
+        # over parents and then children.
+        self.catalog = lsst.afw.table.SourceCatalog(schema)
+        self.catalog.extend(sources)
+        # catalog must be sorted by parent ID for lsst.afw.table.getChildren to work
+        self.catalog.sort(lsst.afw.table.SourceTable.getParentKey())
+        self.parents = list(self.catalog.getChildren(0))
+        self.children = [self.catalog.getChildren(parent.getId()) for parent in self.parents]
+
+        self._bucketSize = bucketSize.asRadians()
+        self._nBands = max(1, int(math.ceil(math.pi/self._bucketSize)))
+        self._bandHeight = math.pi/self._nBands
+        # Number of RA bins in each band, chosen so that bins are no narrower than bucketSize on the sky
+        # at the band's edge nearest the equator.
+        bandEdges = numpy.arange(self._nBands + 1)*self._bandHeight - 0.5*math.pi
+        maxCos = numpy.cos(numpy.minimum(numpy.abs(bandEdges[:-1]), numpy.abs(bandEdges[1:])))
+        maxCos[(bandEdges[:-1] <= 0.0) & (bandEdges[1:] >= 0.0)] = 1.0
+        self._nBins = numpy.maximum(1, numpy.floor(2.0*math.pi*maxCos/self._bucketSize)).astype(int)
+        self._bandEdges = bandEdges
+
+        self._buckets = {}
+        if not self.parents:
+            return
+        position = numpy.array([parent.getCoord().toIcrs().getPosition(lsst.afw.geom.radians)
+                                for parent in self.parents])
+        ra = numpy.mod(position[:, 0], 2.0*math.pi)
+        band = self._findBand(position[:, 1])
+        binIndex = numpy.minimum((ra*self._nBins[band]/(2.0*math.pi)).astype(int), self._nBins[band] - 1)
+        order = numpy.lexsort((binIndex, band))
+        keys = numpy.column_stack((band[order], binIndex[order]))
+        breaks = numpy.flatnonzero(numpy.any(keys[1:] != keys[:-1], axis=1)) + 1
+        for indices in numpy.split(order, breaks):
+            self._buckets[(int(band[indices[0]]), int(binIndex[indices[0]]))] = indices
+
+    def _findBand(self, dec):
+        return numpy.clip(((numpy.asarray(dec) + 0.5*math.pi)/self._bandHeight).astype(int),
+                          0, self._nBands - 1)
+
+    def _findCandidates(self, center, radius):
+        """Return the indices of parents in the buckets that overlap a circle (radians)."""
+        ra, dec = center.getPosition(lsst.afw.geom.radians)
+        ra %= 2.0*math.pi
+        candidates = []
+        for band in range(int(self._findBand(dec - radius)), int(self._findBand(dec + radius)) + 1):
+            nBins = self._nBins[band]
+            lower, upper = self._bandEdges[band], self._bandEdges[band + 1]
+            maxAbsDec = max(abs(lower), abs(upper))
+            if radius + maxAbsDec >= 0.5*math.pi:
+                bins = range(nBins)
+            else:
+                halfWidth = math.asin(min(1.0, math.sin(radius)/math.cos(maxAbsDec)))
+                first = int(math.floor((ra - halfWidth)*nBins/(2.0*math.pi)))
+                last = int(math.floor((ra + halfWidth)*nBins/(2.0*math.pi)))
+                bins = set(i % nBins for i in range(first, min(last, first + nBins - 1) + 1))
+            for i in bins:
+                indices = self._buckets.get((band, i))
+                if indices is not None:
+                    candidates.append(indices)
+        return numpy.concatenate(candidates) if candidates else numpy.zeros(0, dtype=int)
+
+    def subset(self, bbox, wcs):
+        """!
+        Return the families whose parents lie within the given box, defined in the coordinate system
+        defined by the given Wcs.
+
+        @param[in] bbox        bounding box with which to filter reference sources (Box2I or Box2D)
+        @param[in] wcs         afw.image.Wcs that defines the coordinate system of bbox
+
+        @return an iterable of filtered reference sources, each parent followed by its children; parents
+                are returned in input order, as BaseReferencesTask.subset would return them
+
+        The sky region searched is a circle around the box's centre that encloses its corners and edge
+        midpoints (with a small margin for Wcs distortion); only the parents in buckets overlapping it
+        are transformed to pixel coordinates and tested against the box.
+        """
+        boxD = lsst.afw.geom.Box2D(bbox)
+        if boxD.isEmpty() or not self.parents:
+            return
+        center = wcs.pixelToSky(boxD.getCenter()).toIcrs()
+        xs = (boxD.getMinX(), boxD.getCenterX(), boxD.getMaxX())
+        ys = (boxD.getMinY(), boxD.getCenterY(), boxD.getMaxY())
+        radius = max(center.angularSeparation(wcs.pixelToSky(lsst.afw.geom.Point2D(x, y))).asRadians()
+                     for x in xs for y in ys)
+        radius = 1.01*radius + 1E-3*self._bucketSize
+        for i in numpy.sort(self._findCandidates(center, radius)):
+            parent = self.parents[i]
+            if boxD.contains(wcs.skyToPixel(parent.getCoord())):
+                yield parent
+                for child in self.children[i]:
+                    yield child
+
 
 class BaseReferencesTask(lsst.pipe.base.Task):
     """!
@@ -190,6 +319,25 @@ class CoaddSrcReferencesTask(BaseReferencesTask):
             schema = butler.get("{}Coadd_{}_schema".format(self.config.coaddName, self.datasetSuffix),
                                 immediate=True).getSchema()
         self.schema = schema
+        self._indexCache = OrderedDict()
+
+    def getReferenceIndex(self, dataRef, patch):
+        """!
+        Return a ReferenceIndex over the reference sources in a patch, as returned by fetchInPatches.
+
+        The most recently used config.indexCacheSize indexes are retained, so CCDs that overlap the
+        same patches don't reload and rescan its reference catalog.
+        """
+        key = (dataRef.dataId["tract"], patch.getIndex())
+        index = self._indexCache.pop(key, None)
+        if index is None:
+            index = ReferenceIndex(self.fetchInPatches(dataRef, [patch]), self.schema,
+                                   self.config.indexBucketSize*lsst.afw.geom.arcseconds)
+        if self.config.indexCacheSize > 0:
+            self._indexCache[key] = index
+            while len(self._indexCache) > self.config.indexCacheSize:
+                self._indexCache.popitem(last=False)
+        return index
 
     def getWcs(self, dataRef):
         """Return the WCS for reference sources.  The given dataRef must include the tract in its dataId.
@@ -237,6 +385,9 @@ class CoaddSrcReferencesTask(BaseReferencesTask):
                               before filtering them to include just the given bounding box.
 
         @return an iterable of reference sources
+
+        Sources are returned patch by patch, in the order of the patches returned by
+        TractInfo.findPatchList; within each patch they are in the order of ReferenceIndex.subset.
         """
         skyMap = dataRef.get(self.config.coaddName + "Coadd_skyMap", immediate=True)
         tract = skyMap[dataRef.dataId["tract"]]
@@ -248,7 +399,8 @@ class CoaddSrcReferencesTask(BaseReferencesTask):
         # But don't add any new patches while padding
         if pad:
             bbox.grow(pad)
-        return self.subset(self.fetchInPatches(dataRef, patchList), bbox, wcs)
+        return itertools.chain.from_iterable(self.getReferenceIndex(dataRef, patch).subset(bbox, wcs)
+                                             for patch in patchList)
 
 
 class MultiBandReferencesConfig(CoaddSrcReferencesTask.ConfigClass):
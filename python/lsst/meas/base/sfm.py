@@ -29,10 +29,16 @@ slot-eligible fields must be), but non-slot fields may be recorded in other coor
 to avoid information loss (this should, of course, be indicated in the field documentation).
 """
 
+import lsst.pex.config
+import lsst.afw.geom
+import lsst.afw.table
+import lsst.afw.detection
+
 from .pluginRegistry import PluginRegistry
 from .baseMeasurement import (BaseMeasurementPluginConfig, BaseMeasurementPlugin,
                               BaseMeasurementConfig, BaseMeasurementTask)
 from .noiseReplacer import NoiseReplacer, DummyNoiseReplacer
+from .baseLib import ScratchArena
 
 __all__ = ("SingleFramePluginConfig", "SingleFramePlugin",
            "SingleFrameMeasurementConfig", "SingleFrameMeasurementTask")
@@ -129,6 +135,22 @@ class SingleFrameMeasurementConfig(BaseMeasurementConfig):
         )
     algorithms = property(lambda self: self.plugins, doc="backwards-compatibility alias for plugins")
 
+    tileSize = lsst.pex.config.Field(
+        dtype=int, default=4096,
+        doc="Size (pixels) of the square tiles an exposure is divided into by runTiled()"
+        )
+    tileHalo = lsst.pex.config.Field(
+        dtype=int, default=256,
+        doc="Width (pixels) of the border read around each tile by runTiled(); families whose Footprints "
+            "extend further outside the tile are measured on their own sub-exposure"
+        )
+    tileMaxFamilySize = lsst.pex.config.Field(
+        dtype=int, default=None, optional=True,
+        doc="Largest width or height (pixels) of the sub-exposure runTiled() reads for a family that "
+            "straddles tiles; larger families are measured on a sub-exposure of this size centered on them, "
+            "with their Footprints clipped to it.  None for tileSize + 2*tileHalo."
+        )
+
 ## \addtogroup LSST_task_documentation
 ## \{
 ## \page SingleFrameMeasurementTask
@@ -282,6 +304,210 @@ class SingleFrameMeasurementTask(BaseMeasurementTask):
         assert measCat.getSchema().contains(self.schema)
         footprints = {measRecord.getId(): (measRecord.getParent(), measRecord.getFootprint())
             for measRecord in measCat}
+        self._addNoiseMetadata(measCat, exposureId)
+        self._measureFamilies(measCat, exposure, footprints, noiseImage=noiseImage, exposureId=exposureId,
+                              beginOrder=beginOrder, endOrder=endOrder)
+
+    def runTiled(self, measCat, readExposure, bbox, noiseImage=None, exposureId=None, beginOrder=None,
+                 endOrder=None):
+        """!
+        Run single frame measurement over an exposure too large to hold in memory, one tile at a time
+
+        The exposure is divided into square tiles of config.tileSize pixels.  Each family (a parent and
+        its children) is assigned to the tile containing the center of its Footprint, and the tile is
+        read with a border of config.tileHalo pixels; families whose Footprints don't fit within that
+        border are instead measured one at a time on a sub-exposure just large enough for them (grown by
+        the halo).  Only one tile or sub-exposure is held in memory at a time.  Neighboring families
+        that overlap a tile are replaced with noise (within the tile) but not measured there.
+
+        A straddling family whose sub-exposure would be wider or taller than config.tileMaxFamilySize is
+        measured on a sub-exposure of at most that size centered on the family instead, with the
+        Footprints of its members temporarily clipped to it (and its children's HeavyFootprints thereby
+        replaced by plain ones), so the pixels read at once are bounded; measurements of sources that
+        extend outside it will be truncated or flagged by the algorithms.
+
+        Because the noise replacer estimates the background noise from each tile, the noise used to
+        replace neighbors is not identical to that used by run() on the full exposure.
+
+        @param[in,out]  measCat      lsst.afw.table.SourceCatalog to be filled with outputs, as in run().
+        @param[in]      readExposure Callable taking an lsst.afw.geom.Box2I (in parent pixel coordinates)
+                                     and returning an lsst.afw.image.ExposureF containing those pixels,
+                                     e.g. `lambda box: lsst.afw.image.ExposureF(filename, box)` or a
+                                     butler "_sub" dataset, either of which reads only the requested
+                                     region from disk.
+        @param[in]      bbox         lsst.afw.geom.Box2I of the full exposure, in parent pixel coordinates.
+        @param[in]      noiseImage, exposureId, beginOrder, endOrder   As in run().
+        """
+        assert measCat.getSchema().contains(self.schema)
+        tileSize = self.config.tileSize
+        halo = self.config.tileHalo
+        maxFamilySize = self.config.tileMaxFamilySize
+        if maxFamilySize is None:
+            maxFamilySize = tileSize + 2*halo
+
+        # Find the bounding box and the catalog indices of each family, and the index of its parent
+        familyBoxes = {}
+        members = {}
+        parentIndices = {}
+        for index, measRecord in enumerate(measCat):
+            parentId = measRecord.getParent() or measRecord.getId()
+            members.setdefault(parentId, []).append(index)
+            if measRecord.getParent() == 0 and measRecord.getFootprint() is not None:
+                parentIndices[parentId] = index
+            if measRecord.getFootprint() is None:
+                continue
+            familyBox = familyBoxes.setdefault(parentId, lsst.afw.geom.Box2I())
+            familyBox.include(measRecord.getFootprint().getBBox())
+        nTilesX = (bbox.getWidth() + tileSize - 1)//tileSize
+        nTilesY = (bbox.getHeight() + tileSize - 1)//tileSize
+
+        def getTileRegion(i, j):
+            region = lsst.afw.geom.Box2I(bbox.getMin() + lsst.afw.geom.Extent2I(i*tileSize, j*tileSize),
+                                         lsst.afw.geom.Extent2I(tileSize, tileSize))
+            region.grow(halo)
+            region.clip(bbox)
+            return region
+
+        def getTileRange(box, border):
+            """Return the ranges of tile indices whose regions, grown by border, may overlap box"""
+            def clamp(n, nTiles):
+                return min(max(n, 0), nTiles - 1)
+            x0, y0 = bbox.getMinX(), bbox.getMinY()
+            return (xrange(clamp((box.getMinX() - border - x0)//tileSize, nTilesX),
+                           clamp((box.getMaxX() + border - x0)//tileSize, nTilesX) + 1),
+                    xrange(clamp((box.getMinY() - border - y0)//tileSize, nTilesY),
+                           clamp((box.getMaxY() + border - y0)//tileSize, nTilesY) + 1))
+
+        # Assign each family to a tile (if it fits in one), and record the parents of the families that
+        # overlap each tile region, so neither the tiles nor the straddlers have to search the catalog.
+        tiles = {}
+        neighbors = {}
+        straddlers = []
+        for parentId, familyBox in familyBoxes.iteritems():
+            center = lsst.afw.geom.Box2D(familyBox).getCenter()
+            i = min(max(int((center.getX() - bbox.getMinX())//tileSize), 0), nTilesX - 1)
+            j = min(max(int((center.getY() - bbox.getMinY())//tileSize), 0), nTilesY - 1)
+            if getTileRegion(i, j).contains(familyBox):
+                tiles.setdefault((i, j), set()).add(parentId)
+            else:
+                straddlers.append(parentId)
+            if parentId not in parentIndices:
+                continue
+            xRange, yRange = getTileRange(familyBox, halo)
+            for i in xRange:
+                for j in yRange:
+                    if getTileRegion(i, j).overlaps(familyBox):
+                        neighbors.setdefault((i, j), []).append(parentId)
+        self.log.info("Measuring %d families in %d tiles, and %d families that straddle tiles"
+                      % (len(familyBoxes) - len(straddlers), len(tiles), len(straddlers)))
+
+        # Every tile's sub-catalog shares measCat's table (and so its metadata), so this is only done once.
+        self._addNoiseMetadata(measCat, exposureId)
+        kwds = dict(noiseImage=noiseImage, exposureId=exposureId, beginOrder=beginOrder, endOrder=endOrder)
+        for (i, j), parentIds in sorted(tiles.iteritems()):
+            region = getTileRegion(i, j)
+            self._measureRegion(measCat, readExposure, region, parentIds, members,
+                                [parentIndices[neighborId] for neighborId in neighbors.get((i, j), ())
+                                 if neighborId not in parentIds],
+                                **kwds)
+        for parentId in straddlers:
+            region = lsst.afw.geom.Box2I(familyBoxes[parentId])
+            region.grow(halo)
+            region.clip(bbox)
+            clip = region.getWidth() > maxFamilySize or region.getHeight() > maxFamilySize
+            if clip:
+                width = min(region.getWidth(), maxFamilySize)
+                height = min(region.getHeight(), maxFamilySize)
+                self.log.warn("Family %d is too large to measure whole (%dx%d pixels); measuring it on a "
+                              "%dx%d sub-exposure with its Footprints clipped"
+                              % (parentId, region.getWidth(), region.getHeight(), width, height))
+                region = lsst.afw.geom.Box2I(
+                    lsst.afw.geom.Point2I(region.getMinX() + (region.getWidth() - width)//2,
+                                          region.getMinY() + (region.getHeight() - height)//2),
+                    lsst.afw.geom.Extent2I(width, height)
+                )
+            # Any family overlapping this region overlaps it within the tile region containing one of the
+            # overlap pixels, so it's a neighbor of one of the tiles the region overlaps.
+            neighborIds = set()
+            xRange, yRange = getTileRange(region, 0)
+            for i in xRange:
+                for j in yRange:
+                    neighborIds.update(neighbors.get((i, j), ()))
+            neighborIds.discard(parentId)
+            self._measureRegion(measCat, readExposure, region, set([parentId]), members,
+                                sorted(parentIndices[neighborId] for neighborId in neighborIds
+                                       if familyBoxes[neighborId].overlaps(region)),
+                                clip=clip, **kwds)
+
+    def _measureRegion(self, measCat, readExposure, region, parentIds, members, neighborIndices,
+                       clip=False, **kwds):
+        """!
+        Measure the given families on a sub-exposure read for the given region, for runTiled().
+
+        members is a dict of {parentId: [catalog indices of the family]}, and neighborIndices a list of
+        the catalog indices of the parents of other families that overlap the region; those are included
+        in the noise replacement, with their Footprints clipped to the region.  The families must lie
+        entirely within the region unless clip is True, in which case their Footprints are clipped to it
+        while they are measured.
+        """
+        exposure = readExposure(region)
+        subCat = lsst.afw.table.SourceCatalog(measCat.getTable())
+        footprints = {}
+        originals = []
+        # Keep the catalog order, so children still follow their parents.
+        for index in sorted(index for parentId in parentIds for index in members[parentId]):
+            measRecord = measCat[index]
+            subCat.append(measRecord)
+            footprint = measRecord.getFootprint()
+            if clip and footprint is not None:
+                originals.append((measRecord, footprint))
+                footprint = lsst.afw.detection.Footprint(footprint)
+                footprint.clipTo(region)
+                measRecord.setFootprint(footprint)
+            footprints[measRecord.getId()] = (measRecord.getParent(), footprint)
+        for index in neighborIndices:
+            measRecord = measCat[index]
+            footprint = lsst.afw.detection.Footprint(measRecord.getFootprint())
+            footprint.clipTo(region)
+            footprints[measRecord.getId()] = (0, footprint)
+        try:
+            self._measureFamilies(subCat, exposure, footprints, **kwds)
+        finally:
+            for measRecord, footprint in originals:
+                measRecord.setFootprint(footprint)
+
+    def _addNoiseMetadata(self, measCat, exposureId):
+        """!Record the noise replacement parameters in measCat's metadata, if it has any"""
+        if not self.config.doReplaceWithNoise:
+            return
+        algMetadata = measCat.getMetadata()
+        if not algMetadata is None:
+            algMetadata.addInt("NOISE_SEED_MULTIPLIER", self.config.noiseReplacer.noiseSeedMultiplier)
+            algMetadata.addString("NOISE_SOURCE", self.config.noiseReplacer.noiseSource)
+            algMetadata.addDouble("NOISE_OFFSET", self.config.noiseReplacer.noiseOffset)
+            if not exposureId is None:
+                algMetadata.addLong("NOISE_EXPOSURE_ID", exposureId)
+
+    def _measureFamilies(self, measCat, exposure, footprints, noiseImage=None, exposureId=None,
+                         beginOrder=None, endOrder=None):
+        """!
+        Measure every family in measCat, replacing all the given footprints with noise first
+
+        This is the implementation of run(); footprints is a dict of {id: (parent, footprint)} that must
+        include every record in measCat, and may include other sources to be replaced with noise.  The
+        caller is responsible for recording the noise replacement parameters (see _addNoiseMetadata).
+        """
+        # Blendedness compares each source's pixels to the original image with no noise replacement;
+        # keep a copy of that image (if it's about to be noise-replaced) so it can be measured as we
+        # visit each family, rather than in a second pass over the catalog after noiseReplacer.end().
+        # Noise replacement only writes the image plane (and mask bits Blendedness doesn't read), so
+        # that's all we copy; the mask and variance are shared with the exposure.
+        if self.doBlendedness:
+            originalImage = exposure.getMaskedImage()
+            if self.config.doReplaceWithNoise:
+                image = originalImage.getImage()
+                originalImage = originalImage.Factory(image.Factory(image, True), originalImage.getMask(),
+                                                      originalImage.getVariance())
 
         # noiseReplacer is used to fill the footprints with noise and save heavy footprints
         # of the source pixels so that they can be restored one at a time for measurement.
@@ -290,13 +516,6 @@ class SingleFrameMeasurementTask(BaseMeasurementTask):
         if self.config.doReplaceWithNoise:
             noiseReplacer = NoiseReplacer(self.config.noiseReplacer, exposure, footprints,
                                           noiseImage=noiseImage, log=self.log, exposureId=exposureId)
-            algMetadata = measCat.getMetadata()
-            if not algMetadata is None:
-                algMetadata.addInt("NOISE_SEED_MULTIPLIER", self.config.noiseReplacer.noiseSeedMultiplier)
-                algMetadata.addString("NOISE_SOURCE", self.config.noiseReplacer.noiseSource)
-                algMetadata.addDouble("NOISE_OFFSET", self.config.noiseReplacer.noiseOffset)
-                if not exposureId is None:
-                    algMetadata.addLong("NOISE_EXPOSURE_ID", exposureId)
         else:
             noiseReplacer = DummyNoiseReplacer()
 
@@ -307,6 +526,7 @@ class SingleFrameMeasurementTask(BaseMeasurementTask):
         self.log.info("Measuring %d sources (%d parents, %d children) "
                       % (len(measCat), len(measParentCat), len(measCat) - len(measParentCat)))
 
+        scratchArena = ScratchArena.getThreadArena()
         for parentIdx, measParentRecord in enumerate(measParentCat):
             # first get all the children of this parent, insert footprint in turn, and measure
             measChildCat = measCat.getChildren(measParentRecord.getId())
@@ -326,21 +546,22 @@ class SingleFrameMeasurementTask(BaseMeasurementTask):
 
             if self.doBlendedness:
                 self.blendPlugin.cpp.measureChildPixels(exposure.getMaskedImage(), measParentRecord)
+                # Now that the whole family has its child-pixel moments, compute the blendedness metrics
+                # on the original image.
+                for measChildRecord in measChildCat:
+                    self.blendPlugin.cpp.measureParentPixels(originalImage, measChildRecord)
+                self.blendPlugin.cpp.measureParentPixels(originalImage, measParentRecord)
 
-                # Finally, process both the parent and the child set through measureN
+            # Finally, process both the parent and the child set through measureN
             self.callMeasureN(measParentCat[parentIdx:parentIdx+1], exposure,
                     beginOrder=beginOrder, endOrder=endOrder)
             self.callMeasureN(measChildCat, exposure, beginOrder=beginOrder, endOrder=endOrder)
             noiseReplacer.removeSource(measParentRecord.getId())
+            # release the temporary images the algorithms made for this family
+            scratchArena.reset()
         # when done, restore the exposure to its original state
         noiseReplacer.end()
 
-        # Now we loop over all of the sources one more time to compute the blendedness metrics
-        # on the original image (i.e. with no noise replacement).
-        for source in measCat:
-            if self.doBlendedness:
-                self.blendPlugin.cpp.measureParentPixels(exposure.getMaskedImage(), source)
-
     def measure(self, measCat, exposure):
         """!
         Backwards-compatibility alias for run()
@@ -642,6 +642,36 @@ class TransformTestCase(lsst.utils.tests.TestCase):
         self._runTransform()
         self._checkOutput(baseNames)
 
+    @staticmethod
+    def _reverseCatalog(catalog):
+        """Return a catalog holding the same records as catalog in reverse order, which is therefore not
+        contiguous in memory (when it has more than one record).
+        """
+        result = type(catalog)(catalog.getTable())
+        for record in reversed(list(catalog)):
+            result.append(record)
+        return result
+
+    def testTransformNonContiguous(self, baseNames=None):
+        """
+        Test the operation of the transformation on catalogs that are not contiguous in memory.
+
+        Transformations usually work on column views of their catalogs, which are only available for
+        contiguous catalogs; they must fall back to processing non-contiguous catalogs record by record
+        and give the same results.  See testTransform for the meaning of `baseNames`.
+
+        @param[in]  baseNames  Iterable of the initial parts of measurement field names.
+        """
+        baseNames = baseNames or [self.name]
+        self._populateCatalog(baseNames)
+        self.outputCat.extend(self.inputCat, mapper=self.mapper)
+        self.inputCat = self._reverseCatalog(self.inputCat)
+        self.outputCat = self._reverseCatalog(self.outputCat)
+        self.assertFalse(self.inputCat.isContiguous())
+        self.assertFalse(self.outputCat.isContiguous())
+        self._runTransform(doExtend=False)
+        self._checkOutput(baseNames)
+
     def _checkRegisteredTransform(self, registry, name):
         # If this is a Python-based transform, we can compare directly; if
         # it's wrapped C++, we need to compare the wrapped class.
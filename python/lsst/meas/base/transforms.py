@@ -35,9 +35,10 @@ catalogs.
 
 When a transformer is called, it is handed a `SourceCatalog` containing the
 measurements to be transformed, a `BaseCatalog` in which to store results, and
-information about the WCS and calibration of the data. It may be safely
-assumed that both are contiguous in memory, thus a ColumnView may be used for
-efficient processing. If the transformation is not possible, it should be
+information about the WCS and calibration of the data. Both are usually
+contiguous in memory, in which case a ColumnView may be used for efficient
+processing, but transformations should check `isContiguous()` and fall back
+to iterating over the records otherwise. If the transformation is not possible, it should be
 aborted by throwing an exception; if this happens, the caller should
 assume that the contents of the output catalog are inconsistent.
 
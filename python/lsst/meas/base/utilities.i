@@ -23,10 +23,18 @@
 
 %{
 #include "lsst/meas/base/FluxUtilities.h"
+#include "lsst/meas/base/AffineWcsGrid.h"
+#include "lsst/meas/base/ApplyApCorr.h"
+#include "lsst/meas/base/FootprintTransformer.h"
+#include "lsst/meas/base/SourceFamilies.h"
+#include "lsst/meas/base/CoaddInputCoverage.h"
 #include "lsst/meas/base/CentroidUtilities.h"
 #include "lsst/meas/base/ShapeUtilities.h"
 #include "lsst/meas/base/FlagHandler.h"
 #include "lsst/meas/base/InputUtilities.h"
+#include "lsst/meas/base/PsfImageCache.h"
+#include "lsst/meas/base/ScratchArena.h"
+#include "lsst/meas/base/FastMath.h"
 #include "lsst/afw/table.h"
 %}
 
@@ -51,8 +59,22 @@
 %declareFunctorKey(ShapeResult, lsst::meas::base::ShapeResult)
 %shared_ptr(lsst::meas::base::ShapeResultKey)
 
+%shared_ptr(lsst::meas::base::AffineWcsGrid)
+%shared_ptr(lsst::meas::base::CoaddInputCoverage)
+
 %include "lsst/meas/base/FluxUtilities.h"
+%include "lsst/meas/base/AffineWcsGrid.h"
+%include "lsst/meas/base/ApplyApCorr.h"
+%include "lsst/meas/base/FootprintTransformer.h"
+%template(SizeVector) std::vector<std::size_t>;
+%include "lsst/meas/base/SourceFamilies.h"
+%include "lsst/meas/base/CoaddInputCoverage.h"
 %include "lsst/meas/base/CentroidUtilities.h"
 %include "lsst/meas/base/ShapeUtilities.h"
 %include "lsst/meas/base/FlagHandler.h"
 %include "lsst/meas/base/InputUtilities.h"
+%include "lsst/meas/base/PsfImageCache.h"
+%include "lsst/meas/base/ScratchArena.h"
+%template(makeImageF) lsst::meas::base::ScratchArena::makeImage<float>;
+%template(makeImageD) lsst::meas::base::ScratchArena::makeImage<double>;
+%include "lsst/meas/base/FastMath.h"
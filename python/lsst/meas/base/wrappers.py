@@ -40,7 +40,7 @@ class WrappedForcedPlugin(ForcedPlugin):
         self.cpp.fail(measRecord, error.cpp if error is not None else None)
 
 
-def wrapAlgorithmControl(Base, Control, module=2, hasMeasureN=False):
+def wrapAlgorithmControl(Base, Control, module=2, hasMeasureN=False, doMeasureN=True):
     """!
     Wrap a C++ algorithm's control class into a Python Config class.
 
@@ -55,6 +55,7 @@ def wrapAlgorithmControl(Base, Control, module=2, hasMeasureN=False):
                                  callers' module.
     @param[in] hasMeasureN       Whether the plugin supports fitting multiple objects at once (if so, a
                                  config option to enable/disable this will be added).
+    @param[in] doMeasureN        Default value of that config option; ignored if hasMeasureN is False.
 
     @return a new subclass of lsst.pex.config.Config
 
@@ -69,7 +70,7 @@ def wrapAlgorithmControl(Base, Control, module=2, hasMeasureN=False):
         cls = type(
             Control.__name__.replace("Control", "Config"),
             (Base,),
-            {"doMeasureN": lsst.pex.config.Field(dtype=bool, default=True,
+            {"doMeasureN": lsst.pex.config.Field(dtype=bool, default=doMeasureN,
                                                  doc="whether to run this plugin in multi-object mode")}
             )
         ConfigClass = lsst.pex.config.makeConfigClass(Control, module=module, cls=cls)
@@ -125,6 +126,7 @@ def wrapAlgorithm(Base, AlgClass, factory, executionOrder, name=None, Control=No
     @param[in] **kwds          Additional keyword arguments passed to generateAlgorithmControl, including:
                                - hasMeasureN:  Whether the plugin supports fitting multiple objects at once
                                  (if so, a config option to enable/disable this will be added).
+                               - doMeasureN: The default value of that config option (True if not given).
                                - executionOrder: If not None, an override for the default executionOrder for
                                  this plugin (the default is 2.0, which is usually appropriate for fluxes).
 
@@ -154,7 +156,7 @@ def wrapAlgorithm(Base, AlgClass, factory, executionOrder, name=None, Control=No
 
 
 def wrapSingleFrameAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False, hasMeasureN=False,
-                             **kwds):
+                             measureNArg=True, **kwds):
     """!
     Wrap a C++ SingleFrameAlgorithm class into a Python SingleFramePlugin class.
 
@@ -171,6 +173,9 @@ def wrapSingleFrameAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=
                                If True, a bool doMeasureN field will be added to the generated Config class,
                                and its value will be passed as the last argument when calling the AlgClass
                                constructor.
+    @param[in] measureNArg     Whether the AlgClass constructor takes that doMeasureN bool; ignored if
+                               hasMeasureN is False.  Algorithms that only implement measureN() and leave
+                               the decision to call it to the measurement task can set this to False.
     @param[in] **kwds          Additional keyword arguments passed to the lower-level wrapAlgorithm and
                                wrapAlgorithmControl classes.  These include:
                                - Control: Swigged C++ Control class for the algorithm; AlgClass.Control
@@ -207,13 +212,13 @@ def wrapSingleFrameAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=
     @verbatim
     PropertySet & metadata
     @endverbatim
-    If hasMeasureN, we also append:
+    If hasMeasureN and measureNArg, we also append:
     @verbatim
     bool doMeasureN
     @endverbatim
     If both are True, the metadata PropertySet precedes the doMeasureN bool.
     """
-    if hasMeasureN:
+    if hasMeasureN and measureNArg:
         if needsMetadata:
             def factory(config, name, schema, metadata):
                 return AlgClass(config.makeControl(), name, schema, metadata, config.doMeasureN)
@@ -232,7 +237,7 @@ def wrapSingleFrameAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=
 
 
 def wrapForcedAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False,
-                        hasMeasureN=False, needsSchemaOnly=False, **kwds):
+                        hasMeasureN=False, measureNArg=True, needsSchemaOnly=False, **kwds):
     """!
     Wrap a C++ ForcedAlgorithm class into a Python ForcedPlugin class.
 
@@ -249,6 +254,9 @@ def wrapForcedAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
                                If True, a bool doMeasureN field will be added to the generated Config class,
                                and its value will be passed as the last argument when calling the AlgClass
                                constructor.
+    @param[in] measureNArg     Whether the AlgClass constructor takes that doMeasureN bool; ignored if
+                               hasMeasureN is False.  Algorithms that only implement measureN() and leave
+                               the decision to call it to the measurement task can set this to False.
     @param[in] needsSchemaOnly Whether the algorithm constructor expects a Schema argument (representing the
                                output Schema) rather than the full SchemaMapper (which provides access to
                                both the reference Schema and the output Schema).
@@ -295,7 +303,7 @@ def wrapForcedAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
     @verbatim
     PropertySet & metadata
     @endverbatim
-    If hasMeasureN, we also append:
+    If hasMeasureN and measureNArg, we also append:
     @verbatim
     bool doMeasureN
     @endverbatim
@@ -305,7 +313,7 @@ def wrapForcedAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
         extractSchemaArg = lambda m: m.editOutputSchema()
     else:
         extractSchemaArg = lambda m: m
-    if hasMeasureN:
+    if hasMeasureN and measureNArg:
         if needsMetadata:
             def factory(config, name, schemaMapper, metadata):
                 return AlgClass(config.makeControl(), name, extractSchemaArg(schemaMapper),
@@ -323,10 +331,11 @@ def wrapForcedAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
             def factory(config, name, schemaMapper, metadata):
                 return AlgClass(config.makeControl(), name, extractSchemaArg(schemaMapper))
     return wrapAlgorithm(WrappedForcedPlugin, AlgClass, executionOrder=executionOrder, name=name,
-                         factory=factory, **kwds)
+                         factory=factory, hasMeasureN=hasMeasureN, **kwds)
 
 
-def wrapSimpleAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False, hasMeasureN=False, **kwds):
+def wrapSimpleAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False, hasMeasureN=False,
+                        measureNArg=True, **kwds):
     """!
     Wrap a C++ SimpleAlgorithm class into both a Python SingleFramePlugin and ForcedPlugin classes
 
@@ -343,6 +352,9 @@ def wrapSimpleAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
                                If True, a bool doMeasureN field will be added to the generated Config class,
                                and its value will be passed as the last argument when calling the AlgClass
                                constructor.
+    @param[in] measureNArg     Whether the AlgClass constructor takes that doMeasureN bool; ignored if
+                               hasMeasureN is False.  Algorithms that only implement measureN() and leave
+                               the decision to call it to the measurement task can set this to False.
     @param[in] **kwds          Additional keyword arguments passed to the lower-level wrapAlgorithm and
                                wrapAlgorithmControl classes.  These include:
                                - Control: Swigged C++ Control class for the algorithm; AlgClass.Control
@@ -378,13 +390,15 @@ def wrapSimpleAlgorithm(AlgClass, executionOrder, name=None, needsMetadata=False
     @verbatim
     PropertySet & metadata
     @endverbatim
-    If hasMeasureN, we also append:
+    If hasMeasureN and measureNArg, we also append:
     @verbatim
     bool doMeasureN
     @endverbatim
     If both are True, the metadata PropertySet precedes the doMeasureN bool.
     """
     return (wrapSingleFrameAlgorithm(AlgClass, executionOrder=executionOrder, name=name,
-                                     needsMetadata=needsMetadata, **kwds),
+                                     needsMetadata=needsMetadata, hasMeasureN=hasMeasureN,
+                                     measureNArg=measureNArg, **kwds),
             wrapForcedAlgorithm(AlgClass, executionOrder=executionOrder, name=name,
-                                needsMetadata=needsMetadata, needsSchemaOnly=True, **kwds))
+                                needsMetadata=needsMetadata, hasMeasureN=hasMeasureN,
+                                measureNArg=measureNArg, needsSchemaOnly=True, **kwds))
@@ -0,0 +1,159 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "lsst/meas/base/AffineWcsGrid.h"
+
+namespace lsst { namespace meas { namespace base {
+
+namespace {
+
+// On-sky separation (radians) of two nearby (ra, dec) positions (radians).
+double computeSeparation(afw::geom::Point2D const & a, afw::geom::Point2D const & b) {
+    double dRa = a.getX() - b.getX();
+    dRa -= 2.0*M_PI*std::floor(dRa/(2.0*M_PI) + 0.5);  // wrap into [-pi, pi)
+    return std::hypot(dRa*std::cos(0.5*(a.getY() + b.getY())), a.getY() - b.getY());
+}
+
+/*
+ * The grid most recently returned by AffineWcsGrid::getCached on this thread, with the arguments it was
+ * built from.  Only the Wcs's identity is checked, through a weak pointer so the cache doesn't keep it
+ * (or, through it, a whole exposure's worth of metadata) alive.
+ */
+struct CachedGrid {
+    std::weak_ptr<afw::image::Wcs const> wcs;
+    afw::geom::Box2D bbox;
+    double cellSize;
+    double tolerance;
+    PTR(AffineWcsGrid const) grid;
+};
+
+} // anonymous
+
+AffineWcsGrid::AffineWcsGrid(
+    afw::image::Wcs const & wcs,
+    afw::geom::Box2D const & bbox,
+    double cellSize,
+    afw::geom::Angle tolerance
+) : _wcs(wcs), _origin(bbox.getMin()), _cellSize(cellSize), _nx(0), _ny(0)
+{
+    if (bbox.isEmpty() || !(cellSize > 0.0) || !(tolerance.asRadians() > 0.0)
+        || wcs.getCoordSystem() != afw::coord::ICRS) {
+        return;
+    }
+    _nx = std::max(1, static_cast<int>(std::ceil(bbox.getWidth()/cellSize)));
+    _ny = std::max(1, static_cast<int>(std::ceil(bbox.getHeight()/cellSize)));
+
+    // Evaluate the full Wcs once at every cell corner; adjacent cells share them.
+    std::vector<afw::geom::Point2D> corners;
+    corners.reserve((_nx + 1)*(_ny + 1));
+    for (int j = 0; j <= _ny; ++j) {
+        for (int i = 0; i <= _nx; ++i) {
+            afw::geom::Point2D corner(_origin.getX() + i*cellSize, _origin.getY() + j*cellSize);
+            corners.push_back(wcs.pixelToSky(corner)->getPosition(afw::geom::radians));
+        }
+    }
+
+    _transforms.reserve(_nx*_ny);
+    _valid.reserve(_nx*_ny);
+    for (int j = 0; j < _ny; ++j) {
+        for (int i = 0; i < _nx; ++i) {
+            afw::geom::Point2D center(_origin.getX() + (i + 0.5)*cellSize,
+                                      _origin.getY() + (j + 0.5)*cellSize);
+            afw::geom::AffineTransform transform = wcs.linearizePixelToSky(center, afw::geom::radians);
+            bool valid = true;
+            for (int dj = 0; dj <= 1 && valid; ++dj) {
+                for (int di = 0; di <= 1 && valid; ++di) {
+                    afw::geom::Point2D corner(_origin.getX() + (i + di)*cellSize,
+                                              _origin.getY() + (j + dj)*cellSize);
+                    double const error = computeSeparation(transform(corner),
+                                                           corners[(j + dj)*(_nx + 1) + i + di]);
+                    valid = (error <= tolerance.asRadians());
+                }
+            }
+            _transforms.push_back(transform);
+            _valid.push_back(valid);
+        }
+    }
+}
+
+int AffineWcsGrid::_findCell(afw::geom::Point2D const & position) const {
+    if (_valid.empty()) {
+        return -1;
+    }
+    double const x = (position.getX() - _origin.getX())/_cellSize;
+    double const y = (position.getY() - _origin.getY())/_cellSize;
+    // Points on the far edges of the grid belong to the last cells; NaNs fail these tests.
+    if (!(x >= 0.0 && x <= _nx && y >= 0.0 && y <= _ny)) {
+        return -1;
+    }
+    int const index = std::min(static_cast<int>(y), _ny - 1)*_nx + std::min(static_cast<int>(x), _nx - 1);
+    return _valid[index] ? index : -1;
+}
+
+PTR(AffineWcsGrid const) AffineWcsGrid::getCached(
+    PTR(afw::image::Wcs const) wcs,
+    afw::geom::Box2D const & bbox,
+    double cellSize,
+    afw::geom::Angle tolerance
+) {
+    static thread_local CachedGrid cache;
+    if (!cache.grid || cache.wcs.lock() != wcs || cache.bbox != bbox || cache.cellSize != cellSize
+        || cache.tolerance != tolerance.asRadians()) {
+        cache.grid.reset();
+        cache.grid = std::make_shared<AffineWcsGrid>(*wcs, bbox, cellSize, tolerance);
+        cache.wcs = wcs;
+        cache.bbox = bbox;
+        cache.cellSize = cellSize;
+        cache.tolerance = tolerance.asRadians();
+    }
+    return cache.grid;
+}
+
+afw::coord::IcrsCoord AffineWcsGrid::pixelToSky(afw::geom::Point2D const & position) const {
+    int const index = _findCell(position);
+    if (index < 0) {
+        return _wcs.pixelToSky(position)->toIcrs();
+    }
+    afw::geom::Point2D const sky = _transforms[index](position);
+    afw::geom::Angle ra = sky.getX()*afw::geom::radians;
+    ra.wrap();
+    return afw::coord::IcrsCoord(ra, sky.getY()*afw::geom::radians);
+}
+
+afw::geom::AffineTransform AffineWcsGrid::linearizePixelToSky(afw::geom::Point2D const & position) const {
+    int const index = _findCell(position);
+    if (index < 0) {
+        return _wcs.linearizePixelToSky(position, afw::geom::radians);
+    }
+    return _transforms[index];
+}
+
+int AffineWcsGrid::getValidCellCount() const {
+    return std::count(_valid.begin(), _valid.end(), true);
+}
+
+}}} // namespace lsst::meas::base
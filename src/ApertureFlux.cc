@@ -103,15 +103,13 @@ void ApertureFluxAlgorithm::copyResultToRecord(
     int index
 ) const {
     record.set(_keys[index].fluxKey, result);
-    if (result.getFlag(FAILURE)) {
-        _keys[index].flags.setValue(record, FAILURE, true);
-    }
-    if (result.getFlag(APERTURE_TRUNCATED)) {
-        _keys[index].flags.setValue(record, APERTURE_TRUNCATED, true);
-    }
-    if (result.getFlag(SINC_COEFFS_TRUNCATED)) {
-        _keys[index].flags.setValue(record, SINC_COEFFS_TRUNCATED, true);
+    std::uint64_t mask = 0;
+    for (FlagBits flag : {FAILURE, APERTURE_TRUNCATED, SINC_COEFFS_TRUNCATED}) {
+        if (result.getFlag(flag)) {
+            mask |= FlagHandler::makeMask(flag);
+        }
     }
+    _keys[index].flags.setValues(record, mask, true);
 }
 
 namespace {
@@ -329,6 +327,8 @@ ApertureFluxTransform::ApertureFluxTransform(
                               ApertureFluxAlgorithm::makeFieldPrefix(name, _ctrl.radii[i]) %
                               flag->name).str()).key);
         }
+        _fluxKeys.push_back(FluxResultKey(mapper.getInputSchema()[
+                            ApertureFluxAlgorithm::makeFieldPrefix(name, _ctrl.radii[i])]));
         _magKeys.push_back(MagResultKey::addFields(mapper.editOutputSchema(),
                            ApertureFluxAlgorithm::makeFieldPrefix(name, _ctrl.radii[i])));
     }
@@ -341,23 +341,8 @@ void ApertureFluxTransform::operator()(
     afw::image::Calib const & calib
 ) const {
     checkCatalogSize(inputCatalog, outputCatalog);
-    std::vector<FluxResultKey> fluxKeys;
     for (std::size_t i = 0; i < _ctrl.radii.size(); ++i) {
-        fluxKeys.push_back(FluxResultKey(inputCatalog.getSchema()[
-                           ApertureFluxAlgorithm::makeFieldPrefix(_name, _ctrl.radii[i])]));
-    }
-    afw::table::SourceCatalog::const_iterator inSrc = inputCatalog.begin();
-    afw::table::BaseCatalog::iterator outSrc = outputCatalog.begin();
-    {
-        // While noThrow is in scope, converting a negative flux to a magnitude
-        // returns NaN rather than throwing.
-        NoThrowOnNegativeFluxContext noThrow;
-        for (; inSrc != inputCatalog.end() && outSrc != outputCatalog.end(); ++inSrc, ++outSrc) {
-            for (std::size_t i = 0; i < _ctrl.radii.size(); ++i) {
-                FluxResult fluxResult = fluxKeys[i].get(*inSrc);
-                _magKeys[i].set(*outSrc, calib.getMagnitude(fluxResult.flux, fluxResult.fluxSigma));
-            }
-        }
+        transformFluxColumns(inputCatalog, _fluxKeys[i], outputCatalog, _magKeys[i], calib);
     }
 }
 
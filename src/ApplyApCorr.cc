@@ -0,0 +1,162 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <cmath>
+
+#include "boost/format.hpp"
+
+#include "ndarray.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/base/ApplyApCorr.h"
+
+namespace lsst { namespace meas { namespace base {
+
+ApCorrApplier::ApCorrApplier(afw::table::Schema const & schema, std::string const & name) :
+    _fluxKey(schema.find<Flux>(name + "_flux").key),
+    _fluxSigmaKey(schema.find<FluxErrElement>(name + "_fluxSigma").key),
+    _apCorrKey(schema.find<double>(name + "_apCorr").key),
+    _apCorrSigmaKey(schema.find<double>(name + "_apCorrSigma").key),
+    _apCorrFlagKey(schema.find<afw::table::Flag>(name + "_flag_apCorr").key)
+{
+    std::string const flagName = name + "_flag";
+    try {
+        _fluxFlagKey = schema.find<afw::table::Flag>(flagName).key;
+    } catch (pex::exceptions::TypeError &) {
+        try {
+            _fluxFlagAsDoubleKey = schema.find<double>(flagName).key;
+        } catch (pex::exceptions::TypeError &) {
+            throw LSST_EXCEPT(
+                pex::exceptions::TypeError,
+                (boost::format("Cannot aperture correct %s: field %s must be a Flag (or a double)")
+                 % name % flagName).str()
+            );
+        }
+    }
+}
+
+bool ApCorrApplier::_getFluxFlag(afw::table::BaseRecord const & record) const {
+    if (_fluxFlagKey.isValid()) {
+        return record.get(_fluxFlagKey);
+    }
+    return record.get(_fluxFlagAsDoubleKey) != 0.0;
+}
+
+void ApCorrApplier::_setFluxFlag(afw::table::BaseRecord & record, bool value) const {
+    if (_fluxFlagKey.isValid()) {
+        record.set(_fluxFlagKey, value);
+    } else {
+        record.set(_fluxFlagAsDoubleKey, value ? 1.0 : 0.0);
+    }
+}
+
+void ApCorrApplier::apply(
+    afw::table::SourceCatalog & catalog,
+    afw::math::BoundedField const & apCorrModel,
+    afw::math::BoundedField const & apCorrSigmaModel,
+    bool doFlagApCorrFailures,
+    bool useNaiveFluxSigma
+) const {
+    std::size_t const size = catalog.size();
+    if (size == 0) {
+        return;
+    }
+    ndarray::Array<double,1,1> x = ndarray::allocate(size);
+    ndarray::Array<double,1,1> y = ndarray::allocate(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        afw::geom::Point2D const center = catalog[i].getCentroid();
+        x[i] = center.getX();
+        y[i] = center.getY();
+    }
+
+    // Evaluate the models on all the centroids at once.  If any of them is outside a model's domain,
+    // we have to go back to evaluating source by source to tell which ones failed.
+    ndarray::Array<double,1,1> apCorr;
+    ndarray::Array<double,1,1> apCorrSigma;
+    try {
+        apCorr = apCorrModel.evaluate(x, y);
+        if (!useNaiveFluxSigma) {
+            apCorrSigma = apCorrSigmaModel.evaluate(x, y);
+        }
+    } catch (pex::exceptions::DomainError &) {
+        apCorr = ndarray::Array<double,1,1>();
+    }
+    bool const batched = !apCorr.isEmpty();
+
+    for (std::size_t i = 0; i < size; ++i) {
+        afw::table::SourceRecord & source = catalog[i];
+        // say we've failed when we start; we'll unset these flags when we succeed
+        source.set(_apCorrFlagKey, true);
+        bool const oldFluxFlagState = _getFluxFlag(source);
+        if (doFlagApCorrFailures) {
+            _setFluxFlag(source, true);
+        }
+
+        double corr = 1.0;
+        double corrSigma = 0.0;
+        if (batched) {
+            corr = apCorr[i];
+            if (!useNaiveFluxSigma) {
+                corrSigma = apCorrSigma[i];
+            }
+        } else {
+            afw::geom::Point2D const center(x[i], y[i]);
+            try {
+                corr = apCorrModel.evaluate(center);
+                if (!useNaiveFluxSigma) {
+                    corrSigma = apCorrSigmaModel.evaluate(center);
+                }
+            } catch (pex::exceptions::DomainError &) {
+                continue;
+            }
+        }
+
+        source.set(_apCorrKey, corr);
+        source.set(_apCorrSigmaKey, corrSigma);
+        if (corr <= 0.0 || corrSigma < 0.0) {
+            continue;
+        }
+
+        Flux const flux = source.get(_fluxKey);
+        FluxErrElement const fluxSigma = source.get(_fluxSigmaKey);
+        source.set(_fluxKey, flux*corr);
+        if (useNaiveFluxSigma) {
+            source.set(_fluxSigmaKey, fluxSigma*corr);
+        } else {
+            double const a = fluxSigma/flux;
+            double const b = corrSigma/corr;
+            source.set(_fluxSigmaKey, std::abs(flux*corr)*std::sqrt(a*a + b*b));
+        }
+        source.set(_apCorrFlagKey, false);
+        if (doFlagApCorrFailures) {
+            _setFluxFlag(source, oldFluxFlagState);
+        }
+    }
+}
+
+void ApCorrApplier::flagAll(afw::table::SourceCatalog & catalog) const {
+    for (auto & source : catalog) {
+        source.set(_apCorrFlagKey, true);
+    }
+}
+
+}}} // namespace lsst::meas::base
@@ -21,14 +21,16 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 
-#include "boost/math/special_functions/erf.hpp"
-#include <boost/math/constants/constants.hpp>
+#include "Eigen/Core"
 
 #include "lsst/meas/base/Blendedness.h"
 #include "lsst/afw/detection/HeavyFootprint.h"
 #include "lsst/meas/base/exceptions.h"
+#include "lsst/meas/base/FastMath.h"
 #include "lsst/afw/geom/ellipses/Ellipse.h"
 #include "lsst/afw/geom/ellipses/PixelRegion.h"
 #include "lsst/afw/geom/ellipses/GridTransform.h"
@@ -94,117 +96,143 @@ double computeOldBlendedness(
     return 0.0;
 }
 
-class FluxAccumulator {
+int const N_LANES = 8;
+
+// Bias-corrected absolute value of a pixel: |data| less the expected value of |data| for a pure-noise
+// pixel with this variance, clipped at zero.
+inline float computeAbsData(float data, float variance) {
+    float const sigma = std::sqrt(variance);
+    float const z = data/(static_cast<float>(M_SQRT2)*sigma);
+    float const ez = fastExp(-z*z);  // exp(-0.5*data^2/variance)
+    float const mu = static_cast<float>(std::sqrt(M_PI/2.0))*sigma*ez + 0.5f*data*fastErfc(-z, ez);
+    float const zm = mu/(static_cast<float>(M_SQRT2)*sigma);
+    float const em = fastExp(-zm*zm);  // exp(-0.5*mu^2/variance)
+    float const bias = static_cast<float>(std::sqrt(2.0/M_PI))*sigma*em - mu*fastErfc(zm, em);
+    return std::max(std::abs(data) - bias, 0.0f);
+}
+
+// Gaussian-weighted flux and second-moment sums of both the raw and bias-corrected absolute pixel
+// values, each split over independent lanes so the per-pixel loop can be vectorized.
+class MomentSums {
 public:
 
-    FluxAccumulator() : _w(0.0), _ww(0.0), _wd(0.0) {}
+    enum { RAW=0, ABS=1 };
 
-    void operator()(double, double, float weight, float data) {
-        _w += weight;
-        _ww += weight*weight;
-        _wd += weight*data;
+    MomentSums() {
+        _w.fill(0.0);
+        _ww.fill(0.0);
+        for (int i = 0; i < 2; ++i) {
+            _wd[i].fill(0.0);
+            _wdxx[i].fill(0.0);
+            _wdyy[i].fill(0.0);
+            _wdxy[i].fill(0.0);
+        }
     }
 
-    double getFlux() const { return _w*_wd/_ww; }
-
-protected:
-    double _w;
-    double _ww;
-    double _wd;
-};
-
-
-class ShapeAccumulator : public FluxAccumulator {
-public:
-
-    ShapeAccumulator() : FluxAccumulator(), _wdxx(0.0), _wdyy(0.0), _wdxy(0.0) {}
-
-    void operator()(double x, double y, float weight, float data) {
-        FluxAccumulator::operator()(x, y, weight, data);
-        _wdxx += x*x*weight*data;
-        _wdyy += y*y*weight*data;
-        _wdxy += x*y*weight*data;
+    void add(int lane, double x, double y, float weight, float data, float absData) {
+        _w[lane] += weight;
+        _ww[lane] += weight*weight;
+        double const wRaw = weight*data;
+        double const wAbs = weight*absData;
+        _wd[RAW][lane] += wRaw;
+        _wd[ABS][lane] += wAbs;
+        _wdxx[RAW][lane] += x*x*wRaw;
+        _wdxx[ABS][lane] += x*x*wAbs;
+        _wdyy[RAW][lane] += y*y*wRaw;
+        _wdyy[ABS][lane] += y*y*wAbs;
+        _wdxy[RAW][lane] += x*y*wRaw;
+        _wdxy[ABS][lane] += x*y*wAbs;
     }
 
-    ShapeResult getShape() const {
+    double getFlux(int which) const { return sum(_w)*sum(_wd[which])/sum(_ww); }
+
+    ShapeResult getShape(int which) const {
         // Factor of 2 corrects for bias from weight function (correct is exact for an object
         // with a Gaussian profile.)
+        double const wd = sum(_wd[which]);
         ShapeResult result;
-        result.xx = 2.0*_wdxx/_wd;
-        result.yy = 2.0*_wdyy/_wd;
-        result.xy = 2.0*_wdxy/_wd;
+        result.xx = 2.0*sum(_wdxx[which])/wd;
+        result.yy = 2.0*sum(_wdyy[which])/wd;
+        result.xy = 2.0*sum(_wdxy[which])/wd;
         return result;
     }
 
 private:
-    double _wdxx;
-    double _wdyy;
-    double _wdxy;
+
+    typedef std::array<double, N_LANES> Lanes;
+
+    static double sum(Lanes const & lanes) {
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))
+            + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    Lanes _w;
+    Lanes _ww;
+    Lanes _wd[2];
+    Lanes _wdxx[2];
+    Lanes _wdyy[2];
+    Lanes _wdxy[2];
 };
 
 
-template <typename Accumulator>
 void computeMoments(
     afw::image::MaskedImage<float> const & image,
     afw::geom::Point2D const & centroid,
     afw::geom::ellipses::Quadrupole const & shape,
     double nSigmaWeightMax,
-    Accumulator & accumulatorRaw,
-    Accumulator & accumulatorAbs
+    MomentSums & sums
 ) {
     afw::geom::Box2I bbox = image.getBBox(lsst::afw::image::PARENT);
 
     afw::geom::ellipses::Ellipse ellipse(shape, centroid);
     ellipse.getCore().scale(nSigmaWeightMax);
 
-    // To evaluate an elliptically-symmetric function, we transform points
-    // by the following transform, then evaluate a circularly-symmetric function
-    // at the transformed positions.
-    afw::geom::LinearTransform transform = shape.getGridTransform();
+    // To evaluate an elliptically-symmetric function, we transform points by the shape's grid
+    // transform T, then evaluate a circularly-symmetric function at the transformed positions; we only
+    // need |T d|^2, which is the quadratic form of T^T T.
+    afw::geom::LinearTransform const gridTransform = shape.getGridTransform();
+    Eigen::Matrix2d const transform = gridTransform.getMatrix();
+    float const qxx = transform.col(0).squaredNorm();
+    float const qxy = transform.col(0).dot(transform.col(1));
+    float const qyy = transform.col(1).squaredNorm();
 
-    typedef afw::geom::ellipses::PixelRegion::Iterator SpanIter;    // yields Spans
-    typedef afw::geom::Span::Iterator PointIter;                    // yields Point2I positions
-    typedef afw::image::MaskedImage<float>::const_x_iterator PixelIter;   // yields pixel values
+    auto const imageArray = image.getImage()->getArray();
+    auto const varianceArray = image.getVariance()->getArray();
 
     afw::geom::ellipses::PixelRegion region(ellipse);
-    bool isContained = bbox.contains(region.getBBox());
-    SpanIter const spanEnd = region.end();
-    for (SpanIter spanIter = region.begin(); spanIter != spanEnd; ++spanIter) {
-        afw::geom::Span span = *spanIter;
-        if (!isContained) {
-            if (span.getY() < bbox.getMinY() || span.getY() > bbox.getMaxY()) {
-                continue;
+    for (auto const & regionSpan : region) {
+        int const y = regionSpan.getY();
+        if (y < bbox.getMinY() || y > bbox.getMaxY()) {
+            continue;
+        }
+        int const x0 = std::max(regionSpan.getMinX(), bbox.getMinX());
+        int const x1 = std::min(regionSpan.getMaxX(), bbox.getMaxX());
+        float const * data = imageArray.getData() + (y - image.getY0())*imageArray.getStrides()[0]
+            + (x0 - image.getX0());
+        float const * variance = varianceArray.getData() + (y - image.getY0())*varianceArray.getStrides()[0]
+            + (x0 - image.getX0());
+        double const dy = y - centroid.getY();
+        double const dx0 = x0 - centroid.getX();
+        float const dyTerm = qyy*dy*dy;
+        float const dxyTerm = 2.0f*qxy*dy;
+        // Work through the span in chunks of N_LANES pixels: the transcendental terms for a chunk are
+        // evaluated together (with no library calls, so they vectorize), then summed into the lanes.
+        int const width = x1 - x0 + 1;
+        for (int x = 0; x < width; x += N_LANES) {
+            int const nLanes = std::min(N_LANES, width - x);
+            std::array<float, N_LANES> weight;
+            std::array<float, N_LANES> absData;
+            for (int lane = 0; lane < N_LANES; ++lane) {
+                // Past the end of the span, evaluate harmless values rather than branching.
+                int const i = std::min(x + lane, width - 1);
+                float const dx = dx0 + i;
+                weight[lane] = fastExp(-0.5f*(qxx*dx*dx + dxyTerm*dx + dyTerm));
+                absData[lane] = computeAbsData(data[i], variance[i]);
             }
-            span = afw::geom::Span(
-                span.getY(),
-                std::max(span.getMinX(), bbox.getMinX()),
-                std::min(span.getMaxX(), bbox.getMaxX())
-            );
-            if (span.getMinX() > span.getMaxX()) {
-                continue;
+            for (int lane = 0; lane < nLanes; ++lane) {
+                sums.add(lane, dx0 + x + lane, dy, weight[lane], data[x + lane], absData[lane]);
             }
         }
-        PixelIter pixelIter = image.x_at(
-            span.getBeginX() - image.getX0(),
-            span.getY() - image.getY0()
-        );
-        PointIter const pointEnd = span.end();
-        for (PointIter pointIter = span.begin(); pointIter != pointEnd; ++pointIter, ++pixelIter) {
-            afw::geom::Extent2D d = afw::geom::Point2D(*pointIter) - centroid;
-            afw::geom::Extent2D td = transform(d);
-            // use single precision for faster exp, erf
-            float weight = std::exp(static_cast<float>(-0.5*td.computeSquaredNorm()));
-            float data = pixelIter.image();
-            accumulatorRaw(d.getX(), d.getY(), weight, data);
-            float variance = pixelIter.variance();
-            float mu = (std::sqrt(variance/(2.0f/boost::math::constants::pi<float>()))*
-                        std::exp(-0.5f*(data*data)/variance)) +
-                0.5f*data*boost::math::erfc(-data/std::sqrt(2.0f*variance));
-            float bias = (std::sqrt(2.0f*variance/boost::math::constants::pi<float>())*
-                          std::exp(-0.5f*(mu*mu)/variance)) -
-                mu*boost::math::erfc(mu/std::sqrt(2.0f*variance));
-            accumulatorAbs(d.getX(), d.getY(), weight, std::max(std::abs(data) - bias, 0.0f));
-        }
     }
 }
 
@@ -313,55 +341,42 @@ void BlendednessAlgorithm::_measureMoments(
         }
         if (child.getTable()->getShapeFlagKey().isValid()) {
             if (child.getShapeFlag()) {
-                _flagHandler.setValue(child, NO_SHAPE, true);
-                _flagHandler.setValue(child, FAILURE, true);
+                _flagHandler.setValues(child, FlagHandler::makeMask(NO_SHAPE) | FlagHandler::makeMask(FAILURE),
+                                   true);
             }
         }
         if (!(child.getShape().getDeterminant() >= 0.0)) {
             // shape flag should have been set already, but we're paranoid
-            _flagHandler.setValue(child, NO_SHAPE, true);
-            _flagHandler.setValue(child, FAILURE, true);
+            _flagHandler.setValues(child, FlagHandler::makeMask(NO_SHAPE) | FlagHandler::makeMask(FAILURE),
+                                   true);
             fatal = true;
         }
         if (!(std::isfinite(child.getX()) && std::isfinite(child.getY()))) {
             // shape flag should have been set already, but we're paranoid
-            _flagHandler.setValue(child, NO_CENTROID, true);
-            _flagHandler.setValue(child, FAILURE, true);
+            _flagHandler.setValues(child, FlagHandler::makeMask(NO_CENTROID) | FlagHandler::makeMask(FAILURE),
+                                   true);
             fatal = true;
         }
         if (fatal) return;
     }
 
-    if (_ctrl.doShape) {
-        ShapeAccumulator accumulatorRaw;
-        ShapeAccumulator accumulatorAbs;
+    if (_ctrl.doShape || _ctrl.doFlux) {
+        MomentSums sums;
         computeMoments(
             image,
             child.getCentroid(),
             child.getShape(),
             _ctrl.nSigmaWeightMax,
-            accumulatorRaw,
-            accumulatorAbs
-            );
+            sums
+        );
         if (_ctrl.doFlux) {
-            child.set(fluxRawKey, accumulatorRaw.getFlux());
-            child.set(fluxAbsKey, accumulatorAbs.getFlux());
+            child.set(fluxRawKey, sums.getFlux(MomentSums::RAW));
+            child.set(fluxAbsKey, sums.getFlux(MomentSums::ABS));
+        }
+        if (_ctrl.doShape) {
+            _shapeRawKey.set(child, sums.getShape(MomentSums::RAW));
+            _shapeAbsKey.set(child, sums.getShape(MomentSums::ABS));
         }
-        _shapeRawKey.set(child, accumulatorRaw.getShape());
-        _shapeAbsKey.set(child, accumulatorAbs.getShape());
-    } else if (_ctrl.doFlux) {
-        FluxAccumulator accumulatorRaw;
-        FluxAccumulator accumulatorAbs;
-        computeMoments(
-            image,
-            child.getCentroid(),
-            child.getShape(),
-            _ctrl.nSigmaWeightMax,
-            accumulatorRaw,
-            accumulatorAbs
-        );
-        child.set(fluxRawKey, accumulatorRaw.getFlux());
-        child.set(fluxAbsKey, accumulatorAbs.getFlux());
     }
 }
 
@@ -20,6 +20,7 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
 #include <cmath>
 #include "lsst/meas/base/CentroidUtilities.h"
 #include "lsst/afw/table/BaseRecord.h"
@@ -133,9 +134,14 @@ void CentroidResultKey::set(afw::table::BaseRecord & record, CentroidResult cons
 
 CentroidTransform::CentroidTransform(
     std::string const & name,
-    afw::table::SchemaMapper & mapper
+    afw::table::SchemaMapper & mapper,
+    double wcsGridCellSize,
+    afw::geom::Angle wcsGridTolerance
 ) :
-    BaseTransform{name}
+    BaseTransform{name},
+    _centroidResultKey(mapper.getInputSchema()[name]),
+    _wcsGridCellSize(wcsGridCellSize),
+    _wcsGridTolerance(wcsGridTolerance)
 {
     // Map the flag through to the output
     mapper.addMapping(mapper.getInputSchema().find<afw::table::Flag>(name + "_flag").key);
@@ -147,7 +153,7 @@ CentroidTransform::CentroidTransform(
     // If the centroid has an error key we also include one on the celestial
     // coordinates; otherwise, it isn't necessary. Note that if we provide for
     // errors in celestial coordinates, we always need the full covariance.
-    if (CentroidResultKey(mapper.getInputSchema()[name]).getCentroidErr().isValid()) {
+    if (_centroidResultKey.getCentroidErr().isValid()) {
         std::vector< afw::table::Key<ErrElement> > sigma(2);
         std::vector< afw::table::Key<ErrElement> > cov(1);
         sigma[0] = s.addField<ErrElement>(s.join(name, "raSigma"), "Uncertainty on RA", "rad");
@@ -159,6 +165,40 @@ CentroidTransform::CentroidTransform(
 
 }
 
+namespace {
+
+// Reads the centroids of a catalog by index: straight from the columns when the catalog is contiguous
+// (as those passed to transformations usually are), and record by record when it isn't.
+class CentroidColumns {
+public:
+
+    CentroidColumns(afw::table::SourceCatalog const & catalog, CentroidResultKey const & key) :
+        _catalog(catalog), _key(key.getCentroid()), _contiguous(catalog.isContiguous())
+    {
+        if (_contiguous) {
+            auto const columns = catalog.getColumnView();
+            _x = columns[key.getX()];
+            _y = columns[key.getY()];
+        }
+    }
+
+    afw::geom::Point2D operator()(std::size_t i) const {
+        if (_contiguous) {
+            return afw::geom::Point2D(_x[i], _y[i]);
+        }
+        return _key.get(_catalog[i]);
+    }
+
+private:
+    afw::table::SourceCatalog const & _catalog;
+    afw::table::PointKey<CentroidElement> _key;
+    bool _contiguous;
+    ndarray::Array<CentroidElement const,1,0> _x;
+    ndarray::Array<CentroidElement const,1,0> _y;
+};
+
+} // anonymous
+
 void CentroidTransform::operator()(
     afw::table::SourceCatalog const & inputCatalog,
     afw::table::BaseCatalog & outputCatalog,
@@ -166,23 +206,63 @@ void CentroidTransform::operator()(
     afw::image::Calib const & calib
 ) const {
     checkCatalogSize(inputCatalog, outputCatalog);
-    CentroidResultKey centroidResultKey(inputCatalog.getSchema()[_name]);
+    if (inputCatalog.empty()) {
+        return;
+    }
+    transformCentroids(inputCatalog, outputCatalog, makeWcsGrid(inputCatalog, wcs));
+}
+
+AffineWcsGrid CentroidTransform::makeWcsGrid(
+    afw::table::SourceCatalog const & inputCatalog,
+    afw::image::Wcs const & wcs
+) const {
+    // Each grid cell costs a linearization and (up to) four full Wcs evaluations, so the grid only
+    // pays for itself where there are several sources per cell.
+    int const MIN_SOURCES_PER_CELL = 4;
+
+    afw::geom::Box2D bbox;
+    if (_wcsGridTolerance.asRadians() > 0.0 && !inputCatalog.empty()) {
+        CentroidColumns const columns(inputCatalog, _centroidResultKey);
+        for (std::size_t i = 0; i < inputCatalog.size(); ++i) {
+            afw::geom::Point2D const centroid = columns(i);
+            if (std::isfinite(centroid.getX()) && std::isfinite(centroid.getY())) {
+                bbox.include(centroid);
+            }
+        }
+        double const nCells = std::ceil(std::max(bbox.getWidth(), 1.0)/_wcsGridCellSize)*
+                              std::ceil(std::max(bbox.getHeight(), 1.0)/_wcsGridCellSize);
+        if (inputCatalog.size() < MIN_SOURCES_PER_CELL*nCells) {
+            bbox = afw::geom::Box2D();
+        }
+    }
+    return AffineWcsGrid(wcs, bbox, _wcsGridCellSize, _wcsGridTolerance);
+}
+
+void CentroidTransform::transformCentroids(
+    afw::table::SourceCatalog const & inputCatalog,
+    afw::table::BaseCatalog & outputCatalog,
+    AffineWcsGrid const & grid
+) const {
+    if (inputCatalog.empty()) {
+        return;
+    }
 
-    afw::table::SourceCatalog::const_iterator inSrc = inputCatalog.begin();
-    afw::table::BaseCatalog::iterator outSrc = outputCatalog.begin();
+    CentroidColumns const columns(inputCatalog, _centroidResultKey);
+    bool const hasErr = _centroidResultKey.getCentroidErr().isValid();
 
-    for (; inSrc != inputCatalog.end() && outSrc != outputCatalog.end(); ++inSrc, ++outSrc) {
-        CentroidResult centroidResult = centroidResultKey.get(*inSrc);
+    std::size_t const size = inputCatalog.size();
+    for (std::size_t i = 0; i < size; ++i) {
+        afw::geom::Point2D const centroid = columns(i);
+        afw::table::BaseRecord & outSrc = outputCatalog[i];
 
-        _coordKey.set(*outSrc, *wcs.pixelToSky(centroidResult.getCentroid()));
+        _coordKey.set(outSrc, grid.pixelToSky(centroid));
 
-        if (centroidResultKey.getCentroidErr().isValid()) {
-            CentroidCov centroidCov = centroidResult.getCentroidErr();
+        if (hasErr) {
+            CentroidCov centroidCov = _centroidResultKey.getCentroidErr().get(inputCatalog[i]);
             if (!(std::isnan(centroidCov(0,0)) || std::isnan(centroidCov(1,1)))) {
-                auto transform = wcs.linearizePixelToSky(centroidResult.getCentroid(),
-                                                         afw::geom::radians).getLinear().getMatrix();
-                _coordErrKey.set(*outSrc, (transform * centroidResult.getCentroidErr().cast<double>() *
-                                           transform.transpose()).cast<ErrElement>());
+                auto transform = grid.linearizePixelToSky(centroid).getLinear().getMatrix();
+                _coordErrKey.set(outSrc, (transform * centroidCov.cast<double>() *
+                                          transform.transpose()).cast<ErrElement>());
             }
         }
     }
@@ -0,0 +1,197 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/coord/Coord.h"
+#include "lsst/meas/base/CoaddInputCoverage.h"
+
+namespace lsst { namespace meas { namespace base {
+
+namespace {
+
+/*
+ * The map most recently returned by CoaddInputCoverage::getCached on this thread, with the arguments it
+ * was built from.  The map holds its own references to the inputs and a copy of the Wcs, so the cache
+ * only needs weak pointers to recognize them.
+ */
+struct CachedCoverage {
+    std::weak_ptr<afw::image::CoaddInputs const> inputs;
+    std::weak_ptr<afw::image::Wcs const> wcs;
+    afw::geom::Box2I bbox;
+    int cellSize;
+    PTR(CoaddInputCoverage const) coverage;
+};
+
+} // anonymous
+
+CoaddInputCoverage::CoaddInputCoverage(
+    afw::table::ExposureCatalog const & ccds,
+    afw::image::Wcs const & wcs,
+    afw::geom::Box2I const & bbox,
+    int cellSize
+) : _ccds(ccds), _wcs(wcs.clone()), _origin(afw::geom::Box2D(bbox).getMin()), _cellSize(cellSize),
+    _nx(0), _ny(0)
+{
+    if (bbox.isEmpty() || cellSize <= 0) {
+        return;
+    }
+    _nx = (bbox.getWidth() + cellSize - 1)/cellSize;
+    _ny = (bbox.getHeight() + cellSize - 1)/cellSize;
+    _counts.assign((_nx + 1)*(_ny + 1), 0);
+    _uniform.assign(_nx*_ny, true);
+
+    // Evaluate the coadd Wcs once at every cell corner; each input then only needs its own Wcs.
+    std::vector<PTR(afw::coord::Coord)> corners;
+    corners.reserve((_nx + 1)*(_ny + 1));
+    for (int j = 0; j <= _ny; ++j) {
+        for (int i = 0; i <= _nx; ++i) {
+            corners.push_back(wcs.pixelToSky(_origin + afw::geom::Extent2D(i*cellSize, j*cellSize)));
+        }
+    }
+
+    std::vector<char> inside;
+    for (auto const & ccd : ccds) {
+        CONST_PTR(afw::image::Wcs) ccdWcs = ccd.getWcs();
+        if (!ccdWcs) {
+            std::ostringstream os;
+            os << "Coadd input " << ccd.getId() << " has no Wcs";
+            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+        }
+        // Find the input's corners on the coadd.  Cells containing one can't be uniform, and every
+        // grid corner that may be in the input is within a cell of their bounding box.
+        afw::geom::Box2D region;
+        for (auto const & corner : afw::geom::Box2D(ccd.getBBox()).getCorners()) {
+            afw::geom::Point2D const position = wcs.skyToPixel(*ccdWcs->pixelToSky(corner));
+            region.include(position);
+            double const x = (position.getX() - _origin.getX())/cellSize;
+            double const y = (position.getY() - _origin.getY())/cellSize;
+            if (x >= 0.0 && x < _nx && y >= 0.0 && y < _ny) {
+                _uniform[static_cast<int>(y)*_nx + static_cast<int>(x)] = false;
+            }
+        }
+        if (region.isEmpty()) {
+            continue;
+        }
+        afw::geom::Box2D const cells(
+            afw::geom::Point2D((region.getMin() - _origin)/cellSize),
+            afw::geom::Point2D((region.getMax() - _origin)/cellSize)
+        );
+        int const i0 = std::max(0, static_cast<int>(std::floor(cells.getMinX())) - 1);
+        int const j0 = std::max(0, static_cast<int>(std::floor(cells.getMinY())) - 1);
+        int const i1 = std::min(_nx, static_cast<int>(std::ceil(cells.getMaxX())) + 1);
+        int const j1 = std::min(_ny, static_cast<int>(std::ceil(cells.getMaxY())) + 1);
+        if (i0 > i1 || j0 > j1) {
+            continue;
+        }
+        int const width = i1 - i0 + 1;
+        inside.assign(width*(j1 - j0 + 1), false);
+        for (int j = j0; j <= j1; ++j) {
+            for (int i = i0; i <= i1; ++i) {
+                if (ccd.contains(*corners[j*(_nx + 1) + i])) {
+                    inside[(j - j0)*width + i - i0] = true;
+                    ++_counts[j*(_nx + 1) + i];
+                }
+            }
+        }
+        for (int j = j0; j < j1; ++j) {
+            for (int i = i0; i < i1; ++i) {
+                char const * lower = &inside[(j - j0)*width + i - i0];
+                char const * upper = lower + width;
+                if (lower[0] != lower[1] || lower[0] != upper[0] || lower[0] != upper[1]) {
+                    _uniform[j*_nx + i] = false;
+                }
+            }
+        }
+    }
+}
+
+PTR(CoaddInputCoverage const) CoaddInputCoverage::getCached(
+    PTR(afw::image::CoaddInputs const) inputs,
+    PTR(afw::image::Wcs const) wcs,
+    afw::geom::Box2I const & bbox,
+    int cellSize
+) {
+    static thread_local CachedCoverage cache;
+    if (!cache.coverage || cache.inputs.lock() != inputs || cache.wcs.lock() != wcs || cache.bbox != bbox
+        || cache.cellSize != cellSize) {
+        cache.coverage.reset();
+        cache.coverage = std::make_shared<CoaddInputCoverage>(inputs->ccds, *wcs, bbox, cellSize);
+        cache.inputs = inputs;
+        cache.wcs = wcs;
+        cache.bbox = bbox;
+        cache.cellSize = cellSize;
+    }
+    return cache.coverage;
+}
+
+int CoaddInputCoverage::countContaining(afw::geom::Point2D const & position) const {
+    double const x = (position.getX() - _origin.getX())/_cellSize;
+    double const y = (position.getY() - _origin.getY())/_cellSize;
+    // Points on the far edges of the grid belong to the last cells; NaNs fail these tests.
+    if (!_uniform.empty() && x >= 0.0 && x <= _nx && y >= 0.0 && y <= _ny) {
+        int const i = std::min(static_cast<int>(x), _nx - 1);
+        int const j = std::min(static_cast<int>(y), _ny - 1);
+        if (_uniform[j*_nx + i]) {
+            return _counts[j*(_nx + 1) + i];
+        }
+    }
+    PTR(afw::coord::Coord) coord = _wcs->pixelToSky(position);
+    int count = 0;
+    for (auto const & ccd : _ccds) {
+        if (ccd.contains(*coord)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int CoaddInputCoverage::computeMinCount(afw::geom::Box2D const & region) const {
+    if (_counts.empty() || region.isEmpty()) {
+        return -1;
+    }
+    int const i0 = std::max(0, static_cast<int>(std::ceil((region.getMinX() - _origin.getX())/_cellSize)));
+    int const j0 = std::max(0, static_cast<int>(std::ceil((region.getMinY() - _origin.getY())/_cellSize)));
+    int const i1 = std::min(_nx, static_cast<int>(std::floor((region.getMaxX() - _origin.getX())/_cellSize)));
+    int const j1 = std::min(_ny, static_cast<int>(std::floor((region.getMaxY() - _origin.getY())/_cellSize)));
+    int result = -1;
+    for (int j = j0; j <= j1; ++j) {
+        for (int i = i0; i <= i1; ++i) {
+            int const count = _counts[j*(_nx + 1) + i];
+            if (result < 0 || count < result) {
+                result = count;
+            }
+        }
+    }
+    return result;
+}
+
+int CoaddInputCoverage::getUniformCellCount() const {
+    return std::count(_uniform.begin(), _uniform.end(), true);
+}
+
+}}} // namespace lsst::meas::base
@@ -0,0 +1,68 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <array>
+#include <limits>
+
+#include "lsst/afw/cameraGeom/Detector.h"
+#include "lsst/afw/table/Source.h"
+#include "lsst/meas/base/FPPosition.h"
+
+namespace lsst { namespace meas { namespace base {
+
+FPPositionAlgorithm::FPPositionAlgorithm(
+    Control const & ctrl,
+    std::string const & name,
+    afw::table::Schema & schema
+) : _focalPlaneKey(
+        afw::table::PointKey<double>::addFields(schema, name, "Position on the focal plane", "mm")
+    )
+{
+    static std::array<FlagDefinition,N_FLAGS> const flagDefs = {{
+        {"flag", "Set to True for any fatal failure"},
+        {"missingDetector_flag", "Set to True if detector object is missing"}
+    }};
+    _flagHandler = FlagHandler::addFields(schema, name, flagDefs.begin(), flagDefs.end());
+}
+
+void FPPositionAlgorithm::measure(
+    afw::table::SourceRecord & measRecord,
+    afw::image::Exposure<float> const & exposure
+) const {
+    CONST_PTR(afw::cameraGeom::Detector) detector = exposure.getDetector();
+    if (!detector) {
+        _flagHandler.setValue(measRecord, MISSING_DETECTOR, true);
+        double const nan = std::numeric_limits<double>::quiet_NaN();
+        measRecord.set(_focalPlaneKey, afw::geom::Point2D(nan, nan));
+        return;
+    }
+    afw::cameraGeom::CameraPoint const pixels =
+        detector->makeCameraPoint(measRecord.getCentroid(), afw::cameraGeom::PIXELS);
+    measRecord.set(_focalPlaneKey, detector->transform(pixels, afw::cameraGeom::FOCAL_PLANE).getPoint());
+}
+
+void FPPositionAlgorithm::fail(afw::table::SourceRecord & measRecord, MeasurementError * error) const {
+    _flagHandler.handleFailure(measRecord, error);
+}
+
+}}} // namespace lsst::meas::base
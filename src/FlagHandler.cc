@@ -21,6 +21,8 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
+
 #include "lsst/meas/base/FlagHandler.h"
 
 namespace lsst { namespace meas { namespace base {
@@ -41,6 +43,7 @@ FlagHandler FlagHandler::addFields(
             )
         );
     }
+    r._makeWords();
     return r;
 }
 
@@ -59,6 +62,7 @@ FlagHandler FlagHandler::addFields(
             )
         );
     }
+    r._makeWords();
     return r;
 }
 
@@ -72,16 +76,94 @@ FlagHandler::FlagHandler(
         afw::table::Key<afw::table::Flag> key = s[iter->name];
         _vector.push_back(std::make_pair(*iter, key));
     }
+    _makeWords();
+}
+
+void FlagHandler::_makeWords() {
+    _words.clear();
+    std::size_t const numFlags = std::min(_vector.size(), std::size_t(64));
+    for (std::size_t i = 0; i < numFlags; ++i) {
+        afw::table::Key<afw::table::Flag> const & key = _vector[i].second;
+        auto word = std::find_if(_words.begin(), _words.end(), [&key](FlagWord const & w) {
+            return w.key.getOffset() == key.getOffset();
+        });
+        if (word == _words.end()) {
+            _words.push_back(FlagWord{key, makeMask(i)});
+        } else {
+            word->flags |= makeMask(i);
+        }
+    }
+}
+
+std::int64_t FlagHandler::_getWordBits(FlagWord const & word, std::uint64_t mask) const {
+    std::int64_t bits = 0;
+    std::uint64_t m = word.flags & mask;
+    for (std::size_t i = 0; m; ++i, m >>= 1) {
+        if (m & 1) {
+            bits |= std::int64_t(1) << _vector[i].second.getBit();
+        }
+    }
+    return bits;
+}
+
+void FlagHandler::setValues(afw::table::BaseRecord & record, std::uint64_t mask, bool value) const {
+    for (auto const & word : _words) {
+        std::int64_t const bits = _getWordBits(word, mask);
+        if (bits) {
+            std::int64_t * element = record.getElement(word.key);
+            *element = value ? (*element | bits) : (*element & ~bits);
+        }
+    }
+}
+
+bool FlagHandler::anySet(afw::table::BaseRecord const & record, std::uint64_t mask) const {
+    for (auto const & word : _words) {
+        if (*record.getElement(word.key) & _getWordBits(word, mask)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Catalog>
+void FlagHandler::_clearAll(Catalog & catalog, std::size_t begin, std::size_t end) const {
+    std::vector<std::pair<afw::table::Key<afw::table::Flag>, std::int64_t>> masks;
+    for (auto const & word : _words) {
+        masks.push_back(std::make_pair(word.key, ~_getWordBits(word, getAllMask())));
+    }
+    end = std::min(end, catalog.size());
+    for (std::size_t n = begin; n < end; ++n) {
+        afw::table::BaseRecord & record = catalog[n];
+        for (auto const & mask : masks) {
+            *record.getElement(mask.first) &= mask.second;
+        }
+        for (std::size_t i = 64; i < _vector.size(); ++i) {
+            record.set(_vector[i].second, false);
+        }
+    }
+}
+
+void FlagHandler::clearAll(afw::table::BaseCatalog & catalog, std::size_t begin, std::size_t end) const {
+    _clearAll(catalog, begin, end);
+}
+
+void FlagHandler::clearAll(afw::table::SourceCatalog & catalog, std::size_t begin, std::size_t end) const {
+    _clearAll(catalog, begin, end);
 }
 
 void FlagHandler::handleFailure(afw::table::BaseRecord & record, MeasurementError const * error) const {
     std::size_t const numFlags = _vector.size();
     assert(numFlags > 0);  // We need a general failure flag
-    record.set(_vector[0].second, true);
+    std::uint64_t mask = makeMask(FAILURE);
     if (error) {
         assert(numFlags > error->getFlagBit());  // We need the particular flag
-        record.set(_vector[error->getFlagBit()].second, true);
+        if (error->getFlagBit() >= 64) {
+            record.set(_vector[error->getFlagBit()].second, true);
+        } else {
+            mask |= makeMask(error->getFlagBit());
+        }
     }
+    setValues(record, mask, true);
 }
 
 
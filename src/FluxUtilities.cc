@@ -85,7 +85,8 @@ FluxTransform::FluxTransform(
     std::string const & name,
     afw::table::SchemaMapper & mapper
 ) :
-    BaseTransform{name}
+    BaseTransform{name},
+    _fluxKey(mapper.getInputSchema()[name])
 {
     // Map the flag through to the output
     mapper.addMapping(mapper.getInputSchema().find<afw::table::Flag>(name + "_flag").key);
@@ -101,17 +102,40 @@ void FluxTransform::operator()(
     afw::image::Calib const & calib
 ) const {
     checkCatalogSize(inputCatalog, outputCatalog);
-    FluxResultKey fluxKey(inputCatalog.getSchema()[_name]);
-    afw::table::SourceCatalog::const_iterator inSrc = inputCatalog.begin();
-    afw::table::BaseCatalog::iterator outSrc = outputCatalog.begin();
-    {
-        // While noThrow is in scope, converting a negative flux to a magnitude
-        // returns NaN rather than throwing.
-        NoThrowOnNegativeFluxContext noThrow;
-        for (; inSrc != inputCatalog.end() && outSrc != outputCatalog.end(); ++inSrc, ++outSrc) {
-            FluxResult fluxResult = fluxKey.get(*inSrc);
-            _magKey.set(*outSrc, calib.getMagnitude(fluxResult.flux, fluxResult.fluxSigma));
+    transformFluxColumns(inputCatalog, _fluxKey, outputCatalog, _magKey, calib);
+}
+
+void transformFluxColumns(
+    afw::table::SourceCatalog const & inputCatalog,
+    FluxResultKey const & fluxKey,
+    afw::table::BaseCatalog & outputCatalog,
+    MagResultKey const & magKey,
+    afw::image::Calib const & calib
+) {
+    if (inputCatalog.empty()) {
+        return;
+    }
+    // While noThrow is in scope, converting a negative flux to a magnitude
+    // returns NaN rather than throwing.
+    NoThrowOnNegativeFluxContext noThrow;
+    int const size = inputCatalog.size();
+    if (!inputCatalog.isContiguous() || !outputCatalog.isContiguous()) {
+        for (int i = 0; i < size; ++i) {
+            magKey.set(outputCatalog[i], calib.getMagnitude(inputCatalog[i].get(fluxKey.getFlux()),
+                                                            inputCatalog[i].get(fluxKey.getFluxSigma())));
         }
+        return;
+    }
+    auto const inputColumns = inputCatalog.getColumnView();
+    auto const outputColumns = outputCatalog.getColumnView();
+    auto const flux = inputColumns[fluxKey.getFlux()];
+    auto const fluxSigma = inputColumns[fluxKey.getFluxSigma()];
+    auto const mag = outputColumns[magKey.getMag()];
+    auto const magErr = outputColumns[magKey.getMagErr()];
+    for (int i = 0; i < size; ++i) {
+        std::pair<double,double> const magResult = calib.getMagnitude(flux[i], fluxSigma[i]);
+        mag[i] = magResult.first;
+        magErr[i] = magResult.second;
     }
 }
 
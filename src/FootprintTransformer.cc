@@ -0,0 +1,257 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "ndarray.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/geom/AffineTransform.h"
+#include "lsst/afw/detection/HeavyFootprint.h"
+#include "lsst/meas/base/FootprintTransformer.h"
+
+namespace lsst { namespace meas { namespace base {
+
+namespace {
+
+typedef afw::detection::HeavyFootprint<float> HeavyFootprintF;
+
+// The spans of a Footprint sorted for lookup, with the offset of each into its pixel arrays.
+class SpanLookup {
+public:
+
+    explicit SpanLookup(afw::detection::Footprint const & footprint) {
+        int offset = 0;
+        _spans.reserve(footprint.getSpans().size());
+        for (auto const & span : footprint.getSpans()) {
+            _spans.push_back(Entry{span->getY(), span->getX0(), span->getX1(), offset});
+            offset += span->getWidth();
+        }
+        std::sort(_spans.begin(), _spans.end(),
+                  [](Entry const & a, Entry const & b) { return a.y < b.y || (a.y == b.y && a.x0 < b.x0); });
+    }
+
+    // Return the offset of pixel (x, y) in the Footprint's pixel arrays, or -1 if it isn't in it.
+    int find(int x, int y) const {
+        auto iter = std::lower_bound(
+            _spans.begin(), _spans.end(), std::make_pair(y, x),
+            [](Entry const & e, std::pair<int,int> const & p) {
+                return e.y < p.first || (e.y == p.first && e.x1 < p.second);
+            }
+        );
+        if (iter == _spans.end() || iter->y != y || iter->x0 > x) {
+            return -1;
+        }
+        return iter->offset + x - iter->x0;
+    }
+
+private:
+    struct Entry { int y; int x0; int x1; int offset; };
+    std::vector<Entry> _spans;
+};
+
+inline int roundToInt(double x) { return static_cast<int>(std::floor(x + 0.5)); }
+
+} // anonymous
+
+FootprintTransformer::FootprintTransformer(
+    CONST_PTR(afw::image::Wcs) source,
+    CONST_PTR(afw::image::Wcs) target,
+    afw::geom::Box2I const & region,
+    double maxError,
+    bool keepHeavy
+) : _source(source), _target(target), _region(region), _maxError(maxError), _keepHeavy(keepHeavy)
+{}
+
+PTR(afw::detection::Footprint) FootprintTransformer::operator()(
+    afw::detection::Footprint const & footprint
+) const {
+    afw::geom::Box2D const bbox(footprint.getBBox());
+    if (!(_maxError > 0.0) || footprint.getSpans().empty()) {
+        return footprint.transform(*_source, *_target, _region);
+    }
+
+    // Linearize the source-to-target pixel mapping about the centre of the Footprint, and check it
+    // against the full mapping at the corners of its bounding box.
+    afw::geom::Point2D const center = bbox.getCenter();
+    PTR(afw::coord::Coord) const sky = _source->pixelToSky(center);
+    afw::geom::AffineTransform const toTarget =
+        _target->linearizeSkyToPixel(*sky, afw::geom::degrees) *
+        _source->linearizePixelToSky(center, afw::geom::degrees);
+    afw::geom::Box2D targetBoxD;
+    for (auto const & corner : bbox.getCorners()) {
+        afw::geom::Point2D const exact = _target->skyToPixel(*_source->pixelToSky(corner));
+        afw::geom::Point2D const approx = toTarget(corner);
+        if (!(std::hypot(exact.getX() - approx.getX(), exact.getY() - approx.getY()) <= _maxError)) {
+            return footprint.transform(*_source, *_target, _region);
+        }
+        targetBoxD.include(approx);
+    }
+    afw::geom::AffineTransform const toSource = toTarget.invert();
+
+    afw::geom::Box2I targetBox(targetBoxD, afw::geom::Box2I::EXPAND);
+    targetBox.clip(_region);
+    PTR(afw::detection::Footprint) result = std::make_shared<afw::detection::Footprint>();
+    result->setRegion(_region);
+
+    // Map each target pixel back to the source pixel containing it.
+    SpanLookup const lookup(footprint);
+    if (!targetBox.isEmpty()) {
+        for (int y = targetBox.getMinY(); y <= targetBox.getMaxY(); ++y) {
+            int x0 = 0;
+            bool inSpan = false;
+            for (int x = targetBox.getMinX(); x <= targetBox.getMaxX(); ++x) {
+                afw::geom::Point2D const p = toSource(afw::geom::Point2D(x, y));
+                bool const inside = lookup.find(roundToInt(p.getX()), roundToInt(p.getY())) >= 0;
+                if (inside && !inSpan) {
+                    x0 = x;
+                } else if (!inside && inSpan) {
+                    result->addSpan(y, x0, x - 1);
+                }
+                inSpan = inside;
+            }
+            if (inSpan) {
+                result->addSpan(y, x0, targetBox.getMaxX());
+            }
+        }
+    }
+    result->normalize();
+
+    for (auto const & peak : footprint.getPeaks()) {
+        afw::geom::Point2D const p = _target->skyToPixel(*_source->pixelToSky(peak.getF()));
+        result->addPeak(p.getX(), p.getY(), peak.getPeakValue());
+    }
+
+    HeavyFootprintF const * heavy = dynamic_cast<HeavyFootprintF const *>(&footprint);
+    if (!_keepHeavy || !heavy) {
+        return result;
+    }
+
+    // Fill in the HeavyFootprint's pixels (in the order of its normalized spans) from the source.
+    PTR(HeavyFootprintF) resultHeavy = std::make_shared<HeavyFootprintF>(*result);
+    double const areaRatio = std::abs(toSource.getLinear().computeDeterminant());
+    auto const inImage = heavy->getImageArray();
+    auto const inMask = heavy->getMaskArray();
+    auto const inVariance = heavy->getVarianceArray();
+    auto outImage = resultHeavy->getImageArray();
+    auto outMask = resultHeavy->getMaskArray();
+    auto outVariance = resultHeavy->getVarianceArray();
+    int n = 0;
+    for (auto const & span : resultHeavy->getSpans()) {
+        for (int x = span->getX0(); x <= span->getX1(); ++x, ++n) {
+            afw::geom::Point2D const p = toSource(afw::geom::Point2D(x, span->getY()));
+            int const i = lookup.find(roundToInt(p.getX()), roundToInt(p.getY()));
+            outImage[n] = inImage[i]*areaRatio;
+            outMask[n] = inMask[i];
+            outVariance[n] = inVariance[i]*areaRatio*areaRatio;
+        }
+    }
+    return resultHeavy;
+}
+
+void FootprintTransformer::transformCatalog(
+    afw::table::SourceCatalog const & sourceCat,
+    afw::table::SourceCatalog & targetCat
+) const {
+    if (sourceCat.size() != targetCat.size()) {
+        throw LSST_EXCEPT(pex::exceptions::LengthError, "Catalog size mismatch");
+    }
+    for (std::size_t i = 0; i < sourceCat.size(); ++i) {
+        PTR(afw::detection::Footprint) const footprint = sourceCat[i].getFootprint();
+        if (footprint) {
+            targetCat[i].setFootprint((*this)(*footprint));
+        }
+    }
+}
+
+void FootprintTransformer::transformCatalog(
+    afw::table::SourceCatalog const & sourceCat,
+    afw::table::SourceCatalog & targetCat,
+    afw::image::MaskedImage<float> const & image
+) const {
+    transformCatalog(sourceCat, targetCat);
+    if (!_keepHeavy) {
+        return;
+    }
+    std::map<afw::table::RecordId, std::vector<std::size_t>> families;
+    for (std::size_t i = 0; i < sourceCat.size(); ++i) {
+        if (sourceCat[i].getParent() != 0) {
+            families[sourceCat[i].getParent()].push_back(i);
+        }
+    }
+    for (auto const & family : families) {
+        std::vector<PTR(HeavyFootprintF)> templates;
+        afw::geom::Box2I box;
+        for (std::size_t i : family.second) {
+            PTR(HeavyFootprintF) heavy =
+                std::dynamic_pointer_cast<HeavyFootprintF>(targetCat[i].getFootprint());
+            if (heavy) {
+                templates.push_back(heavy);
+                box.include(heavy->getBBox());
+            }
+        }
+        if (templates.size() != family.second.size()) {
+            // Weights from only some of the children would give the others' flux to them.
+            for (std::size_t i : family.second) {
+                PTR(afw::detection::Footprint) footprint = targetCat[i].getFootprint();
+                if (footprint && footprint->isHeavy()) {
+                    targetCat[i].setFootprint(std::make_shared<afw::detection::Footprint>(*footprint));
+                }
+            }
+            continue;
+        }
+        if (box.isEmpty()) {
+            continue;
+        }
+        // Sum the children's resampled source pixels, to normalize their weights.
+        ndarray::Array<float,2,2> total = ndarray::allocate(box.getHeight(), box.getWidth());
+        total.deep() = 0.0f;
+        for (auto const & heavy : templates) {
+            auto const values = heavy->getImageArray();
+            int n = 0;
+            for (auto const & span : heavy->getSpans()) {
+                for (int x = span->getX0(); x <= span->getX1(); ++x, ++n) {
+                    total[span->getY() - box.getMinY()][x - box.getMinX()] += std::max(values[n], 0.0f);
+                }
+            }
+        }
+        for (std::size_t k = 0; k < templates.size(); ++k) {
+            HeavyFootprintF const & heavy = *templates[k];
+            PTR(HeavyFootprintF) result = std::make_shared<HeavyFootprintF>(heavy, image);
+            auto const values = heavy.getImageArray();
+            auto outImage = result->getImageArray();
+            int n = 0;
+            for (auto const & span : result->getSpans()) {
+                for (int x = span->getX0(); x <= span->getX1(); ++x, ++n) {
+                    float const sum = total[span->getY() - box.getMinY()][x - box.getMinX()];
+                    outImage[n] *= (sum > 0.0f) ? std::max(values[n], 0.0f)/sum : 0.0f;
+                }
+            }
+            targetCat[family.second[k]].setFootprint(result);
+        }
+    }
+}
+
+}}} // namespace lsst::meas::base
@@ -25,6 +25,8 @@
 #include "lsst/meas/base/GaussianCentroid.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include "Eigen/Core"
 #include "Eigen/LU"
 
@@ -32,20 +34,52 @@
 namespace lsst { namespace meas { namespace base {
 namespace {
 #define USE_WEIGHT 0                    // zweight is only set, not used.  It isn't even set if this is false
+/*
+ * The pixels being fitted, thought of as a raster scan, stored as a structure of arrays
+ */
 struct Raster {
-    int x, y;                           // x, y index of rastered pixel
-    double zo;                          // pixel's value
+    enum { WIDE = 32, MAX_SIZE = WIDE*WIDE }; // patch of image being fitted is at most WIDE*WIDE
+
+    int size;                           // number of rastered pixels
+    std::array<double, MAX_SIZE> x;     // x index of rastered pixel
+    std::array<double, MAX_SIZE> y;     // y index of rastered pixel
+    std::array<double, MAX_SIZE> zo;    // pixel's value
 #if USE_WEIGHT
-    double zweight;                     // weight for the pixel
+    std::array<double, MAX_SIZE> zweight; // weight for the pixel
 #endif
 };
 
+/*
+ * Per-thread storage for the raster and for the model and derivatives dcalc2 evaluates on it
+ *
+ * Everything has a fixed maximum size, so fitting a source never touches the heap.
+ */
+struct FitWorkspace {
+    typedef Eigen::Matrix<double, Eigen::Dynamic, FittedModel::NPARAM, Eigen::ColMajor,
+                          Raster::MAX_SIZE, FittedModel::NPARAM> DerivativeMatrix;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, Raster::MAX_SIZE, 1> ResidualVector;
+
+    static FitWorkspace & get() {
+        static thread_local FitWorkspace workspace;
+        return workspace;
+    }
+
+    Raster rast;
+    std::array<double, Raster::MAX_SIZE> dx; // offsets from the centre, in units of the width,
+    std::array<double, Raster::MAX_SIZE> dy; //     of the pixels inside the fitted annulus
+    std::array<double, Raster::MAX_SIZE> d2; // dx^2 + dy^2
+    std::array<double, Raster::MAX_SIZE> zo; // values of the pixels inside the fitted annulus
+    std::array<double, Raster::MAX_SIZE> arg; // exp(-d2/2)
+    DerivativeMatrix df;                // derivatives of the model wrt the parameters, one row per pixel
+    ResidualVector r;                   // data - model
+};
+
 struct Fit2d {
     typedef Eigen::Matrix<double, FittedModel::NPARAM, FittedModel::NPARAM> Matrix;
     typedef Eigen::Matrix<double, FittedModel::NPARAM, 1> Vector;
 
     template<typename PixelT>
-    explicit Fit2d(afw::image::Image<PixelT> const& im) : wide(32), rast(*new std::vector<Raster>(wide*wide)) {
+    explicit Fit2d(afw::image::Image<PixelT> const& im) : wide(Raster::WIDE), rast(FitWorkspace::get().rast) {
         ncols = im.getWidth();
         nrows = im.getHeight();
 
@@ -61,13 +95,11 @@ struct Fit2d {
 
         iter = 0;
         flamd = 1.0;
-    }
-    ~Fit2d() {
-        delete &rast;
+        rast.size = 0;
     }
 
     int wide;                           // patch of image being fitted is wide*wide
-    std::vector<Raster> &rast;          // The pixels being fitted, thought of as a raster scan
+    Raster &rast;                       // The pixels being fitted, in this thread's FitWorkspace
     int nin;
     int nref;
     int iter;
@@ -131,34 +163,52 @@ static void dcalc2(Fit2d *fit,                  // the struct carrying all the f
         fit->status = 0;
     }
 
-    beta->setZero();
-    alpha->setZero();
-
-    fit->nin = 0;
-    fit->chnew = 0.0;
 /*
- * Examine all pixels in raster
+ * Gather the pixels in the raster that lie within the annulus we fit; comparing squared distances
+ * saves a hypot per pixel
  */
-    for (int i = 0, nrast = fit->rast.size(); i != nrast; i++) {
-        double const dx = (fit->rast[i].x - x0)/s;
-        double const dy = (fit->rast[i].y - y0)/s;
-        double const d = hypot(dx, dy);
-
-        if (d >= fit->dc2zmin && d <= fit->dc2zmax) {
-            double const arg = exp(-d*d/2.0);
-            double const funct = a*arg + b;
-
-            Fit2d::Vector df;
-            df << arg, 1.0, a*arg*dx/s, a*arg*dy/s, a*arg*(dx*dx/s + dy*dy/s);
-
-            double const r = fit->rast[i].zo - funct; // residual
-            fit->chnew += r*r;
-            *beta += r*df;
-            *alpha += df*df.transpose();    // outer product
-
-            fit->nin++;
+    FitWorkspace & ws = FitWorkspace::get();
+    Raster const & rast = fit->rast;
+    double const d2min = fit->dc2zmin*fit->dc2zmin;
+    double const d2max = fit->dc2zmax*fit->dc2zmax;
+    int nin = 0;
+    for (int i = 0; i != rast.size; i++) {
+        double const dx = (rast.x[i] - x0)/s;
+        double const dy = (rast.y[i] - y0)/s;
+        double const d2 = dx*dx + dy*dy;
+
+        if (d2 >= d2min && d2 <= d2max) {
+            ws.dx[nin] = dx;
+            ws.dy[nin] = dy;
+            ws.d2[nin] = d2;
+            ws.zo[nin] = rast.zo[i];
+            nin++;
         }
     }
+    fit->nin = nin;
+/*
+ * Evaluate the model and its derivatives for all those pixels at once, and accumulate alpha = df^T df
+ * and beta = df^T r as matrix products
+ */
+    Eigen::Map<Eigen::ArrayXd const> const dx(ws.dx.data(), nin);
+    Eigen::Map<Eigen::ArrayXd const> const dy(ws.dy.data(), nin);
+    Eigen::Map<Eigen::ArrayXd const> const d2(ws.d2.data(), nin);
+    Eigen::Map<Eigen::ArrayXd const> const zo(ws.zo.data(), nin);
+    Eigen::Map<Eigen::ArrayXd> arg(ws.arg.data(), nin);
+
+    arg = (-0.5*d2).exp();
+    ws.df.resize(nin, FittedModel::NPARAM);
+    ws.df.col(FittedModel::PEAK) = arg.matrix();
+    ws.df.col(FittedModel::SKY).setOnes();
+    ws.df.col(FittedModel::X0) = (a/s*arg*dx).matrix();
+    ws.df.col(FittedModel::Y0) = (a/s*arg*dy).matrix();
+    ws.df.col(FittedModel::SIGMA) = (a/s*arg*d2).matrix();
+    ws.r = (zo - (a*arg + b)).matrix(); // residual
+
+    fit->chnew = ws.r.squaredNorm();
+    beta->noalias() = ws.df.transpose()*ws.r;
+    alpha->noalias() = ws.df.transpose()*ws.df;
+
     int nu = fit->nin - (FittedModel::NPARAM + 1); // number of degrees of freedom
     if (nu <= 0) {
         fit->status = FittedModel::TOO_FEW;
@@ -368,19 +418,18 @@ static void fg2(afw::image::Image<PixelT> const& im,     ///< The image
     int put = 0;
     for (int y = yl; y != yh; ++y) {
         for (int x = xl; x != xh; ++x) {
-            fit->rast[put].x = x;
-            fit->rast[put].y = y;
-            fit->rast[put].zo = im(x, y);
+            fit->rast.x[put] = x;
+            fit->rast.y[put] = y;
+            fit->rast.zo[put] = im(x, y);
 #if USE_WEIGHT
-            fit->rast[put].zweight = 1.0;
+            fit->rast.zweight[put] = 1.0;
 #endif
             if (im(x, y) < sky) {
                 sky = im(x, y);
             }
             double const ex = x - ix0;
             double const ey = y - iy0;
-            double const er = hypot(ex, ey);
-            if (er <= fit->lost) {
+            if (ex*ex + ey*ey <= fit->lost*fit->lost) {
                 if (im(x, y) > peak) {
                     jx0 = x;
                     jy0 = y;
@@ -390,7 +439,7 @@ static void fg2(afw::image::Image<PixelT> const& im,     ///< The image
             put++;
         }
     }
-    fit->rast.resize(put);
+    fit->rast.size = put;
     ix0 = jx0;
     iy0 = jy0;
 /*
@@ -21,7 +21,11 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
-#include "ndarray/eigen.h"
+#include <array>
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
 
 #include "lsst/afw/detection/Psf.h"
 #include "lsst/afw/geom/Box.h"
@@ -37,141 +41,199 @@ namespace lsst { namespace meas { namespace base {
 
 namespace {
 
-/************************************************************************************************************/
+// Largest warping kernel dimension supported (lanczos kernels of order n have dimension 2n)
+int const MAX_WARPING_DIM = 32;
+
 /**
- * @class PsfAttributes
- *
- * A class to contain various attributes of the Psf
- * - most notably, a width (1-D RMS size) to be used to
- *   make a single gaussian psf for fast convolution.
- *
- * \deprecated
- * This class is deprecated in favour of virtual methods on Psf
+ * @brief Compute the effective area of the psf ( sum(I)^2/sum(I^2) ) at a pixel
  *
- * An example of the new API is:
- * \code
- * afwGeom::ellipses::Quadrupole shape = psf->computeShape();
- * double const smoothingSigma = shape.getDeterminantRadius();
- * \endcode
+ * The position is an integer pixel so that we know the image is centered in its central pixel.
  */
-class PsfAttributes {
+double computeEffectiveArea(afw::detection::Psf const & psf, afw::geom::Point2I const & position) {
+    PTR(afw::detection::Psf::Image) psfImage = psf.computeImage(afw::geom::Point2D(position));
+    double sum = 0.0;
+    double sumsqr = 0.0;
+    for (int iY = 0; iY != psfImage->getHeight(); ++iY) {
+        afw::detection::Psf::Image::x_iterator end = psfImage->row_end(iY);
+        for (afw::detection::Psf::Image::x_iterator ptr = psfImage->row_begin(iY); ptr != end; ++ptr) {
+            sum += *ptr;
+            sumsqr += (*ptr)*(*ptr);
+        }
+    }
+    return sum*sum/sumsqr;
+}
+
+/*
+ * A per-thread cache of PSF effective areas, treated as constant within square tiles of the exposure
+ * and evaluated at each tile's central pixel.  It's flushed whenever it's asked about a new Psf (which
+ * it doesn't keep alive) or tile size, so in practice it holds the areas for one exposure; beyond
+ * MAX_TILES, the least recently used tile is evicted.
+ */
+class EffectiveAreaCache {
 public:
-    enum Method { ADAPTIVE_MOMENT,      ///< Calculate width using adaptive Gaussian weights
-                  FIRST_MOMENT,         ///< Calculate width using \<r>
-                  SECOND_MOMENT,        ///< Calculate width using \<r^2>
-                  NOISE_EQUIVALENT,     ///< Calculate width as sqrt(n_eff/(4 pi))
-                  BICKERTON             ///< Weight \<r^2> by I^2 to avoid negative fluxes
-    };
 
-    PsfAttributes(CONST_PTR(lsst::afw::detection::Psf) psf, int const iX, int const iY);
-    PsfAttributes(CONST_PTR(lsst::afw::detection::Psf) psf, lsst::afw::geom::Point2I const& cen);
+    static EffectiveAreaCache & get() {
+        static thread_local EffectiveAreaCache cache;
+        return cache;
+    }
 
-    double computeGaussianWidth(Method how=ADAPTIVE_MOMENT) const;
-    double computeEffectiveArea() const;
+    double compute(PTR(afw::detection::Psf const) psf, afw::geom::Point2I const & position, int tileSize) {
+        if (tileSize <= 0) {
+            return computeEffectiveArea(*psf, position);
+        }
+        if (_psf.lock() != psf || _tileSize != tileSize) {
+            _index.clear();
+            _entries.clear();
+            _psf = psf;
+            _tileSize = tileSize;
+        }
+        Key const tile(
+            static_cast<int>(std::floor(static_cast<double>(position.getX())/tileSize)),
+            static_cast<int>(std::floor(static_cast<double>(position.getY())/tileSize))
+        );
+        EntryMap::const_iterator iter = _index.find(tile);
+        if (iter != _index.end()) {
+            _entries.splice(_entries.begin(), _entries, iter->second);
+            return iter->second->area;
+        }
+        afw::geom::Point2I anchor(tile.first*tileSize + tileSize/2, tile.second*tileSize + tileSize/2);
+        Entry entry;
+        entry.key = tile;
+        entry.area = computeEffectiveArea(*psf, anchor);
+        _entries.push_front(entry);
+        _index[tile] = _entries.begin();
+        if (_entries.size() > MAX_TILES) {
+            _index.erase(_entries.back().key);
+            _entries.pop_back();
+        }
+        return entry.area;
+    }
 
 private:
-    PTR(lsst::afw::image::Image<double>) _psfImage;
-};
 
-/**
- * @brief Constructor for PsfAttributes
- */
-PsfAttributes::PsfAttributes(
-        CONST_PTR(lsst::afw::detection::Psf) psf, ///< The psf whose attributes we want
-        int const iX,                       ///< the x position in the frame we want the attributes at
-        int const iY                        ///< the y position in the frame we want the attributes at
-                            )
-{
-    // N.b. (iX, iY) are ints so that we know this image is centered in the central pixel of _psfImage
-    _psfImage = psf->computeImage(afw::geom::PointD(iX, iY));
-}
+    typedef std::pair<int,int> Key;     // tile x, tile y
 
-/**
- * @brief Constructor for PsfAttributes
- */
-PsfAttributes::PsfAttributes(
-        CONST_PTR(lsst::afw::detection::Psf) psf, ///< The psf whose attributes we want
-        lsst::afw::geom::Point2I const& cen       ///< the position in the frame we want the attributes at
-                            ) :
-    // N.b. cen is a PointI so that we know this image is centered in the central pixel of _psfImage
-    _psfImage(psf->computeImage(afw::geom::PointD(cen)))
-{
-}
+    struct Entry {
+        Key key;
+        double area;
+    };
 
-/**
- * @brief Compute the effective area of the psf ( sum(I)^2/sum(I^2) )
- *
+    typedef std::list<Entry> EntryList; // most recently used first
+    typedef std::map<Key, EntryList::iterator> EntryMap;
+
+    static std::size_t const MAX_TILES = 1 << 16;
+
+    EffectiveAreaCache() : _tileSize(0) {}
+
+    std::weak_ptr<afw::detection::Psf const> _psf;
+    int _tileSize;
+    EntryList _entries;
+    EntryMap _index;
+};
+
+/*
+ * A warping kernel (and buffers for its taps) that the calling thread is free to modify
  */
-double PsfAttributes::computeEffectiveArea() const {
+struct ThreadWarpingKernel {
+    PTR(afw::math::SeparableKernel) kernel;
+    std::vector<afw::math::Kernel::Pixel> colList;
+    std::vector<afw::math::Kernel::Pixel> rowList;
+};
 
-    double sum = 0.0;
-    double sumsqr = 0.0;
-    for (int iY = 0; iY != _psfImage->getHeight(); ++iY) {
-        afw::image::Image<double>::x_iterator end = _psfImage->row_end(iY);
-        for (afw::image::Image<double>::x_iterator ptr = _psfImage->row_begin(iY); ptr != end; ++ptr) {
-            sum += *ptr;
-            sumsqr += (*ptr)*(*ptr);
-        }
+ThreadWarpingKernel & getThreadWarpingKernel(std::string const & name) {
+    static thread_local std::map<std::string, ThreadWarpingKernel> kernels;
+    ThreadWarpingKernel & result = kernels[name];
+    if (!result.kernel) {
+        result.kernel = afw::math::makeWarpingKernel(name);
+        result.colList.resize(result.kernel->getWidth());
+        result.rowList.resize(result.kernel->getHeight());
     }
-    return sum*sum/sumsqr;
+    return result;
 }
 
 } // end anonymous namespace
 
-/**
-Compute the value of one pixel of an image after a fractional pixel shift
-Since we only want the value at one pixel, there is no need to shift the entire image;
-instead we simply convolve at one point.
-
-@throw pex::exceptions::RangeError if abs(fracShift) > 1 in either dimension
-*/
-template<typename T>
-typename afw::image::MaskedImage<T>::SinglePixel computeShiftedValue(
-    afw::image::MaskedImage<T> const &maskedImage, ///< masked image
-    std::string const &warpingKernelName,   ///< warping kernel name
-    afw::geom::Point2D const &fracShift,    ///< amount of sub-pixel shift (pixels)
-    afw::geom::Point2I const &parentInd     ///< parent index at which to compute pixel
-) {
-    typedef typename afw::image::Exposure<T>::MaskedImageT MaskedImageT;
-    typedef typename afw::image::Image<double> KernelImageT;
-
+PeakLikelihoodFluxAlgorithm::WarpingTaps::WarpingTaps(
+    std::string const & warpingKernelName,
+    int shiftSteps_
+) : name(warpingKernelName), shiftSteps(shiftSteps_)
+{
     PTR(afw::math::SeparableKernel) warpingKernelPtr = afw::math::makeWarpingKernel(warpingKernelName);
-
-    if ((std::abs(fracShift[0]) >= 1) || (std::abs(fracShift[1]) >= 1)) {
+    width = warpingKernelPtr->getWidth();
+    height = warpingKernelPtr->getHeight();
+    ctr = warpingKernelPtr->getCtr();
+    if (width > MAX_WARPING_DIM || height > MAX_WARPING_DIM) {
         std::ostringstream os;
-        os << "fracShift = " << fracShift << " too large; abs value must be < 1 in both axes";
-        throw LSST_EXCEPT(pex::exceptions::RangeError, os.str());
+        os << "Warping kernel " << warpingKernelName << " is too large; dimensions must be <= "
+           << MAX_WARPING_DIM;
+        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+    }
+    if (shiftSteps <= 0) {
+        return;
     }
+    x.resize(2*(shiftSteps + 1)*width);
+    y.resize(2*(shiftSteps + 1)*height);
+    std::vector<afw::math::Kernel::Pixel> colList(width);
+    std::vector<afw::math::Kernel::Pixel> rowList(height);
+    for (int negative = 0; negative < 2; ++negative) {
+        // warping kernels have even dimension and want the peak to the right of center
+        warpingKernelPtr->setCtrX(ctr.getX() + negative);
+        warpingKernelPtr->setCtrY(ctr.getY() + negative);
+        for (int step = 0; step <= shiftSteps; ++step) {
+            double const shift = (negative ? -0.5 : 0.5)*step/shiftSteps;
+            warpingKernelPtr->setKernelParameters(std::make_pair(shift, shift));
+            warpingKernelPtr->computeVectors(colList, rowList, true);
+            int const offset = negative*(shiftSteps + 1) + step;
+            std::copy(colList.begin(), colList.end(), x.begin() + offset*width);
+            std::copy(rowList.begin(), rowList.end(), y.begin() + offset*height);
+        }
+    }
+}
 
-    // warping kernels have even dimension and want the peak to the right of center
-    if (fracShift[0] < 0) {
-        warpingKernelPtr->setCtrX(warpingKernelPtr->getCtrX() + 1);
+afw::geom::Extent2I PeakLikelihoodFluxAlgorithm::WarpingTaps::compute(
+    afw::geom::Point2D const & fracShift,
+    double * xTaps,
+    double * yTaps
+) const {
+    if (shiftSteps > 0) {
+        return afw::geom::Extent2I(ctr.getX() + interpolate(x, width, fracShift.getX(), xTaps),
+                                   ctr.getY() + interpolate(y, height, fracShift.getY(), yTaps));
     }
-    if (fracShift[1] < 0) {
-        warpingKernelPtr->setCtrY(warpingKernelPtr->getCtrY() + 1);
+    ThreadWarpingKernel & warping = getThreadWarpingKernel(name);
+    // warping kernels have even dimension and want the peak to the right of center
+    afw::geom::Extent2I const shiftedCtr(ctr.getX() + (fracShift.getX() < 0),
+                                         ctr.getY() + (fracShift.getY() < 0));
+    warping.kernel->setCtrX(shiftedCtr.getX());
+    warping.kernel->setCtrY(shiftedCtr.getY());
+    warping.kernel->setKernelParameters(std::make_pair(fracShift.getX(), fracShift.getY()));
+    warping.kernel->computeVectors(warping.colList, warping.rowList, true);
+    std::copy(warping.colList.begin(), warping.colList.end(), xTaps);
+    std::copy(warping.rowList.begin(), warping.rowList.end(), yTaps);
+    return shiftedCtr;
+}
+
+int PeakLikelihoodFluxAlgorithm::WarpingTaps::interpolate(
+    std::vector<double> const & table,
+    int size,
+    double fracShift,
+    double * taps
+) const {
+    int const negative = (fracShift < 0);
+    double const a = std::abs(fracShift)*2*shiftSteps;
+    int step = static_cast<int>(a);
+    double t = a - step;
+    if (step >= shiftSteps) {
+        step = shiftSteps - 1;
+        t = 1.0;
     }
-    afw::geom::Box2I warpingOverlapBBox(
-        parentInd - afw::geom::Extent2I(warpingKernelPtr->getCtr()),
-        warpingKernelPtr->getDimensions());
-    if (!maskedImage.getBBox().contains(warpingOverlapBBox)) {
-        std::ostringstream os;
-        os << "Warping kernel extends off the edge"
-            << "; kernel bbox = " << warpingOverlapBBox
-            << "; exposure bbox = " << maskedImage.getBBox();
-        throw LSST_EXCEPT(pex::exceptions::RangeError, os.str());
+    double const * lower = table.data() + (negative*(shiftSteps + 1) + step)*size;
+    double const * upper = lower + size;
+    for (int i = 0; i < size; ++i) {
+        taps[i] = (1.0 - t)*lower[i] + t*upper[i];
     }
-    warpingKernelPtr->setKernelParameters(std::make_pair(fracShift[0], fracShift[1]));
-    KernelImageT warpingKernelImage(warpingKernelPtr->getDimensions());
-    warpingKernelPtr->computeImage(warpingKernelImage, true);
-    typename KernelImageT::const_xy_locator const warpingKernelLoc = warpingKernelImage.xy_at(0,0);
-
-    // Compute imLoc: an image locator that matches kernel locator (0,0) such that
-    // image ctrPix overlaps center of warping kernel
-    afw::geom::Point2I subimMin = warpingOverlapBBox.getMin();
-    typename MaskedImageT::const_xy_locator const mimageLoc = maskedImage.xy_at(subimMin.getX(), subimMin.getY());
-    return afw::math::convolveAtAPoint<MaskedImageT, MaskedImageT>(
-        mimageLoc, warpingKernelLoc, warpingKernelPtr->getWidth(), warpingKernelPtr->getHeight());
+    return negative;
 }
+
 PeakLikelihoodFluxAlgorithm::PeakLikelihoodFluxAlgorithm(
     Control const & ctrl,
     std::string const & name,
@@ -180,7 +242,8 @@ PeakLikelihoodFluxAlgorithm::PeakLikelihoodFluxAlgorithm(
     _fluxResultKey(
         FluxResultKey::addFields(schema, name, "flux from PeakLikelihood Flux algorithm")
     ),
-    _centroidExtractor(schema, name)
+    _centroidExtractor(schema, name),
+    _warpingTaps(ctrl.warpingKernelName, ctrl.warpingShiftSteps)
 {
     static std::array<FlagDefinition,N_FLAGS> const flagDefs = {{
         {"flag", "general failure flag, set if anything went wrong"}
@@ -224,27 +287,54 @@ void PeakLikelihoodFluxAlgorithm::measure(
     std::pair<int, double> const yCtrPixParentIndFrac = afw::image::positionToIndex(center.getY(), true);
 
     afw::geom::Point2I ctrPixParentInd(xCtrPixParentIndFrac.first, yCtrPixParentIndFrac.first);
-    afw::geom::Point2D ctrPixPos(
-        afw::image::indexToPosition(ctrPixParentInd[0]),
-        afw::image::indexToPosition(ctrPixParentInd[1])
-    );
 
     // compute weight = 1/sum(PSF^2) for PSF at ctrPix, where PSF is normalized to a sum of 1
-    PsfAttributes psfAttr(psfPtr, ctrPixParentInd);
-    double weight = psfAttr.computeEffectiveArea();
+    double weight = EffectiveAreaCache::get().compute(psfPtr, ctrPixParentInd, _ctrl.psfAreaCacheTileSize);
 
     /*
      * Compute value of image at center of source, as shifted by a fractional pixel to center the source
-     * on ctrPix.
+     * on ctrPix.  Since we only want the value at one pixel, there is no need to shift the entire image;
+     * instead we simply convolve with the (separable) warping kernel at one point.
      */
-    MaskedImageT::SinglePixel mimageCtrPix = computeShiftedValue(
-        mimage,
-        _ctrl.warpingKernelName,
+    std::array<double, MAX_WARPING_DIM> xTaps;
+    std::array<double, MAX_WARPING_DIM> yTaps;
+    int const width = _warpingTaps.width;
+    int const height = _warpingTaps.height;
+    afw::geom::Extent2I const ctr = _warpingTaps.compute(
         afw::geom::Point2D(xCtrPixParentIndFrac.second, yCtrPixParentIndFrac.second),
-        ctrPixParentInd
+        xTaps.data(), yTaps.data()
     );
-    double flux = mimageCtrPix.image()*weight;
-    double var = mimageCtrPix.variance()*weight*weight;
+    afw::geom::Box2I warpingOverlapBBox(ctrPixParentInd - ctr, afw::geom::Extent2I(width, height));
+    if (!mimage.getBBox().contains(warpingOverlapBBox)) {
+        std::ostringstream os;
+        os << "Warping kernel extends off the edge"
+            << "; kernel bbox = " << warpingOverlapBBox
+            << "; exposure bbox = " << mimage.getBBox();
+        throw LSST_EXCEPT(pex::exceptions::RangeError, os.str());
+    }
+    auto const imageArray = mimage.getImage()->getArray();
+    auto const varianceArray = mimage.getVariance()->getArray();
+    int const x0 = warpingOverlapBBox.getMinX() - mimage.getX0();
+    double value = 0.0;
+    double variance = 0.0;
+    for (int j = 0; j < height; ++j) {
+        // as in afw::math::convolveAtAPoint, pixels under zero kernel values don't contribute at all
+        if (yTaps[j] == 0.0) continue;
+        int const y = warpingOverlapBBox.getMinY() + j - mimage.getY0();
+        float const * imageRow = imageArray.getData() + y*imageArray.getStrides()[0] + x0;
+        float const * varianceRow = varianceArray.getData() + y*varianceArray.getStrides()[0] + x0;
+        double rowValue = 0.0;
+        double rowVariance = 0.0;
+        for (int i = 0; i < width; ++i) {
+            if (xTaps[i] == 0.0) continue;
+            rowValue += xTaps[i]*imageRow[i];
+            rowVariance += xTaps[i]*xTaps[i]*varianceRow[i];
+        }
+        value += yTaps[j]*rowValue;
+        variance += yTaps[j]*yTaps[j]*rowVariance;
+    }
+    double flux = value*weight;
+    double var = variance*weight*weight;
     result.flux = flux;
     result.fluxSigma = std::sqrt(var);
     measRecord.set(_fluxResultKey, result);
@@ -22,60 +22,89 @@
  */
 
 #include <cctype> // ::tolower
-#include <algorithm> // std::transform
+#include <algorithm> // std::transform, std::min, std::max
+#include <array>
 #include <cmath>
 
-#include "ndarray/eigen.h"
-
 #include "lsst/afw/detection/Psf.h"
-#include "lsst/afw/detection/FootprintFunctor.h"
 #include "lsst/afw/table/Source.h"
 #include "lsst/meas/base/PixelFlags.h"
 
 namespace lsst { namespace meas { namespace base {
 namespace {
-template <typename MaskedImageT>
-class FootprintBits : public afw::detection::FootprintFunctor<MaskedImageT> {
-public:
-    explicit FootprintBits(MaskedImageT const& mimage) :
-        afw::detection::FootprintFunctor<MaskedImageT>(mimage), _bits(0)
-    {}
 
-    /// \brief Reset everything for a new Footprint
-    void reset() {
-        _bits = 0x0;
-    }
-    virtual void reset(afw::detection::Footprint const&) {}
+typedef afw::image::MaskedImage<float> MaskedImageF;
+typedef afw::image::MaskPixel MaskPixel;
 
-    /// \brief method called for each pixel by apply()
-    void operator()(typename MaskedImageT::xy_locator loc, ///< locator pointing at the pixel
-                    int x,                                 ///< column-position of pixel
-                    int y                                  ///< row-position of pixel
-                   ) {
-        _bits |= loc.mask(0, 0);
+// Return the bitmask for a mask plane, or 0 if the plane isn't (yet) defined.
+MaskPixel lookupPlaneBitMask(std::string const & plane) {
+    try {
+        return MaskedImageF::Mask::getPlaneBitMask(plane);
+    } catch (pex::exceptions::InvalidParameterError &) {
+        return 0x0;
     }
+}
 
-    /// Return the union of the bits set anywhere in the Footprint
-    typename MaskedImageT::Mask::Pixel getBits() const { return _bits; }
-private:
-    typename MaskedImageT::Mask::Pixel _bits;
-};
+// Return the bitmask for a mask flag, looking it up again if the plane wasn't defined at construction;
+// a plane that still isn't defined is a configuration error.
+MaskPixel getPlaneBits(PixelFlagsAlgorithm::MaskFlag const & flag) {
+    if (flag.bits) {
+        return flag.bits;
+    }
+    try {
+        return MaskedImageF::Mask::getPlaneBitMask(flag.plane);
+    } catch (pex::exceptions::InvalidParameterError & err) {
+        throw LSST_EXCEPT(FatalAlgorithmError, err.what());
+    }
+}
 
-typedef afw::image::MaskedImage<float> MaskedImageF;
+// Return the union of the mask bits in row y between columns x0 and x1 (inclusive, in parent
+// coordinates), clipped to the mask.  The row is contiguous, so the reduction is split over independent
+// lanes the compiler can vectorize.
+MaskPixel orMaskRow(MaskedImageF::Mask const & mask, int y, int x0, int x1) {
+    if (y < mask.getY0() || y >= mask.getY0() + mask.getHeight()) {
+        return 0x0;
+    }
+    x0 = std::max(x0, mask.getX0());
+    x1 = std::min(x1, mask.getX0() + mask.getWidth() - 1);
+    int const n = x1 - x0 + 1;
+    if (n <= 0) {
+        return 0x0;
+    }
+    auto const array = mask.getArray();
+    MaskPixel const * row = array.getData() + (y - mask.getY0())*array.getStrides()[0] + (x0 - mask.getX0());
+    int const N_LANES = 8;
+    std::array<MaskPixel, N_LANES> bits = {{0, 0, 0, 0, 0, 0, 0, 0}};
+    int x = 0;
+    for (; x + N_LANES <= n; x += N_LANES) {
+        for (int lane = 0; lane < N_LANES; ++lane) {
+            bits[lane] |= row[x + lane];
+        }
+    }
+    for (; x < n; ++x) {
+        bits[0] |= row[x];
+    }
+    return (bits[0] | bits[1] | bits[2] | bits[3]) | (bits[4] | bits[5] | bits[6] | bits[7]);
+}
 
-void updateFlags(PixelFlagsAlgorithm::KeyMap const & maskFlagToPixelFlag, const FootprintBits<MaskedImageF> & func,
+void updateFlags(std::vector<PixelFlagsAlgorithm::MaskFlag> const & flags, MaskPixel bits,
                  afw::table::SourceRecord & measRecord) {
-        for (auto const & i: maskFlagToPixelFlag) {
-            try {
-                if (func.getBits() & MaskedImageF::Mask::getPlaneBitMask(i.first)) {
-                    measRecord.set(i.second, true);
-                }
-            }
-            catch (pex::exceptions::InvalidParameterError & err) {
-                throw LSST_EXCEPT(FatalAlgorithmError, err.what());
-            }
+    for (auto const & flag: flags) {
+        if (bits & getPlaneBits(flag)) {
+            measRecord.set(flag.key, true);
         }
     }
+}
+
+std::vector<PixelFlagsAlgorithm::MaskFlag> makeMaskFlags(PixelFlagsAlgorithm::KeyMap const & keys) {
+    std::vector<PixelFlagsAlgorithm::MaskFlag> flags;
+    for (auto const & i: keys) {
+        PixelFlagsAlgorithm::MaskFlag flag = {i.first, lookupPlaneBitMask(i.first), i.second};
+        flags.push_back(flag);
+    }
+    return flags;
+}
+
 } // end anonymous namespace
 
 PixelFlagsAlgorithm::PixelFlagsAlgorithm(
@@ -83,48 +112,58 @@ PixelFlagsAlgorithm::PixelFlagsAlgorithm(
     std::string const & name,
     afw::table::Schema & schema
 ) : _ctrl(ctrl) {
+    KeyMap anyKeys;
+    KeyMap centerKeys;
     // Add generic keys first, which don't correspond to specific mask planes
     _generalFailureKey = schema.addField<afw::table::Flag>(name + "_flag",
                                         "general failure flag, set if anything went wring");
     _offImageKey = schema.addField<afw::table::Flag>(name+"_flag" + "_offimage",
                                         "Source center is off image");
     // Set all the flags that correspond to mask planes anywhere in the footprint
-    _anyKeys["EDGE"] = schema.addField<afw::table::Flag>(name + "_flag_edge",
+    anyKeys["EDGE"] = schema.addField<afw::table::Flag>(name + "_flag_edge",
                                         "Source is outside usable exposure region (masked EDGE or NO_DATA)");
-    _anyKeys["INTRP"] = schema.addField<afw::table::Flag>(name + "_flag_interpolated",
+    anyKeys["INTRP"] = schema.addField<afw::table::Flag>(name + "_flag_interpolated",
                                         "Interpolated pixel in the Source footprint");
-    _anyKeys["SAT"] = schema.addField<afw::table::Flag>(name + "_flag_saturated",
+    anyKeys["SAT"] = schema.addField<afw::table::Flag>(name + "_flag_saturated",
                                         "Saturated pixel in the Source footprint");
-    _anyKeys["CR"] = schema.addField<afw::table::Flag>(name + "_flag_cr",
+    anyKeys["CR"] = schema.addField<afw::table::Flag>(name + "_flag_cr",
                                         "Cosmic ray in the Source footprint");
-    _anyKeys["BAD"] = schema.addField<afw::table::Flag>(name + "_flag_bad",
+    anyKeys["BAD"] = schema.addField<afw::table::Flag>(name + "_flag_bad",
                                         "Bad pixel in the Source footprint");
-    _anyKeys["SUSPECT"] = schema.addField<afw::table::Flag>(name + "_flag_suspect",
+    anyKeys["SUSPECT"] = schema.addField<afw::table::Flag>(name + "_flag_suspect",
                                         "Source's footprint includes suspect pixels");
     // Flags that correspond to mask bits which occur in the center of the object
-    _centerKeys["INTRP"] = schema.addField<afw::table::Flag>(name + "_flag_interpolatedCenter",
+    centerKeys["INTRP"] = schema.addField<afw::table::Flag>(name + "_flag_interpolatedCenter",
                                         "Interpolated pixel in the Source center");
-    _centerKeys["SAT"] = schema.addField<afw::table::Flag>(name + "_flag_saturatedCenter",
+    centerKeys["SAT"] = schema.addField<afw::table::Flag>(name + "_flag_saturatedCenter",
                                         "Saturated pixel in the Source center");
-    _centerKeys["CR"] = schema.addField<afw::table::Flag>(name + "_flag_crCenter",
+    centerKeys["CR"] = schema.addField<afw::table::Flag>(name + "_flag_crCenter",
                                         "Cosmic ray in the Source center");
-    _centerKeys["SUSPECT"] = schema.addField<afw::table::Flag>(name + "_flag_suspectCenter",
+    centerKeys["SUSPECT"] = schema.addField<afw::table::Flag>(name + "_flag_suspectCenter",
                                         "Source's center is close to suspect pixels");
 
     // Read in the flags passed from the configuration, and add them to the schema
     for (auto const & i: _ctrl.masksFpCenter) {
         std::string maskName(i);
         std::transform(maskName.begin(), maskName.end(), maskName.begin(), ::tolower);
-        _centerKeys[i] = schema.addField<afw::table::Flag>(name + "_flag_" + maskName + "Center",
+        centerKeys[i] = schema.addField<afw::table::Flag>(name + "_flag_" + maskName + "Center",
                                         "Source center is close to "+ i + " pixels");
     }
     
     for (auto const & i: _ctrl.masksFpAnywhere) {
         std::string maskName(i);
         std::transform(maskName.begin(), maskName.end(), maskName.begin(), ::tolower);
-        _anyKeys[i] = schema.addField<afw::table::Flag>(name + "_flag_" + maskName,
+        anyKeys[i] = schema.addField<afw::table::Flag>(name + "_flag_" + maskName,
                                         "Source footprint includes " + i + " pixels");
     }
+
+    // Resolve the mask plane bitmasks once, rather than by name for every source.  NO_DATA pixels
+    // anywhere in the footprint also set the EDGE flag.
+    _edgeKey = anyKeys["EDGE"];
+    _anyFlags = makeMaskFlags(anyKeys);
+    MaskFlag noData = {"NO_DATA", lookupPlaneBitMask("NO_DATA"), _edgeKey};
+    _anyFlags.push_back(noData);
+    _centerFlags = makeMaskFlags(centerKeys);
 }
 
 void PixelFlagsAlgorithm::measure(
@@ -132,8 +171,7 @@ void PixelFlagsAlgorithm::measure(
     afw::image::Exposure<float> const & exposure
 ) const {
 
-    MaskedImageF mimage = exposure.getMaskedImage();
-    FootprintBits<MaskedImageF> func(mimage);
+    MaskedImageF::Mask const & mask = *exposure.getMaskedImage().getMask();
 
     // Check if the measRecord has a valid centroid key, i.e. it was centroided
     afw::geom::Point2D center;
@@ -167,36 +205,31 @@ void PixelFlagsAlgorithm::measure(
     }
 
     //  Catch centroids off the image
-    if (!mimage.getBBox().contains(afw::geom::Point2I(center))) {
+    if (!mask.getBBox().contains(afw::geom::Point2I(center))) {
         measRecord.set(_offImageKey, true);
-        measRecord.set(_anyKeys.at("EDGE"), true);
+        measRecord.set(_edgeKey, true);
     }
 
-    // Check for bits set in the source's Footprint
+    // Check for bits set in the source's Footprint, one span at a time
     afw::detection::Footprint const & footprint(*measRecord.getFootprint());
-    func.apply(footprint);
-
-    // Set the EDGE flag if the bitmask has NO_DATA set
-    try {
-        if (func.getBits() & MaskedImageF::Mask::getPlaneBitMask("NO_DATA")) {
-            measRecord.set(_anyKeys.at("EDGE"), true);
-        }
-    } catch (pex::exceptions::InvalidParameterError & err) {
-        throw LSST_EXCEPT(FatalAlgorithmError, err.what());
+    MaskPixel anyBits = 0x0;
+    for (auto const & span: footprint.getSpans()) {
+        anyBits |= orMaskRow(mask, span->getY(), span->getX0(), span->getX1());
     }
 
-    // update the source record for the any keys
-    updateFlags(_anyKeys, func, measRecord);
+    // update the source record for the any keys (including EDGE for NO_DATA)
+    updateFlags(_anyFlags, anyBits, measRecord);
 
     // Check for bits set in the 3x3 box around the center
-    afw::geom::Point2I llc(afw::image::positionToIndex(center.getX()) - 1,
-                           afw::image::positionToIndex(center.getY()) - 1);
-
-    afw::detection::Footprint const middle(afw::geom::BoxI(llc, afw::geom::ExtentI(3))); // central 3x3
-    func.apply(middle);
+    int const xCenter = afw::image::positionToIndex(center.getX());
+    int const yCenter = afw::image::positionToIndex(center.getY());
+    MaskPixel centerBits = 0x0;
+    for (int y = yCenter - 1; y <= yCenter + 1; ++y) {
+        centerBits |= orMaskRow(mask, y, xCenter - 1, xCenter + 1);
+    }
 
     // Update the flags which have to do with the center of the footprint
-    updateFlags(_centerKeys, func, measRecord);
+    updateFlags(_centerFlags, centerBits, measRecord);
 }
 
 void PixelFlagsAlgorithm::fail(afw::table::SourceRecord & measRecord, MeasurementError * error) const {
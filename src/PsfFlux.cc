@@ -21,21 +21,35 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
-#include "ndarray/eigen.h"
+#include "Eigen/Cholesky"
+#include "Eigen/Sparse"
 
 #include "lsst/afw/table/Source.h"
 #include "lsst/afw/detection/Psf.h"
-#include "lsst/afw/detection/FootprintArray.h"
-#include "lsst/afw/detection/FootprintArray.cc"
 #include "lsst/meas/base/PsfFlux.h"
+#include "lsst/meas/base/PsfImageCache.h"
 
 namespace lsst { namespace meas { namespace base {
 
 namespace {
 
+// Families with more fitted children than this are solved with a sparse factorization of the normal
+// equations, whose only nonzero off-diagonal terms come from children with overlapping PSF models.
+std::size_t const MAX_DENSE_FAMILY_SIZE = 64;
+
+// The joint fit fails if the smallest pivot of the LDLT factorization of its normal matrix is no more
+// than this times the largest, as when two children are (nearly) coincident: the pivoted factorization
+// would otherwise quietly zero one child's flux and give all of it to the other.
+double const MIN_PIVOT_RATIO = 1E-8;
+
+bool isDegenerate(Eigen::VectorXd const & pivots) {
+    return !(pivots.minCoeff() > MIN_PIVOT_RATIO*pivots.maxCoeff());
+}
+
 std::array<FlagDefinition,PsfFluxAlgorithm::N_FLAGS> const & getFlagDefinitions() {
     static std::array<FlagDefinition,PsfFluxAlgorithm::N_FLAGS> const flagDefs = {{
         {"flag", "general failure flag"},
@@ -45,6 +59,90 @@ std::array<FlagDefinition,PsfFluxAlgorithm::N_FLAGS> const & getFlagDefinitions(
     return flagDefs;
 }
 
+
+afw::image::MaskPixel getBadBits(PsfFluxControl const & ctrl, afw::image::Exposure<float> const & exposure) {
+    afw::image::MaskPixel badBits = 0x0;
+    for (
+        std::vector<std::string>::const_iterator i = ctrl.badMaskPlanes.begin();
+        i != ctrl.badMaskPlanes.end();
+        ++i
+    ) {
+        badBits |= exposure.getMaskedImage().getMask()->getPlaneBitMask(*i);
+    }
+    return badBits;
+}
+
+/*
+ * Sums over the unmasked pixels of a box for a pair of PSF model images a and b (which may be the same
+ * image): a*data, a*b and a*b*variance.
+ */
+struct ModelSums {
+    double modelData;
+    double modelProduct;
+    double modelProductVariance;
+    int nGood;
+};
+
+// Walk the rows of the box once, skipping masked pixels inline.  Each sum is split over independent
+// lanes so the compiler can vectorize the inner loop without reordering any one of them; masked pixels
+// are selected out (not multiplied by zero), so they may safely hold non-finite values.  The box must be
+// contained by both model images and the exposure.
+ModelSums accumulateModelSums(
+    afw::detection::Psf::Image const & a,
+    afw::detection::Psf::Image const & b,
+    afw::image::Exposure<float> const & exposure,
+    afw::geom::Box2I const & box,
+    afw::image::MaskPixel badBits
+) {
+    typedef afw::detection::Psf::Pixel PsfPixel;
+    int const N_LANES = 4;
+    std::array<PsfPixel, N_LANES> modelData = {{0.0, 0.0, 0.0, 0.0}};
+    std::array<PsfPixel, N_LANES> modelProduct = {{0.0, 0.0, 0.0, 0.0}};
+    std::array<PsfPixel, N_LANES> modelProductVariance = {{0.0, 0.0, 0.0, 0.0}};
+    std::array<int, N_LANES> nGood = {{0, 0, 0, 0}};
+
+    auto const aArray = a.getArray();
+    auto const bArray = b.getArray();
+    auto const dataArray = exposure.getMaskedImage().getImage()->getArray();
+    auto const maskArray = exposure.getMaskedImage().getMask()->getArray();
+    auto const varianceArray = exposure.getMaskedImage().getVariance()->getArray();
+    int const width = box.getWidth();
+    int const aX0 = box.getMinX() - a.getX0();
+    int const bX0 = box.getMinX() - b.getX0();
+    int const exposureX0 = box.getMinX() - exposure.getX0();
+    for (int y = box.getMinY(); y <= box.getMaxY(); ++y) {
+        PsfPixel const * modelA = aArray.getData() + (y - a.getY0())*aArray.getStrides()[0] + aX0;
+        PsfPixel const * modelB = bArray.getData() + (y - b.getY0())*bArray.getStrides()[0] + bX0;
+        float const * data = dataArray.getData()
+            + (y - exposure.getY0())*dataArray.getStrides()[0] + exposureX0;
+        afw::image::MaskPixel const * mask = maskArray.getData()
+            + (y - exposure.getY0())*maskArray.getStrides()[0] + exposureX0;
+        float const * variance = varianceArray.getData()
+            + (y - exposure.getY0())*varianceArray.getStrides()[0] + exposureX0;
+        for (int x = 0; x < width; x += N_LANES) {
+            int const nLanes = std::min(N_LANES, width - x);
+            for (int lane = 0; lane < nLanes; ++lane) {
+                bool const good = !(mask[x + lane] & badBits);
+                PsfPixel const ma = good ? modelA[x + lane] : 0.0;
+                PsfPixel const mb = good ? modelB[x + lane] : 0.0;
+                PsfPixel const d = good ? data[x + lane] : 0.0;
+                PsfPixel const v = good ? variance[x + lane] : 0.0;
+                modelData[lane] += ma*d;
+                modelProduct[lane] += ma*mb;
+                modelProductVariance[lane] += ma*mb*v;
+                nGood[lane] += good;
+            }
+        }
+    }
+    ModelSums sums;
+    sums.modelData = (modelData[0] + modelData[1]) + (modelData[2] + modelData[3]);
+    sums.modelProduct = (modelProduct[0] + modelProduct[1]) + (modelProduct[2] + modelProduct[3]);
+    sums.modelProductVariance = (modelProductVariance[0] + modelProductVariance[1])
+        + (modelProductVariance[2] + modelProductVariance[3]);
+    sums.nGood = (nGood[0] + nGood[1]) + (nGood[2] + nGood[3]);
+    return sums;
+}
+
 } // anonymous
 
 PsfFluxAlgorithm::PsfFluxAlgorithm(
@@ -73,68 +171,180 @@ void PsfFluxAlgorithm::measure(
         );
     }
     afw::geom::Point2D position = _centroidExtractor(measRecord, _flagHandler);
-    PTR(afw::detection::Psf::Image) psfImage = psf->computeImage(position);
+    CONST_PTR(afw::detection::Psf::Image) psfImage = PsfImageCache::getThreadCache().computeImage(
+        psf, position, _ctrl.psfCacheTileSize, _ctrl.psfCachePhaseSteps
+    );
     afw::geom::Box2I fitBBox = psfImage->getBBox();
     fitBBox.clip(exposure.getBBox());
     if (fitBBox != psfImage->getBBox()) {
-        _flagHandler.setValue(measRecord, FAILURE, true);  // if we had a suspect flag, we'd set that instead
-        _flagHandler.setValue(measRecord, EDGE, true);
+        // if we had a suspect flag, we'd set that instead of FAILURE
+        _flagHandler.setValues(measRecord, FlagHandler::makeMask(FAILURE) | FlagHandler::makeMask(EDGE),
+                               true);
     }
-    afw::detection::Footprint fitRegion(fitBBox);
-    if (!_ctrl.badMaskPlanes.empty()) {
-        afw::image::MaskPixel badBits = 0x0;
-        for (
-            std::vector<std::string>::const_iterator i = _ctrl.badMaskPlanes.begin();
-            i != _ctrl.badMaskPlanes.end();
-            ++i
-        ) {
-            badBits |= exposure.getMaskedImage().getMask()->getPlaneBitMask(*i);
-        }
-        fitRegion.intersectMask(*exposure.getMaskedImage().getMask(), badBits);
-    }
-    if (fitRegion.getArea() == 0) {
+    afw::image::MaskPixel badBits = getBadBits(_ctrl, exposure);
+    ModelSums sums = accumulateModelSums(*psfImage, *psfImage, exposure, fitBBox, badBits);
+    if (sums.nGood == 0) {
         throw LSST_EXCEPT(
             MeasurementError,
             _flagHandler.getDefinition(NO_GOOD_PIXELS).doc,
             NO_GOOD_PIXELS
         );
     }
-    typedef afw::detection::Psf::Pixel PsfPixel;
-    typedef afw::image::MaskedImage<float>::Variance::Pixel VarPixel;
-    ndarray::EigenView<PsfPixel,1,1,Eigen::ArrayXpr> model(
-        afw::detection::flattenArray(
-            fitRegion,
-            psfImage->getArray(),
-            psfImage->getXY0()
-        )
-    );
-    ndarray::EigenView<float,1,1,Eigen::ArrayXpr> data(
-        afw::detection::flattenArray(
-            fitRegion,
-            exposure.getMaskedImage().getImage()->getArray(),
-            exposure.getXY0()
-        )
-    );
-    ndarray::EigenView<VarPixel,1,1,Eigen::ArrayXpr> variance(
-        afw::detection::flattenArray(
-            fitRegion,
-            exposure.getMaskedImage().getVariance()->getArray(),
-            exposure.getXY0()
-        )
-    );
-    PsfPixel alpha = model.matrix().squaredNorm();
+    double alpha = sums.modelProduct;
     FluxResult result;
-    result.flux = model.matrix().dot(data.matrix().cast<PsfPixel>()) / alpha;
+    result.flux = sums.modelData / alpha;
     // If we're not using per-pixel weights to compute the flux, we'll still want to compute the
     // variance as if we had, so we'll apply the weights to the model vector now, and update alpha.
-    result.fluxSigma = std::sqrt(model.square().matrix().dot(variance.matrix().cast<PsfPixel>()))
-        / alpha;
+    result.fluxSigma = std::sqrt(sums.modelProductVariance) / alpha;
     if (!std::isfinite(result.flux) || !std::isfinite(result.fluxSigma)) {
         throw LSST_EXCEPT(PixelValueError, "Invalid pixel value detected in image.");
     }
     measRecord.set(_fluxResultKey, result);
 }
 
+void PsfFluxAlgorithm::measureN(
+    afw::table::SourceCatalog const & measCat,
+    afw::image::Exposure<float> const & exposure
+) const {
+    if (measCat.empty()) {
+        return;
+    }
+    PTR(afw::detection::Psf const) psf = exposure.getPsf();
+    if (!psf) {
+        throw LSST_EXCEPT(
+            FatalAlgorithmError,
+            "PsfFlux algorithm requires a Psf with every exposure"
+        );
+    }
+    afw::image::MaskPixel badBits = getBadBits(_ctrl, exposure);
+
+    // Realise every child's PSF model and accumulate the diagonal of the normal equations.  Children
+    // with no good pixels can't constrain the fit, so they're flagged here and left out of it.  The
+    // joint fit replaces whatever measure() wrote, so each child's result and flags are reset first, and
+    // a child that can't be measured is failed on its own rather than taking the rest of the family
+    // with it.
+    std::vector<std::size_t> indices;
+    std::vector<CONST_PTR(afw::detection::Psf::Image)> models;
+    std::vector<afw::geom::Box2I> boxes;
+    std::vector<double> modelData;
+    std::vector<Eigen::Triplet<double>> normalTerms;
+    std::vector<Eigen::Triplet<double>> varianceTerms;
+    for (std::size_t i = 0; i < measCat.size(); ++i) {
+        afw::table::SourceRecord & measRecord = measCat[i];
+        measRecord.set(_fluxResultKey, FluxResult());
+        _flagHandler.setValues(measRecord, _flagHandler.getAllMask(), false);
+        CONST_PTR(afw::detection::Psf::Image) psfImage;
+        afw::geom::Box2I fitBBox;
+        ModelSums sums;
+        try {
+            afw::geom::Point2D position = _centroidExtractor(measRecord, _flagHandler);
+            psfImage = PsfImageCache::getThreadCache().computeImage(
+                psf, position, _ctrl.psfCacheTileSize, _ctrl.psfCachePhaseSteps
+            );
+            fitBBox = psfImage->getBBox();
+            fitBBox.clip(exposure.getBBox());
+            sums = accumulateModelSums(*psfImage, *psfImage, exposure, fitBBox, badBits);
+        } catch (FatalAlgorithmError &) {
+            throw;
+        } catch (MeasurementError & error) {
+            fail(measRecord, &error);
+            continue;
+        } catch (pex::exceptions::Exception &) {
+            fail(measRecord);
+            continue;
+        }
+        if (fitBBox != psfImage->getBBox()) {
+            _flagHandler.setValues(measRecord, FlagHandler::makeMask(FAILURE) | FlagHandler::makeMask(EDGE),
+                                   true);
+        }
+        if (sums.nGood == 0) {
+            _flagHandler.setValues(measRecord,
+                                   FlagHandler::makeMask(FAILURE) | FlagHandler::makeMask(NO_GOOD_PIXELS),
+                                   true);
+            continue;
+        }
+        int const n = indices.size();
+        normalTerms.push_back(Eigen::Triplet<double>(n, n, sums.modelProduct));
+        varianceTerms.push_back(Eigen::Triplet<double>(n, n, sums.modelProductVariance));
+        indices.push_back(i);
+        models.push_back(psfImage);
+        boxes.push_back(fitBBox);
+        modelData.push_back(sums.modelData);
+    }
+    int const nFit = indices.size();
+    if (nFit == 0) {
+        return;
+    }
+
+    // Off-diagonal terms only come from pairs of children whose model boxes overlap.
+    for (int j = 0; j < nFit; ++j) {
+        for (int k = j + 1; k < nFit; ++k) {
+            afw::geom::Box2I overlap = boxes[j];
+            overlap.clip(boxes[k]);
+            if (overlap.isEmpty()) {
+                continue;
+            }
+            ModelSums sums = accumulateModelSums(*models[j], *models[k], exposure, overlap, badBits);
+            normalTerms.push_back(Eigen::Triplet<double>(j, k, sums.modelProduct));
+            normalTerms.push_back(Eigen::Triplet<double>(k, j, sums.modelProduct));
+            varianceTerms.push_back(Eigen::Triplet<double>(j, k, sums.modelProductVariance));
+            varianceTerms.push_back(Eigen::Triplet<double>(k, j, sums.modelProductVariance));
+        }
+    }
+
+    // With normal matrix F = M^T M, the fluxes are F^{-1} M^T d; as in measure(), the fit is unweighted,
+    // so their covariance is F^{-1} (M^T V M) F^{-1}, and we report the square root of its diagonal.
+    Eigen::Map<Eigen::VectorXd const> rhs(modelData.data(), nFit);
+    Eigen::VectorXd flux(nFit);
+    Eigen::VectorXd fluxVariance(nFit);
+    Eigen::SparseMatrix<double> normal(nFit, nFit);
+    Eigen::SparseMatrix<double> variance(nFit, nFit);
+    normal.setFromTriplets(normalTerms.begin(), normalTerms.end());
+    variance.setFromTriplets(varianceTerms.begin(), varianceTerms.end());
+    if (static_cast<std::size_t>(nFit) <= MAX_DENSE_FAMILY_SIZE) {
+        Eigen::MatrixXd denseNormal(normal);
+        Eigen::LDLT<Eigen::MatrixXd> solver(denseNormal);
+        if (solver.info() != Eigen::Success || !solver.isPositive() || isDegenerate(solver.vectorD())) {
+            for (int k = 0; k < nFit; ++k) {
+                _flagHandler.setValue(measCat[indices[k]], FAILURE, true);
+            }
+            return;
+        }
+        flux = solver.solve(rhs);
+        Eigen::MatrixXd inverse = solver.solve(Eigen::MatrixXd::Identity(nFit, nFit));
+        fluxVariance = (inverse * Eigen::MatrixXd(variance) * inverse).diagonal();
+    } else {
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(normal);
+        if (solver.info() != Eigen::Success || isDegenerate(solver.vectorD())) {
+            for (int k = 0; k < nFit; ++k) {
+                _flagHandler.setValue(measCat[indices[k]], FAILURE, true);
+            }
+            return;
+        }
+        flux = solver.solve(rhs);
+        Eigen::VectorXd unit = Eigen::VectorXd::Zero(nFit);
+        for (int k = 0; k < nFit; ++k) {
+            unit[k] = 1.0;
+            Eigen::VectorXd column = solver.solve(unit);
+            fluxVariance[k] = column.dot(variance * column);
+            unit[k] = 0.0;
+        }
+    }
+
+    for (int k = 0; k < nFit; ++k) {
+        afw::table::SourceRecord & measRecord = measCat[indices[k]];
+        FluxResult result;
+        result.flux = flux[k];
+        result.fluxSigma = std::sqrt(fluxVariance[k]);
+        if (!std::isfinite(result.flux) || !std::isfinite(result.fluxSigma)) {
+            // Invalid pixel values or degenerate (e.g. coincident) models; as a PixelValueError would.
+            _flagHandler.setValue(measRecord, FAILURE, true);
+            continue;
+        }
+        measRecord.set(_fluxResultKey, result);
+    }
+}
+
 void PsfFluxAlgorithm::fail(afw::table::SourceRecord & measRecord, MeasurementError * error) const {
     _flagHandler.handleFailure(measRecord, error);
 }
@@ -0,0 +1,140 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "lsst/afw/image/ImageUtils.h"
+#include "lsst/meas/base/PsfImageCache.h"
+
+namespace lsst { namespace meas { namespace base {
+
+namespace {
+
+// Quantise a residual in [-0.5, 0.5) to the nearest multiple of 1/phaseSteps that is still in that range.
+// A phase of +0.5 would be realised centred on the next pixel, and the image's bbox would then be off by
+// one from the one Psf::computeImage gives for the position we were asked about.
+int quantizePhase(double residual, int phaseSteps) {
+    int const phase = static_cast<int>(std::floor(residual*phaseSteps + 0.5));
+    return std::max(std::min(phase, (phaseSteps - 1)/2), -phaseSteps/2);
+}
+
+} // anonymous
+
+PsfImageCache::PsfImageCache(std::size_t maxPixels) :
+    _maxPixels(maxPixels), _pixelCount(0), _hitCount(0), _missCount(0), _evictionCount(0)
+{}
+
+PsfImageCache & PsfImageCache::getThreadCache() {
+    static thread_local PsfImageCache cache;
+    return cache;
+}
+
+CONST_PTR(PsfImageCache::Image) PsfImageCache::computeImage(
+    CONST_PTR(afw::detection::Psf) const & psf,
+    afw::geom::Point2D const & position,
+    int tileSize,
+    int phaseSteps
+) {
+    if (tileSize <= 0) {
+        return psf->computeImage(position);
+    }
+    if (_psf.lock() != psf) {
+        clear();
+        _psf = psf;
+    }
+    if (phaseSteps < 1) {
+        phaseSteps = 1;
+    }
+    // Psf::computeImage centres the image on the nearest pixel, shifted by the residual, so images
+    // for positions with the same residual differ only in their xy0.
+    std::pair<int, double> const irX = afw::image::positionToIndex(position.getX(), true);
+    std::pair<int, double> const irY = afw::image::positionToIndex(position.getY(), true);
+    Key const key = {{
+        tileSize,
+        phaseSteps,
+        static_cast<int>(std::floor(static_cast<double>(irX.first)/tileSize)),
+        static_cast<int>(std::floor(static_cast<double>(irY.first)/tileSize)),
+        quantizePhase(irX.second, phaseSteps),
+        quantizePhase(irY.second, phaseSteps)
+    }};
+
+    EntryMap::iterator iter = _index.find(key);
+    if (iter != _index.end()) {
+        ++_hitCount;
+        _entries.splice(_entries.begin(), _entries, iter->second);
+    } else {
+        ++_missCount;
+        Entry entry;
+        entry.key = key;
+        entry.anchor = afw::geom::Point2I(key[2]*tileSize + tileSize/2, key[3]*tileSize + tileSize/2);
+        entry.image = psf->computeImage(
+            afw::geom::Point2D(entry.anchor.getX() + static_cast<double>(key[4])/phaseSteps,
+                               entry.anchor.getY() + static_cast<double>(key[5])/phaseSteps)
+        );
+        entry.image->markPersistent();  // we don't want a long-lived cache to look like a memory leak
+        _pixelCount += entry.image->getWidth()*entry.image->getHeight();
+        _entries.push_front(entry);
+        _index[key] = _entries.begin();
+        _evict();
+    }
+
+    // Shift a shallow copy of the cached image from the anchor to the requested position
+    Entry const & entry = _entries.front();
+    PTR(Image) result = std::make_shared<Image>(*entry.image, false);
+    result->setXY0(
+        entry.image->getXY0() + afw::geom::Extent2I(irX.first - entry.anchor.getX(),
+                                                    irY.first - entry.anchor.getY())
+    );
+    return result;
+}
+
+void PsfImageCache::clear() {
+    _index.clear();
+    _entries.clear();
+    _pixelCount = 0;
+}
+
+void PsfImageCache::setMaxPixels(std::size_t maxPixels) {
+    _maxPixels = maxPixels;
+    _evict();
+}
+
+void PsfImageCache::resetCounts() {
+    _hitCount = 0;
+    _missCount = 0;
+    _evictionCount = 0;
+}
+
+void PsfImageCache::_evict() {
+    // always keep the most recently used image, even if it alone exceeds the limit
+    while (_pixelCount > _maxPixels && _entries.size() > 1) {
+        Entry const & oldest = _entries.back();
+        _pixelCount -= oldest.image->getWidth()*oldest.image->getHeight();
+        _index.erase(oldest.key);
+        _entries.pop_back();
+        ++_evictionCount;
+    }
+}
+
+}}} // namespace lsst::meas::base
@@ -63,15 +63,15 @@ void ScaledApertureFluxAlgorithm::measure(
                                                            afw::geom::ellipses::Ellipse(axes, center),
                                                            apCtrl);
     measRecord.set(_fluxResultKey, result);
-    if (result.getFlag(ApertureFluxAlgorithm::FAILURE)) {
-        _flagHandler.setValue(measRecord, ApertureFluxAlgorithm::FAILURE, true);
-    }
-    if (result.getFlag(ApertureFluxAlgorithm::APERTURE_TRUNCATED)) {
-        _flagHandler.setValue(measRecord, ApertureFluxAlgorithm::APERTURE_TRUNCATED, true);
-    }
-    if (result.getFlag(ApertureFluxAlgorithm::SINC_COEFFS_TRUNCATED)) {
-        _flagHandler.setValue(measRecord, ApertureFluxAlgorithm::SINC_COEFFS_TRUNCATED, true);
+    std::uint64_t mask = 0;
+    for (ApertureFluxAlgorithm::FlagBits flag : {ApertureFluxAlgorithm::FAILURE,
+                                                 ApertureFluxAlgorithm::APERTURE_TRUNCATED,
+                                                 ApertureFluxAlgorithm::SINC_COEFFS_TRUNCATED}) {
+        if (result.getFlag(flag)) {
+            mask |= FlagHandler::makeMask(flag);
+        }
     }
+    _flagHandler.setValues(measRecord, mask, true);
 }
 
 void ScaledApertureFluxAlgorithm::fail(afw::table::SourceRecord & measRecord,
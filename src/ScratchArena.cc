@@ -0,0 +1,116 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#include "lsst/meas/base/ScratchArena.h"
+
+namespace lsst { namespace meas { namespace base {
+
+std::size_t const ScratchArena::DEFAULT_BLOCK_SIZE;
+std::size_t const ScratchArena::ALIGNMENT;
+
+ScratchArena::Block::Block(std::size_t size_) :
+    storage(new char[size_ + ALIGNMENT]), data(nullptr), size(size_)
+{
+    std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(storage.get());
+    data = storage.get() + (ALIGNMENT - address % ALIGNMENT) % ALIGNMENT;
+}
+
+ScratchArena::ScratchArena(std::size_t blockSize) :
+    _blockSize(std::max(blockSize, ALIGNMENT)),
+    _current(0),
+    _offset(0),
+    _bytesInUse(0),
+    _highWaterMark(0),
+    _heapAllocationCount(0),
+    _resetCount(0)
+{}
+
+ScratchArena & ScratchArena::getThreadArena() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+void * ScratchArena::allocate(std::size_t bytes) {
+    // Rounding every request up to the alignment keeps every offset into a block aligned.
+    bytes = (bytes + ALIGNMENT - 1)/ALIGNMENT*ALIGNMENT;
+    // Look for room in the current block, then in any we've already moved past it into.  Whatever's
+    // left at the end of a block we skip over is wasted until the next reset.
+    while (_current < _blocks.size() && _offset + bytes > _blocks[_current].size) {
+        ++_current;
+        _offset = 0;
+    }
+    if (_current == _blocks.size()) {
+        _blocks.push_back(Block(std::max(_blockSize, bytes)));
+        ++_heapAllocationCount;
+    }
+    void * result = _blocks[_current].data + _offset;
+    _offset += bytes;
+    _bytesInUse += bytes;
+    _highWaterMark = std::max(_highWaterMark, _bytesInUse);
+    return result;
+}
+
+void ScratchArena::reset() {
+    if (_blocks.size() > 1) {
+        // Replace the blocks with one that can hold all of them, so next time we won't have to move on.
+        std::size_t const capacity = getCapacity();
+        _blocks.clear();
+        _blocks.push_back(Block(capacity));
+        ++_heapAllocationCount;
+    }
+    _current = 0;
+    _offset = 0;
+    _bytesInUse = 0;
+    ++_resetCount;
+}
+
+std::size_t ScratchArena::getCapacity() const {
+    std::size_t capacity = 0;
+    for (std::vector<Block>::const_iterator i = _blocks.begin(); i != _blocks.end(); ++i) {
+        capacity += i->size;
+    }
+    return capacity;
+}
+
+ScratchScope::ScratchScope(ScratchArena & arena) :
+    _arena(arena),
+    _current(arena._current),
+    _offset(arena._offset),
+    _bytesInUse(arena._bytesInUse),
+    _resetCount(arena._resetCount)
+{}
+
+ScratchScope::~ScratchScope() {
+    // If the arena has been reset since we were created, there's nothing of ours left to release (and
+    // the blocks we remember may be gone).
+    if (_arena._resetCount == _resetCount) {
+        _arena._current = _current;
+        _arena._offset = _offset;
+        _arena._bytesInUse = _bytesInUse;
+    }
+}
+
+}}} // namespace lsst::meas::base
@@ -21,17 +21,23 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 #include <iostream>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <list>
+#include <map>
+#include <memory>
 #include <numeric>
+#include <vector>
 #include "ndarray/eigen.h"
 #include "lsst/afw/detection/Psf.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/pex/logging/Trace.h"
-#include "lsst/afw/math/ConvolveImage.h"
-#include "lsst/afw/math/offsetImage.h"
+#include "lsst/afw/math/Kernel.h"
 #include "lsst/afw/geom/Angle.h"
 #include "lsst/afw/table/Source.h"
 #include "lsst/meas/base/SdssCentroid.h"
+#include "lsst/meas/base/ScratchArena.h"
 
 
 namespace lsst { namespace meas { namespace base {
@@ -361,53 +367,333 @@ void doMeasureCentroidImpl(double *xCenter, // output; x-position of object
     *peakVal = vpk;
 }
 
+/*
+ * A PSF kernel image, realised at a source's peak pixel or at the centre of a kernel cache cell
+ */
+struct LocalKernel {
+    int width;
+    int height;
+    int ctrX;
+    int ctrY;
+    double smoothingSigma;              // determinant radius of the PSF model where it was realised
+    double const * values;              // normalized kernel image; pixel (i, j) is values[j*width + i]
+    double const * squaredValues;       // values**2, for propagating the variance
+};
+
+/*
+ * Stand-in for a MaskedImage xy_locator, pointing into the smoothed buffers of a SmoothingWorkspace
+ */
+class SmoothedLocator {
+public:
+    SmoothedLocator(float const * image, float const * variance, int stride) :
+        _image(image), _variance(variance), _stride(stride) {}
+
+    float image(int dx, int dy) const { return _image[dy*_stride + dx]; }
+    float variance(int dx, int dy) const { return _variance[dy*_stride + dx]; }
+
+private:
+    float const * _image;
+    float const * _variance;
+    int _stride;
+};
+
+/*
+ * Realise the (normalized) local PSF kernel at a position, with its pixels allocated from a ScratchArena
+ */
+LocalKernel realiseKernel(
+    afw::detection::Psf const & psf,
+    afw::geom::Point2D const & position,
+    ScratchArena & arena
+) {
+    CONST_PTR(afw::math::Kernel) kernel = psf.getLocalKernel(position);
+    // arena images are contiguous, so the kernel image's pixels are already laid out as we want them
+    afw::image::Image<double> kernelImage = arena.makeImage<double>(
+        afw::geom::Box2I(afw::geom::Point2I(0, 0), kernel->getDimensions())
+    );
+    kernel->computeImage(kernelImage, true); // afw::math::convolve normalizes the kernel by default
+
+    LocalKernel local;
+    local.width = kernel->getWidth();
+    local.height = kernel->getHeight();
+    local.ctrX = kernel->getCtrX();
+    local.ctrY = kernel->getCtrY();
+    local.smoothingSigma = psf.computeShape(position).getDeterminantRadius();
+    int const size = local.width*local.height;
+    double const * values = kernelImage.getArray().getData();
+    double * squaredValues = static_cast<double*>(arena.allocate(sizeof(double)*size));
+    for (int i = 0; i < size; ++i) {
+        squaredValues[i] = values[i]*values[i];
+    }
+    local.values = values;
+    local.squaredValues = squaredValues;
+    return local;
+}
+
+/*
+ * Per-thread state used by smoothAndBinImage
+ *
+ * Kernels and binned pixels only live for one call, so they're allocated from the ScratchArena, and
+ * realising a kernel only allocates in Psf::getLocalKernel.  If cellSize > 0, kernels are instead copied
+ * into a cache on grids of cellSize x cellSize pixels, up to maxPixels kernel pixels in all, evicting the
+ * least recently used first.  Cached kernels are only valid for the Psf they were realised from, so the
+ * cache is flushed whenever we're handed a different one; we only hold a weak reference to it, so the
+ * cache never keeps an exposure's Psf alive.
+ */
+class SmoothingWorkspace {
+public:
+
+    static SmoothingWorkspace & get() {
+        static thread_local SmoothingWorkspace workspace;
+        return workspace;
+    }
+
+    /// The returned kernel is only valid until the next call, or until the arena is rewound.
+    LocalKernel getKernel(
+        CONST_PTR(afw::detection::Psf) const & psf,
+        afw::geom::Point2I const & center,
+        int cellSize,
+        std::size_t maxPixels,
+        ScratchArena & arena
+    );
+
+    std::array<float, 9> smoothedImage; // 3x3 neighbourhood of the peak, smoothed with the kernel
+    std::array<float, 9> smoothedVariance;
+
+private:
+
+    typedef std::array<int, 3> Key;     // cellSize, cell x, cell y
+
+    struct Entry {
+        Key key;
+        LocalKernel kernel;             // points into storage
+        std::vector<double> storage;    // kernel values, followed by their squares
+    };
+
+    typedef std::list<Entry> EntryList; // most recently used first
+    typedef std::map<Key, EntryList::iterator> EntryMap;
+
+    SmoothingWorkspace() : _pixelCount(0) {}
+
+    std::weak_ptr<afw::detection::Psf const> _psf;
+    std::size_t _pixelCount;
+    EntryList _entries;
+    EntryMap _index;
+};
+
+LocalKernel SmoothingWorkspace::getKernel(
+    CONST_PTR(afw::detection::Psf) const & psf,
+    afw::geom::Point2I const & center,
+    int cellSize,
+    std::size_t maxPixels,
+    ScratchArena & arena
+) {
+    if (cellSize <= 0) {
+        return realiseKernel(*psf, afw::geom::Point2D(center), arena);
+    }
+    if (_psf.lock() != psf) {
+        _index.clear();
+        _entries.clear();
+        _pixelCount = 0;
+        _psf = psf;
+    }
+    Key const cell = {{
+        cellSize,
+        static_cast<int>(std::floor(static_cast<double>(center.getX())/cellSize)),
+        static_cast<int>(std::floor(static_cast<double>(center.getY())/cellSize))
+    }};
+    EntryMap::const_iterator iter = _index.find(cell);
+    if (iter != _index.end()) {
+        _entries.splice(_entries.begin(), _entries, iter->second);
+        return iter->second->kernel;
+    }
+    ScratchScope scope(arena);
+    LocalKernel const local = realiseKernel(
+        *psf,
+        afw::geom::Point2D(cell[1]*cellSize + 0.5*(cellSize - 1), cell[2]*cellSize + 0.5*(cellSize - 1)),
+        arena
+    );
+    std::size_t const size = local.width*local.height;
+    _entries.push_front(Entry());
+    Entry & entry = _entries.front();
+    entry.key = cell;
+    entry.storage.resize(2*size);
+    std::copy(local.values, local.values + size, entry.storage.begin());
+    std::copy(local.squaredValues, local.squaredValues + size, entry.storage.begin() + size);
+    entry.kernel = local;
+    entry.kernel.values = &entry.storage[0];
+    entry.kernel.squaredValues = &entry.storage[size];
+    _index[cell] = _entries.begin();
+    _pixelCount += size;
+    // always keep the kernel we're about to use, even if it alone exceeds the limit
+    while (_pixelCount > maxPixels && _entries.size() > 1) {
+        Entry const & oldest = _entries.back();
+        _pixelCount -= oldest.storage.size()/2;
+        _index.erase(oldest.key);
+        _entries.pop_back();
+    }
+    return entry.kernel;
+}
+
+/*
+ * Smooth a single pixel with a kernel, as afw::math::convolve would (image and variance planes)
+ *
+ * im and var point to the lower-left corner of the pixels under the kernel, with rows imStride and
+ * varStride elements apart.
+ */
+template <typename ImagePixelT, typename VariancePixelT>
+inline void smoothPixel(
+    LocalKernel const & kernel,
+    ImagePixelT const * im, int imStride,
+    VariancePixelT const * var, int varStride,
+    double varianceScale,
+    float & smoothedImage,
+    float & smoothedVariance
+) {
+    double sumIm = 0.0;
+    double sumVar = 0.0;
+    for (int kj = 0; kj < kernel.height; ++kj) {
+        double const * k = &kernel.values[kj*kernel.width];
+        double const * k2 = &kernel.squaredValues[kj*kernel.width];
+        ImagePixelT const * imRow = im + kj*imStride;
+        VariancePixelT const * varRow = var + kj*varStride;
+        for (int ki = 0; ki < kernel.width; ++ki) {
+            sumIm += k[ki]*imRow[ki];
+            sumVar += k2[ki]*varRow[ki];
+        }
+    }
+    smoothedImage = sumIm;
+    smoothedVariance = sumVar*varianceScale;
+}
+
+/*
+ * Smooth the 3x3 neighbourhood of a pixel with a kernel, by direct dot products
+ *
+ * This is what afw::math::convolve would give for those nine pixels, without convolving anything else.
+ * im and var point to the lower-left corner of the (width + 2) x (height + 2) window of pixels under the
+ * kernel, with rows imStride and varStride elements apart.
+ */
+template <typename ImagePixelT, typename VariancePixelT>
+void smoothNeighbourhood(
+    LocalKernel const & kernel,
+    ImagePixelT const * im, int imStride,
+    VariancePixelT const * var, int varStride,
+    double varianceScale,
+    std::array<float, 9> & smoothedImage,
+    std::array<float, 9> & smoothedVariance
+) {
+    for (int dy = 0; dy < 3; ++dy) {
+        for (int dx = 0; dx < 3; ++dx) {
+            smoothPixel(kernel, im + dy*imStride + dx, imStride, var + dy*varStride + dx, varStride,
+                        varianceScale, smoothedImage[dy*3 + dx], smoothedVariance[dy*3 + dx]);
+        }
+    }
+}
+
+/*
+ * Bin the pixels around (x, y) by (binX, binY), and smooth them with the local PSF kernel
+ *
+ * Only the 3x3 neighbourhood of (x, y) that doMeasureCentroidImpl reads is smoothed.  Returns a locator
+ * to the smoothed pixel corresponding to (x, y), along with the width of the smoothing kernel.  The
+ * locator points into the thread's SmoothingWorkspace, so it's only valid until the next call; everything
+ * else we need is taken from the thread's ScratchArena, and returned to it before we return.
+ */
 template<typename MaskedImageT>
-std::pair<MaskedImageT, double>
-smoothAndBinImage(CONST_PTR(lsst::afw::detection::Psf) psf,
+std::pair<SmoothedLocator, double>
+smoothAndBinImage(CONST_PTR(lsst::afw::detection::Psf) const & psf,
             int const x, const int y,
             MaskedImageT const& mimage,
             int binX, int binY,
-            FlagHandler _flagHandler)
+            SdssCentroidControl const & ctrl,
+            FlagHandler const & _flagHandler)
 {
-    lsst::afw::geom::Point2D const center(x + mimage.getX0(), y + mimage.getY0());
-    lsst::afw::geom::ellipses::Quadrupole const& shape = psf->computeShape(center);
-    double const smoothingSigma = shape.getDeterminantRadius();
+    SmoothingWorkspace & workspace = SmoothingWorkspace::get();
+    ScratchScope scope;
+    lsst::afw::geom::Point2I const center(x + mimage.getX0(), y + mimage.getY0());
+    LocalKernel const kernel = workspace.getKernel(
+        psf, center, ctrl.kernelCacheCellSize, std::max(ctrl.kernelCacheMaxPixels, 0), scope.getArena()
+    );
+    double const smoothingSigma = kernel.smoothingSigma;
 #if 0
     double const nEffective = psf->computeEffectiveArea(); // not implemented yet (#2821)
 #else
     double const nEffective = 4*M_PI*smoothingSigma*smoothingSigma; // correct for a Gaussian
 #endif
 
-    lsst::afw::math::Kernel::ConstPtr kernel = psf->getLocalKernel(center);
-    int const kWidth = kernel->getWidth();
-    int const kHeight = kernel->getHeight();
-
-    lsst::afw::geom::BoxI bbox(lsst::afw::geom::Point2I(x - binX*(2 + kWidth/2), y - binY*(2 + kHeight/2)),
-                       lsst::afw::geom::ExtentI(binX*(3 + kWidth + 1), binY*(3 + kHeight + 1)));
+    int const kWidth = kernel.width;
+    int const kHeight = kernel.height;
 
-    // image to smooth, a shallow copy
-    PTR(MaskedImageT) subImage;
-    try {
-        subImage.reset(new MaskedImageT(mimage, bbox, lsst::afw::image::LOCAL));
-    } catch (pex::exceptions::LengthError & err) {
+    // We insist that the full (3 + kWidth + 1) x (3 + kHeight + 1) box of binned pixels we used to convolve
+    // lies within the image, so sources are flagged as EDGE exactly as they always have been.
+    int const x0 = x - binX*(2 + kWidth/2);
+    int const y0 = y - binY*(2 + kHeight/2);
+    if (x0 < 0 || y0 < 0 ||
+        x0 + binX*(3 + kWidth + 1) > mimage.getWidth() || y0 + binY*(3 + kHeight + 1) > mimage.getHeight()) {
         throw LSST_EXCEPT(
             MeasurementError,
             _flagHandler.getDefinition(SdssCentroidAlgorithm::EDGE).doc,
             SdssCentroidAlgorithm::EDGE
         );
     }
-    PTR(MaskedImageT) binnedImage = lsst::afw::math::binImage(*subImage, binX, binY, lsst::afw::math::MEAN);
-    binnedImage->setXY0(subImage->getXY0());
-    // image to smooth into, a deep copy.
-    MaskedImageT smoothedImage = MaskedImageT(*binnedImage, true);
-    assert(smoothedImage.getWidth()/2  == kWidth/2  + 2); // assumed by the code that uses smoothedImage
-    assert(smoothedImage.getHeight()/2 == kHeight/2 + 2);
-
-    lsst::afw::math::convolve(smoothedImage, *binnedImage, *kernel, lsst::afw::math::ConvolutionControl());
-    *smoothedImage.getVariance() *= binX*binY*nEffective; // We want the per-pixel variance, so undo the
-                                                    // effects of binning and smoothing
-
-    return std::make_pair(smoothedImage, smoothingSigma);
+
+    // The window of (binned) pixels under the kernel when it's centred on any of the 3x3 neighbourhood
+    int const windowWidth = kWidth + 2;
+    int const windowHeight = kHeight + 2;
+    int const windowX0 = x - binX*(1 + kernel.ctrX); // lower-left corner, in unbinned pixels
+    int const windowY0 = y - binY*(1 + kernel.ctrY);
+
+    auto const imArray = mimage.getImage()->getArray();
+    auto const varArray = mimage.getVariance()->getArray();
+    int const imStride = imArray.getStrides()[0];
+    int const varStride = varArray.getStrides()[0];
+    double const varianceScale = binX*binY*nEffective; // we want the per-pixel variance, so undo the
+                                                       // effects of binning and smoothing
+
+    if (binX == 1 && binY == 1) {
+        // no binning, so we can read the pixels in place
+        smoothNeighbourhood(kernel,
+                            imArray.getData() + windowY0*imStride + windowX0, imStride,
+                            varArray.getData() + windowY0*varStride + windowX0, varStride,
+                            varianceScale, workspace.smoothedImage, workspace.smoothedVariance);
+    } else {
+        // Bin the window, taking the mean of each binX x binY block as afw::math::binImage would
+        double * binnedImage = static_cast<double*>(
+            scope.getArena().allocate(sizeof(double)*windowWidth*windowHeight)
+        );
+        double * binnedVariance = static_cast<double*>(
+            scope.getArena().allocate(sizeof(double)*windowWidth*windowHeight)
+        );
+        double const norm = 1.0/(binX*binY);
+        for (int j = 0; j < windowHeight; ++j) {
+            double * binnedIm = binnedImage + j*windowWidth;
+            double * binnedVar = binnedVariance + j*windowWidth;
+            std::fill(binnedIm, binnedIm + windowWidth, 0.0);
+            std::fill(binnedVar, binnedVar + windowWidth, 0.0);
+            for (int ym = 0; ym < binY; ++ym) {
+                int const row = windowY0 + j*binY + ym;
+                auto const * imPtr = imArray.getData() + row*imStride + windowX0;
+                auto const * varPtr = varArray.getData() + row*varStride + windowX0;
+                for (int i = 0; i < windowWidth; ++i) {
+                    for (int xm = 0; xm < binX; ++xm, ++imPtr, ++varPtr) {
+                        binnedIm[i] += *imPtr;
+                        binnedVar[i] += *varPtr;
+                    }
+                }
+            }
+            for (int i = 0; i < windowWidth; ++i) {
+                binnedIm[i] *= norm;
+                binnedVar[i] *= norm*norm;
+            }
+        }
+        smoothNeighbourhood(kernel,
+                            binnedImage, windowWidth,
+                            binnedVariance, windowWidth,
+                            varianceScale, workspace.smoothedImage, workspace.smoothedVariance);
+    }
+
+    return std::make_pair(
+        SmoothedLocator(&workspace.smoothedImage[4], &workspace.smoothedVariance[4], 3),
+        smoothingSigma
+    );
 }
 
 std::array<FlagDefinition,SdssCentroidAlgorithm::N_FLAGS> const & getFlagDefinitions() {
@@ -485,13 +771,11 @@ void SdssCentroidAlgorithm::measure(
     int binY = 1;
     double xc=0., yc=0., dxc=0., dyc=0.;            // estimated centre and error therein
     for(int binsize = 1; binsize <= _ctrl.binmax; binsize *= 2) {
-        std::pair<MaskedImageT, double> result = smoothAndBinImage(psf, x, y, mimage, binX, binY, _flagHandler);
-        MaskedImageT const smoothedImage = result.first;
+        std::pair<SmoothedLocator, double> result =
+            smoothAndBinImage(psf, x, y, mimage, binX, binY, _ctrl, _flagHandler);
+        SmoothedLocator const mim = result.first;
         double const smoothingSigma = result.second;
 
-        MaskedImageT::xy_locator mim = smoothedImage.xy_at(smoothedImage.getWidth()/2,
-                                                                    smoothedImage.getHeight()/2);
-
         double sizeX2, sizeY2;      // object widths^2 in x and y directions
         double peakVal;             // peak intensity in image
 
@@ -539,7 +823,6 @@ void SdssCentroidAlgorithm::measure(
     _centroidChecker(measRecord);
 }
 
-
 void SdssCentroidAlgorithm::fail(afw::table::SourceRecord & measRecord, MeasurementError * error) const {
     _flagHandler.handleFailure(measRecord, error);
 }
@@ -549,7 +832,7 @@ SdssCentroidTransform::SdssCentroidTransform(
     std::string const & name,
     afw::table::SchemaMapper & mapper
 ) :
-    CentroidTransform{name, mapper}
+    CentroidTransform{name, mapper, ctrl.wcsGridCellSize, ctrl.wcsGridTolerance*afw::geom::arcseconds}
 {
     for (auto flag = getFlagDefinitions().begin() + 1; flag < getFlagDefinitions().end(); ++flag) {
         mapper.addMapping(mapper.getInputSchema().find<afw::table::Flag>(
@@ -753,9 +753,13 @@ void SdssShapeResultKey::set(afw::table::BaseRecord & record, SdssShapeResult co
     record.set(_flux_xx_Cov, value.flux_xx_Cov);
     record.set(_flux_yy_Cov, value.flux_yy_Cov);
     record.set(_flux_xy_Cov, value.flux_xy_Cov);
+    std::uint64_t setMask = 0;
+    std::uint64_t clearMask = 0;
     for (int n = 0; n < SdssShapeAlgorithm::N_FLAGS - (_includePsf ? 0 : 1); ++n) {
-        _flagHandler.setValue(record, n, value.flags[n]);
+        (value.flags[n] ? setMask : clearMask) |= FlagHandler::makeMask(n);
     }
+    _flagHandler.setValues(record, setMask, true);
+    _flagHandler.setValues(record, clearMask, false);
 }
 
 void SdssShapeResultKey::setPsfShape(afw::table::BaseRecord & record,
@@ -989,10 +993,16 @@ SdssShapeTransform::SdssShapeTransform(
 ) :
     BaseTransform{name},
     _fluxTransform{name, mapper},
-    _centroidTransform{name, mapper}
+    _centroidTransform{name, mapper, ctrl.wcsGridCellSize, ctrl.wcsGridTolerance*afw::geom::arcseconds},
+    _centroidKey(mapper.getInputSchema()[name]),
+    _inShapeKey(mapper.getInputSchema()[name])
 {
     // If the input schema has a PSF flag -- it's optional --  assume we are also transforming the PSF.
     _transformPsf = mapper.getInputSchema().getNames().count("sdssShape_flag_psf") ? true : false;
+    if (_transformPsf) {
+        _inPsfShapeKey = afwTable::QuadrupoleKey(
+            mapper.getInputSchema()[mapper.getInputSchema().join(name, "psf")]);
+    }
 
     // Skip the last flag if not transforming the PSF shape.
     for (auto flag = flagDefs.begin() + 1; flag < flagDefs.end() - (_transformPsf ? 0 : 1); flag++) {
@@ -1018,25 +1028,19 @@ void SdssShapeTransform::operator()(
     // The flux and cetroid transforms will check that the catalog lengths
     // match and throw if not, so we don't repeat the test here.
     _fluxTransform(inputCatalog, outputCatalog, wcs, calib);
-    _centroidTransform(inputCatalog, outputCatalog, wcs, calib);
 
-    CentroidResultKey centroidKey(inputCatalog.getSchema()[_name]);
-    ShapeResultKey inShapeKey(inputCatalog.getSchema()[_name]);
-    afwTable::QuadrupoleKey inPsfShapeKey;
-    if (_transformPsf) {
-        inPsfShapeKey = afwTable::QuadrupoleKey(
-            inputCatalog.getSchema()[inputCatalog.getSchema().join(_name, "psf")]);
-    }
+    // The centroid and shape transforms share the same local linearizations of the Wcs.
+    AffineWcsGrid const grid = _centroidTransform.makeWcsGrid(inputCatalog, wcs);
+    _centroidTransform.transformCentroids(inputCatalog, outputCatalog, grid);
 
     afw::table::SourceCatalog::const_iterator inSrc = inputCatalog.begin();
     afw::table::BaseCatalog::iterator outSrc = outputCatalog.begin();
     for (; inSrc != inputCatalog.end(); ++inSrc, ++outSrc) {
-        ShapeResult inShape = inShapeKey.get(*inSrc);
+        ShapeResult inShape = _inShapeKey.get(*inSrc);
         ShapeResult outShape;
 
         // The transformation from the (x, y) to the (Ra, Dec) basis.
-        afw::geom::AffineTransform crdTr = wcs.linearizePixelToSky(centroidKey.get(*inSrc).getCentroid(),
-                                                                   afw::geom::radians);
+        afw::geom::AffineTransform crdTr = grid.linearizePixelToSky(_centroidKey.get(*inSrc).getCentroid());
         outShape.setShape(inShape.getShape().transform(crdTr.getLinear()));
 
         // Transformation matrix from pixel to celestial basis.
@@ -1046,7 +1050,7 @@ void SdssShapeTransform::operator()(
         _outShapeKey.set(*outSrc, outShape);
 
         if (_transformPsf) {
-            _outPsfShapeKey.set(*outSrc, inPsfShapeKey.get(*inSrc).transform(crdTr.getLinear()));
+            _outPsfShapeKey.set(*outSrc, _inPsfShapeKey.get(*inSrc).transform(crdTr.getLinear()));
         }
     }
 }
@@ -24,10 +24,10 @@
 #include <complex>
 
 #include "boost/math/special_functions/bessel.hpp"
-#include "boost/shared_array.hpp"
 #include "fftw3.h"
 
 #include "lsst/meas/base/SincCoeffs.h"
+#include "lsst/meas/base/ScratchArena.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Integrate.h"
 
@@ -356,8 +356,11 @@ typename afw::image::Image<PixelT>::Ptr calcImageKSpaceCplx(double const rad1, d
     int xcen = wid/2, ycen = wid/2;
     FftShifter fftshift(wid);
 
-    boost::shared_array<std::complex<double> > cimg(new std::complex<double>[wid*wid]);
-    std::complex<double> *c = cimg.get();
+    // the transform is done in place, in scratch space we give back as soon as we're done with it
+    ScratchScope scope;
+    std::complex<double> *c = static_cast<std::complex<double>*>(
+        scope.getArena().allocate(sizeof(std::complex<double>)*wid*wid)
+    );
     // fftplan args: nx, ny, *in, *out, direction, flags
     // - done in-situ if *in == *out
     fftw_plan plan = fftw_plan_dft_2d(wid, wid,
@@ -365,7 +368,7 @@ typename afw::image::Image<PixelT>::Ptr calcImageKSpaceCplx(double const rad1, d
                                       reinterpret_cast<fftw_complex*>(c),
                                       FFTW_BACKWARD, FFTW_ESTIMATE);
 
-    // compute the k-space values and put them in the cimg array
+    // compute the k-space values and put them in the scratch array
     double const twoPiRad1 = afw::geom::TWOPI*rad1;
     double const twoPiRad2 = afw::geom::TWOPI*rad2;
     double const scale = (1.0 - ellipticity);
@@ -440,13 +443,14 @@ typename afw::image::Image<PixelT>::Ptr calcImageKSpaceReal(double const rad1, d
     int xcen = wid/2, ycen = wid/2;
     FftShifter fftshift(wid);
 
-    boost::shared_array<double> cimg(new double[wid*wid]);
-    double *c = cimg.get();
+    // the transform is done in place, in scratch space we give back as soon as we're done with it
+    ScratchScope scope;
+    double *c = static_cast<double*>(scope.getArena().allocate(sizeof(double)*wid*wid));
     // fftplan args: nx, ny, *in, *out, kindx, kindy, flags
     // - done in-situ if *in == *out
     fftw_plan plan = fftw_plan_r2r_2d(wid, wid, c, c, FFTW_R2HC, FFTW_R2HC, FFTW_ESTIMATE);
 
-    // compute the k-space values and put them in the cimg array
+    // compute the k-space values and put them in the scratch array
     double const twoPiRad1 = afw::geom::TWOPI*rad1;
     double const twoPiRad2 = afw::geom::TWOPI*rad2;
     for (int iY = 0; iY < wid; ++iY) {
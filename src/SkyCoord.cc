@@ -0,0 +1,58 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/afw/table/Source.h"
+#include "lsst/meas/base/AffineWcsGrid.h"
+#include "lsst/meas/base/SkyCoord.h"
+
+namespace lsst { namespace meas { namespace base {
+
+SkyCoordAlgorithm::SkyCoordAlgorithm(
+    Control const & ctrl,
+    std::string const & name,
+    afw::table::Schema & schema
+) : _ctrl(ctrl), _name(name)
+{}
+
+void SkyCoordAlgorithm::measure(
+    afw::table::SourceRecord & measRecord,
+    afw::image::Exposure<float> const & exposure
+) const {
+    if (!exposure.hasWcs()) {
+        throw LSST_EXCEPT(pex::exceptions::LogicError,
+                          "Wcs not attached to exposure.  Required for " + _name + " algorithm");
+    }
+    PTR(AffineWcsGrid const) grid = AffineWcsGrid::getCached(
+        exposure.getWcs(),
+        afw::geom::Box2D(exposure.getBBox(afw::image::PARENT)),
+        _ctrl.wcsGridCellSize,
+        _ctrl.wcsGridTolerance*afw::geom::arcseconds
+    );
+    if (grid->isEnabled()) {
+        measRecord.setCoord(grid->pixelToSky(measRecord.getCentroid()));
+    } else {
+        measRecord.updateCoord(*exposure.getWcs());
+    }
+}
+
+}}} // namespace lsst::meas::base
@@ -0,0 +1,98 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/base/SourceFamilies.h"
+
+namespace lsst { namespace meas { namespace base {
+
+SourceFamilies::SourceFamilies(afw::table::SourceCatalog const & catalog) :
+    _parentIndex(catalog.size(), -1),
+    _childOffsets(catalog.size() + 1, 0)
+{
+    std::size_t const size = catalog.size();
+
+    // Look up parents by binary search in the (id, index) pairs sorted by id.
+    std::vector<std::pair<afw::table::RecordId, std::size_t>> ids;
+    ids.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        ids.emplace_back(catalog[i].getId(), i);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (std::size_t i = 0; i < size; ++i) {
+        afw::table::RecordId const parent = catalog[i].getParent();
+        if (parent == 0) {
+            _parents.push_back(i);
+            continue;
+        }
+        auto iter = std::lower_bound(ids.begin(), ids.end(), std::make_pair(parent, std::size_t(0)));
+        if (iter == ids.end() || iter->first != parent) {
+            throw LSST_EXCEPT(
+                pex::exceptions::RuntimeError,
+                "Reference catalog contains a child for which at least "
+                "one parent in its parent chain is not in the catalog."
+            );
+        }
+        _parentIndex[i] = iter->second;
+        ++_childOffsets[iter->second + 1];
+    }
+
+    // Every chain must end at a record with no parent.  Chains are followed at most once each: a
+    // record is marked once its chain is known to be good.
+    std::vector<char> good(size, 0);
+    std::vector<std::size_t> chain;
+    for (std::size_t i = 0; i < size; ++i) {
+        chain.clear();
+        long j = i;
+        while (j >= 0 && !good[j]) {
+            if (chain.size() > size) {
+                throw LSST_EXCEPT(
+                    pex::exceptions::RuntimeError,
+                    "Reference catalog contains a circular parent chain."
+                );
+            }
+            chain.push_back(j);
+            j = _parentIndex[j];
+        }
+        for (std::size_t k : chain) {
+            good[k] = 1;
+        }
+    }
+
+    // Children of each record, in catalog order, as a compressed list.
+    for (std::size_t i = 0; i < size; ++i) {
+        _childOffsets[i + 1] += _childOffsets[i];
+    }
+    _children.resize(_childOffsets[size]);
+    std::vector<std::size_t> next(_childOffsets.begin(), _childOffsets.end() - 1);
+    for (std::size_t i = 0; i < size; ++i) {
+        if (_parentIndex[i] >= 0) {
+            _children[next[_parentIndex[i]]++] = i;
+        }
+    }
+}
+
+}}} // namespace lsst::meas::base
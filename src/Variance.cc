@@ -0,0 +1,121 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+#include "lsst/afw/geom/ellipses.h"
+#include "lsst/afw/detection/Footprint.h"
+#include "lsst/afw/table/Source.h"
+#include "lsst/meas/base/Variance.h"
+
+namespace lsst { namespace meas { namespace base {
+
+namespace {
+
+// Return the median of a non-empty vector, partially reordering it.  As with numpy.median, the median
+// of an even number of values is the mean of the two central ones.
+double computeMedian(std::vector<float> & values) {
+    std::vector<float>::iterator middle = values.begin() + values.size()/2;
+    std::nth_element(values.begin(), middle, values.end());
+    double median = *middle;
+    if (values.size() % 2 == 0) {
+        median = 0.5*(median + *std::max_element(values.begin(), middle));
+    }
+    return median;
+}
+
+} // anonymous
+
+VarianceAlgorithm::VarianceAlgorithm(
+    Control const & ctrl,
+    std::string const & name,
+    afw::table::Schema & schema
+) : _ctrl(ctrl),
+    _valueKey(schema.addField<double>(name + "_value", "Variance at object position"))
+{
+    static std::array<FlagDefinition,N_FLAGS> const flagDefs = {{
+        {"flag", "Set to True for any fatal failure"},
+        {"flag_emptyFootprint", "Set to True when the footprint has no usable pixels"}
+    }};
+    _flagHandler = FlagHandler::addFields(schema, name, flagDefs.begin(), flagDefs.end());
+    // Alias the badCentroid flag to that which is defined for the target of the centroid slot.
+    // We do not simply rely on the alias because that could be changed post-measurement.
+    schema.getAliasMap()->set(name + "_flag_badCentroid", schema.getAliasMap()->apply("slot_Centroid_flag"));
+}
+
+void VarianceAlgorithm::measure(
+    afw::table::SourceRecord & measRecord,
+    afw::image::Exposure<float> const & exposure
+) const {
+    if (measRecord.getCentroidFlag()) {
+        throw LSST_EXCEPT(MeasurementError, "Source record has a bad centroid.", BAD_CENTROID);
+    }
+    // Create an aperture and grow it by the configured scale to ensure there are enough pixels
+    // around the object to get decent statistics
+    afw::geom::ellipses::Quadrupole core(measRecord.getShape());
+    core.scale(_ctrl.scale);
+    afw::detection::Footprint foot(afw::geom::ellipses::Ellipse(core, measRecord.getCentroid()));
+    foot.clipTo(exposure.getBBox(afw::image::PARENT));
+
+    typedef afw::image::Exposure<float>::MaskedImageT MaskedImageT;
+    MaskedImageT const & mimage = exposure.getMaskedImage();
+    MaskedImageT::Mask const & mask = *mimage.getMask();
+    MaskedImageT::Variance const & variance = *mimage.getVariance();
+    afw::image::MaskPixel const badBits = MaskedImageT::Mask::getPlaneBitMask(_ctrl.mask);
+
+    // Gather the variance of every pixel not excluded by the mask; the buffer is kept between calls
+    // so it only grows to the size of the largest aperture seen.
+    static thread_local std::vector<float> values;
+    values.clear();
+    for (auto const & span : foot.getSpans()) {
+        int const x0 = span->getX0() - mimage.getX0();
+        int const y = span->getY() - mimage.getY0();
+        MaskedImageT::Mask::x_iterator maskIter = mask.x_at(x0, y);
+        MaskedImageT::Variance::x_iterator varIter = variance.x_at(x0, y);
+        for (int n = span->getWidth(); n > 0; --n, ++maskIter, ++varIter) {
+            if (!(*maskIter & badBits)) {
+                values.push_back(*varIter);
+            }
+        }
+    }
+    if (values.empty()) {
+        throw LSST_EXCEPT(MeasurementError,
+                          "Footprint empty, or all pixels are masked, can't compute median",
+                          EMPTY_FOOTPRINT);
+    }
+    measRecord.set(_valueKey, computeMedian(values));
+}
+
+void VarianceAlgorithm::fail(afw::table::SourceRecord & measRecord, MeasurementError * error) const {
+    measRecord.set(_valueKey, std::numeric_limits<double>::quiet_NaN());
+    // BAD_CENTROID is handled by the alias to the centroid flag.
+    if (error && error->getFlagBit() == BAD_CENTROID) {
+        error = NULL;
+    }
+    _flagHandler.handleFailure(measRecord, error);
+}
+
+}}} // namespace lsst::meas::base
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import numpy
+
+import lsst.afw.geom
+import lsst.afw.image
+import lsst.afw.table
+import lsst.utils.tests
+import lsst.meas.base
+import lsst.meas.base.tests
+
+
+class AffineWcsGridTestCase(lsst.utils.tests.TestCase):
+
+    def setUp(self):
+        self.bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0),
+                                        lsst.afw.geom.Extent2I(100, 100))
+        self.dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        self.wcs = self.dataset.exposure.getWcs()
+        self.calib = self.dataset.exposure.getCalib()
+        self.tolerance = 1E-3*lsst.afw.geom.arcseconds
+
+    def tearDown(self):
+        del self.bbox
+        del self.dataset
+        del self.wcs
+        del self.calib
+        del self.tolerance
+
+    def testWcsGrid(self):
+        """Test that the gridded Wcs approximation used by the transforms agrees with the full Wcs to
+        within its tolerance, and falls back to the full Wcs outside the grid.
+        """
+        grid = lsst.meas.base.AffineWcsGrid(self.wcs, lsst.afw.geom.Box2D(self.bbox), 32.0, self.tolerance)
+        self.assertEqual(grid.getCellCount(), 5*5)
+        self.assertGreater(grid.getValidCellCount(), 0)
+        numpy.random.seed(5)
+        for x, y in zip(numpy.random.uniform(-20, 120, 50), numpy.random.uniform(-30, 130, 50)):
+            point = lsst.afw.geom.Point2D(x, y)
+            self.assertLessEqual(grid.pixelToSky(point).angularSeparation(self.wcs.pixelToSky(point)),
+                                 self.tolerance)
+        outside = lsst.afw.geom.Point2D(500.0, 500.0)
+        self.assertEqual(grid.pixelToSky(outside), self.wcs.pixelToSky(outside).toIcrs())
+        disabled = lsst.meas.base.AffineWcsGrid(self.wcs, lsst.afw.geom.Box2D(self.bbox), 32.0,
+                                                0.0*lsst.afw.geom.arcseconds)
+        self.assertEqual(disabled.getValidCellCount(), 0)
+        center = lsst.afw.geom.Point2D(50.1, 49.8)
+        self.assertEqual(disabled.pixelToSky(center), self.wcs.pixelToSky(center).toIcrs())
+
+    def makeInputCatalog(self, AlgClass, control, name, nSources=200):
+        """Make a catalog with the fields of AlgClass, with random values everywhere, random positions
+        within the bounding box and (if there's a shape) random positive-definite moments.
+
+        There are enough sources for the transforms to use the grid (at least 4 per 32-pixel cell).
+        """
+        schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        schema.getAliasMap().set("slot_Centroid", "dummy")
+        schema.getAliasMap().set("slot_Shape", "dummy")
+        AlgClass(control, name, schema)
+        schema.getAliasMap().erase("slot_Centroid")
+        schema.getAliasMap().erase("slot_Shape")
+        catalog = lsst.afw.table.SourceCatalog(schema)
+        numpy.random.seed(6)
+        fields = [item.key for item in schema.extract(name + "_*").itervalues()
+                  if item.field.getTypeString() in ("D", "F")]
+        for i in range(nSources):
+            record = catalog.addNew()
+            for key in fields:
+                record.set(key, numpy.random.uniform(0.1, 1.0))
+            record.set(name + "_x", numpy.random.uniform(0.0, 99.0))
+            record.set(name + "_y", numpy.random.uniform(0.0, 99.0))
+            if name + "_xx" in schema:
+                record.set(name + "_xx", numpy.random.uniform(2.0, 6.0))
+                record.set(name + "_yy", numpy.random.uniform(2.0, 6.0))
+                record.set(name + "_xy", numpy.random.uniform(-1.0, 1.0))
+        return catalog
+
+    def applyTransform(self, TransformClass, control, name, inputCatalog):
+        mapper = lsst.afw.table.SchemaMapper(inputCatalog.schema)
+        transform = TransformClass(control, name, mapper)
+        outputCatalog = lsst.afw.table.BaseCatalog(mapper.getOutputSchema())
+        outputCatalog.extend(inputCatalog, mapper=mapper)
+        transform(inputCatalog, outputCatalog, self.wcs, self.calib)
+        return outputCatalog
+
+    def checkGridTransform(self, AlgClass, TransformClass, ControlClass, name):
+        """Check that a transform's outputs with the grid enabled agree with those from the full Wcs:
+        positions to within the tolerance, and all the other (linearized) fields closely.
+        """
+        control = ControlClass()
+        control.wcsGridCellSize = 32.0
+        inputCatalog = self.makeInputCatalog(AlgClass, control, name)
+        full = self.applyTransform(TransformClass, control, name, inputCatalog)
+        control.wcsGridTolerance = self.tolerance.asArcseconds()
+        gridded = self.applyTransform(TransformClass, control, name, inputCatalog)
+        coordKey = lsst.afw.table.CoordKey(full.schema[name])
+        separations = [coordKey.get(g).angularSeparation(coordKey.get(f)) for g, f in zip(gridded, full)]
+        self.assertLessEqual(max(separations), self.tolerance)
+        # the grid must actually have been used for this test to mean anything
+        self.assertGreater(max(separations), 0.0*lsst.afw.geom.radians)
+        for item in full.schema.extract(name + "_*").itervalues():
+            if item.field.getTypeString() in ("D", "F"):
+                expected = full.get(item.key)
+                # some (e.g. off-diagonal) elements may be close to zero, so scale to the whole column
+                self.assertClose(gridded.get(item.key), expected, rtol=1E-3,
+                                 atol=1E-3*numpy.abs(expected).max())
+
+    def testCentroidTransform(self):
+        """Test the AffineWcsGrid path of CentroidTransform, which also covers its use by SdssCentroid."""
+        self.checkGridTransform(lsst.meas.base.SdssCentroidAlgorithm, lsst.meas.base.SdssCentroidTransform,
+                                lsst.meas.base.SdssCentroidControl, "base_SdssCentroid")
+
+    def testSdssShapeTransform(self):
+        """Test the AffineWcsGrid path of SdssShapeTransform, which shares the grid's linearizations
+        between the centroid and the moments.
+        """
+        self.checkGridTransform(lsst.meas.base.SdssShapeAlgorithm, lsst.meas.base.SdssShapeTransform,
+                                lsst.meas.base.SdssShapeControl, "base_SdssShape")
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(AffineWcsGridTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
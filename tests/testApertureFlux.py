@@ -267,6 +267,11 @@ class ApertureFluxTransformTestCase(FluxTransformTestCase, SingleFramePluginTran
         FluxTransformTestCase.testTransform(self,
             [ApertureFluxAlgorithm.makeFieldPrefix(self.name, r) for r in self.control.radii])
 
+    def testTransformNonContiguous(self):
+        """Apply the ApertureFluxTransform to a synthetic SourceCatalog that isn't contiguous."""
+        FluxTransformTestCase.testTransformNonContiguous(self,
+            [ApertureFluxAlgorithm.makeFieldPrefix(self.name, r) for r in self.control.radii])
+
 
 def suite():
     """Returns a suite containing all the test cases in this module."""
@@ -25,6 +25,7 @@ import unittest
 import numpy
 
 import lsst.utils.tests
+import lsst.pex.exceptions
 import lsst.meas.base.tests
 import lsst.afw.image as afwImage
 import lsst.afw.table as afwTable
@@ -49,16 +50,21 @@ def initializeSourceCatalog(schema=None, name=None, flux=None, sigma=None, centr
 
 class ApplyApCorrTestCase(lsst.meas.base.tests.AlgorithmTestCase):
 
-    def setUp(self):
+    @staticmethod
+    def makeSchema(name, flagType=float):
         schema = afwTable.SourceTable.makeMinimalSchema()
-        name = "test"
-        addApCorrName(name)
         schema.addField(name + "_flux", type=float)
         schema.addField(name + "_fluxSigma", type=float)
-        schema.addField(name + "_flag", type=float)
+        schema.addField(name + "_flag", type=flagType)
         schema.addField(name + "_Centroid_x", type=float)
         schema.addField(name + "_Centroid_y", type=float)
         schema.getAliasMap().set('slot_Centroid', name + '_Centroid')
+        return schema
+
+    def setUp(self):
+        name = "test"
+        addApCorrName(name)
+        schema = self.makeSchema(name)
         self.ap_corr_task = applyApCorr.ApplyApCorrTask(schema=schema)
         self.name = name
         self.schema = schema
@@ -154,6 +160,56 @@ class ApplyApCorrTestCase(lsst.meas.base.tests.AlgorithmTestCase):
 
         self.assertAlmostEqual(sourceCat[fluxKey], source_test_flux / 2)
 
+    def testManySources(self):
+        # Check that every source in a catalog is corrected by the model evaluated at its own centroid
+        fluxName = self.name + "_flux"
+        fluxSigmaName = self.name + "_fluxSigma"
+        fluxKey = self.schema.find(fluxName).key
+        centroidKey = afwTable.Point2DKey(self.schema["slot_Centroid"])
+        sourceCat = afwTable.SourceCatalog(self.schema)
+        for i in range(10):
+            source = sourceCat.addNew()
+            source.set(fluxKey, 5.0 + i)
+            source.set(fluxSigmaName, 0.1)
+            source.set(centroidKey, afwGeom.Point2D(i, 9.0 - i))
+
+        apCorrMap = afwImage.ApCorrMap()
+        bbox = afwGeom.Box2I(afwGeom.Point2I(0, 0), afwGeom.ExtentI(10, 10))
+        coefficients = numpy.array([[1.0, 0.1], [0.0, 0.0]])
+        apCorrMap[fluxName] = ChebyshevBoundedField(bbox, coefficients)
+        apCorrMap[fluxSigmaName] = ChebyshevBoundedField(bbox, numpy.zeros((1, 1), dtype=float))
+        self.ap_corr_task.run(sourceCat, apCorrMap)
+
+        for i, source in enumerate(sourceCat):
+            apCorr = apCorrMap[fluxName].evaluate(source.getCentroid())
+            self.assertFalse(source.get(self.name + "_flag_apCorr"))
+            self.assertAlmostEqual(source.get(self.name + "_apCorr"), apCorr)
+            self.assertAlmostEqual(source.get(fluxKey), (5.0 + i)*apCorr)
+
+    def testFluxFlagTypes(self):
+        # Check that the flux's failure flag is set when correction fails, and restored when it succeeds,
+        # whether it's a Flag or (as in older schemas) a double
+        for flagType in ("Flag", float):
+            schema = self.makeSchema(self.name, flagType)
+            task = applyApCorr.ApplyApCorrTask(schema=schema)
+            fluxName = self.name + "_flux"
+            fluxSigmaName = self.name + "_fluxSigma"
+            bbox = afwGeom.Box2I(afwGeom.Point2I(0, 0), afwGeom.ExtentI(10, 10))
+            for coefficient, failed in ((-1.0, True), (1.0, False)):
+                sourceCat = initializeSourceCatalog(schema=schema, name=self.name, flux=5.0, sigma=0.1,
+                                                    centroid=afwGeom.Point2D(5, 7.1))
+                apCorrMap = afwImage.ApCorrMap()
+                apCorrMap[fluxName] = ChebyshevBoundedField(bbox, numpy.array([[coefficient]]))
+                apCorrMap[fluxSigmaName] = ChebyshevBoundedField(bbox, numpy.zeros((1, 1), dtype=float))
+                task.run(sourceCat, apCorrMap)
+                self.assertEqual(bool(sourceCat[0].get(self.name + "_flag")), failed)
+                self.assertEqual(sourceCat[0].get(self.name + "_flag_apCorr"), failed)
+
+    def testBadFluxFlagType(self):
+        # A flux flag that's neither a Flag nor a double can't be used, and should say so up front
+        schema = self.makeSchema(self.name, "I")
+        self.assertRaises(lsst.pex.exceptions.TypeError, applyApCorr.ApplyApCorrTask, schema=schema)
+
     def testCatFluxSigma(self):
         """
         Important note! This test will break if UseNaiveFluxSigma = False
@@ -22,6 +22,8 @@
 #
 
 from contextlib import contextmanager
+import math
+import struct
 import unittest
 
 import lsst.daf.base
@@ -73,6 +75,31 @@ class BlendednessTestCase(AlgorithmTestCase):
         self.assertTrue(catalog[1].get('base_Blendedness_abs_flux') > 0)
         self.assertTrue(catalog[2].get('base_Blendedness_abs_flux') > 0)
 
+class FastMathTestCase(lsst.utils.tests.TestCase):
+    """Test the single-precision approximations Blendedness uses against the standard library."""
+
+    @staticmethod
+    def toFloat(x):
+        """Round a Python float to single precision, as the C++ functions will."""
+        return struct.unpack("f", struct.pack("f", x))[0]
+
+    def testFastExp(self):
+        n = 200000
+        for i in range(n + 1):
+            x = self.toFloat(-87.0*i/n)
+            self.assertLess(abs(lsst.meas.base.fastExp(x)/math.exp(x) - 1.0), 3E-7)
+        # NaN propagates, as it does through math.exp
+        self.assertTrue(math.isnan(math.exp(float("nan"))))
+        self.assertTrue(math.isnan(lsst.meas.base.fastExp(float("nan"))))
+
+    def testFastErfc(self):
+        n = 200000
+        for i in range(n + 1):
+            x = self.toFloat(-10.0 + 20.0*i/n)
+            result = lsst.meas.base.fastErfc(x, lsst.meas.base.fastExp(-x*x))
+            self.assertLess(abs(result - math.erfc(x)), 1E-6)
+
+
 def suite():
     """Returns a suite containing all the test cases in this module."""
 
@@ -80,6 +107,7 @@ def suite():
 
     suites = []
     suites += unittest.makeSuite(BlendednessTestCase)
+    suites += unittest.makeSuite(FastMathTestCase)
     suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
     return unittest.TestSuite(suites)
 
@@ -23,6 +23,8 @@
 
 import unittest
 
+import numpy
+
 import lsst.utils.tests
 import lsst.meas.base.tests
 import lsst.meas.base as measBase
@@ -117,6 +119,34 @@ class ClassificationTestCase(lsst.meas.base.tests.AlgorithmTestCase):
         abConfig.plugins["base_ClassificationExtendedness"].psfErrFactor = 1.
         self.assertTrue(runFlagTest(psfFluxSigma=float("NaN")))
 
+    def testBurnCatalog(self):
+        """Test that classifying a whole catalog through its columns agrees with classifying each record,
+        including the failures.
+        """
+        config = measBase.SingleFrameMeasurementConfig()
+        config.slots.psfFlux = "base_PsfFlux"
+        config.slots.modelFlux = "base_GaussianFlux"
+        task = self.makeSingleFrameMeasurementTask(config=config)
+        abTask = afterburners.AfterburnerTask(schema=task.schema)
+        plugin = abTask.plugins["base_ClassificationExtendedness"]
+        exposure, catalog = self.dataset.realize(10.0, task.schema)
+        task.run(exposure, catalog)
+        for psfFlux, psfFluxFlag in [(50.0, False), (float("NaN"), False), (100.0, True)]:
+            source = catalog.addNew()
+            source.set("base_PsfFlux_flux", psfFlux)
+            source.set("base_PsfFlux_flag", psfFluxFlag)
+            source.set("base_GaussianFlux_flux", 100.0)
+        catalog = catalog.copy(deep=True)
+        expected = catalog.copy(deep=True)
+        for source in expected:
+            plugin.burn(source)
+        abTask.run(catalog)
+        for source, expectedSource in zip(catalog, expected):
+            for name in ("base_ClassificationExtendedness_flag", "base_ClassificationExtendedness_value"):
+                self.assertEqual(numpy.isnan(source.get(name)), numpy.isnan(expectedSource.get(name)))
+                if not numpy.isnan(expectedSource.get(name)):
+                    self.assertEqual(source.get(name), expectedSource.get(name))
+
 
 def suite():
     """Returns a suite containing all the test cases in this module."""
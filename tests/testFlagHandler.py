@@ -225,6 +225,67 @@ class FlagHandlerTestCase(AlgorithmTestCase):
         self.assertFalse(fh.getValue(record, FIRST))
         self.assertTrue(fh.getValue(record, SECOND))
 
+    def testFlagHandlerBatch(self):
+        """Test setting, querying and clearing several flags at once."""
+        schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        FAILURE, FIRST, SECOND = range(3)
+        flagDefs = [FlagDefinition("flag", "general failure error"),
+                    FlagDefinition("flag_first", "this is the first failure type"),
+                    FlagDefinition("flag_second", "this is the second failure type")]
+        fh = FlagHandler.addFields(schema, "test", FlagDefinitionVector(flagDefs))
+        catalog = lsst.afw.table.SourceCatalog(schema)
+        for i in range(4):
+            catalog.addNew()
+
+        record = catalog[0]
+        self.assertFalse(fh.anySet(record))
+        fh.setValues(record, FlagHandler.makeMask(FAILURE) | FlagHandler.makeMask(SECOND), True)
+        self.assertTrue(fh.getValue(record, FAILURE))
+        self.assertFalse(fh.getValue(record, FIRST))
+        self.assertTrue(fh.getValue(record, SECOND))
+        self.assertTrue(fh.anySet(record))
+        self.assertTrue(fh.anySet(record, FlagHandler.makeMask(SECOND)))
+        self.assertFalse(fh.anySet(record, FlagHandler.makeMask(FIRST)))
+        fh.setValues(record, FlagHandler.makeMask(SECOND), False)
+        self.assertTrue(fh.getValue(record, FAILURE))
+        self.assertFalse(fh.getValue(record, SECOND))
+
+        for record in catalog:
+            fh.setValues(record, fh.getAllMask(), True)
+        fh.clearAll(catalog, 1, 3)
+        for i, record in enumerate(catalog):
+            for flag in (FAILURE, FIRST, SECOND):
+                self.assertEqual(fh.getValue(record, flag), i not in (1, 2))
+
+        # clearAll also accepts a BaseCatalog
+        baseCatalog = lsst.afw.table.BaseCatalog(schema)
+        for i in range(3):
+            fh.setValues(baseCatalog.addNew(), fh.getAllMask(), True)
+        fh.clearAll(baseCatalog, 2, 10)
+        for i, record in enumerate(baseCatalog):
+            for flag in (FAILURE, FIRST, SECOND):
+                self.assertEqual(fh.getValue(record, flag), i != 2)
+
+        self.assertRaises(lsst.pex.exceptions.LengthError, FlagHandler.makeMask, 64)
+
+    def testFlagHandlerBatchManyFlags(self):
+        """Test the batch methods with more flags than a mask can select."""
+        schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        nFlags = 70
+        flagDefs = [FlagDefinition("flag", "general failure error")]
+        flagDefs += [FlagDefinition("flag_%d" % i, "failure type %d" % i) for i in range(1, nFlags)]
+        fh = FlagHandler.addFields(schema, "test", FlagDefinitionVector(flagDefs))
+        self.assertEqual(fh.getAllMask(), 2**64 - 1)
+        catalog = lsst.afw.table.SourceCatalog(schema)
+        record = catalog.addNew()
+        fh.setValues(record, FlagHandler.makeMask(63) | FlagHandler.makeMask(1), True)
+        self.assertEqual([i for i in range(nFlags) if fh.getValue(record, i)], [1, 63])
+        self.assertTrue(fh.anySet(record, FlagHandler.makeMask(63)))
+        fh.handleFailure(record, MeasurementError(fh.getDefinition(66).doc, 66).cpp)
+        self.assertEqual([i for i in range(nFlags) if fh.getValue(record, i)], [0, 1, 63, 66])
+        fh.clearAll(catalog, 0, 1)
+        self.assertEqual([i for i in range(nFlags) if fh.getValue(record, i)], [])
+
     # This and the following tests using the toy plugin, and demonstrate how
     # the flagHandler is used.
 
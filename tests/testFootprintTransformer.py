@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import numpy
+
+import lsst.afw.detection
+import lsst.afw.geom
+import lsst.afw.geom.ellipses
+import lsst.afw.table
+import lsst.meas.base
+import lsst.meas.base.tests
+import lsst.pex.exceptions
+import lsst.utils.tests
+
+
+@lsst.meas.base.register("test_FootprintFlux")
+class FootprintFluxTestPlugin(lsst.meas.base.ForcedPlugin):
+    """A forced measurement plugin that simply sums the flux inside the source's Footprint."""
+
+    @staticmethod
+    def getExecutionOrder():
+        return 2.0
+
+    def __init__(self, config, name, schemaMapper, metadata):
+        lsst.meas.base.ForcedPlugin.__init__(self, config, name, schemaMapper, metadata)
+        self.fluxKey = schemaMapper.editOutputSchema().addField("%s_flux" % name, type=float,
+                                                                doc="flux inside footprint")
+
+    def measure(self, measRecord, exposure, refRecord, refWcs):
+        footprint = measRecord.getFootprint()
+        fullArray = exposure.getMaskedImage().getImage().getArray()
+        insideArray = numpy.zeros(footprint.getArea(), dtype=fullArray.dtype)
+        lsst.afw.detection.flattenArray(footprint, fullArray, insideArray, exposure.getXY0())
+        measRecord.set(self.fluxKey, float(insideArray.sum()))
+
+
+class FootprintTransformerTestCase(lsst.meas.base.tests.AlgorithmTestCase):
+
+    def setUp(self):
+        self.bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(-20, -30),
+                                        lsst.afw.geom.Extent2I(240, 160))
+        self.dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        self.dataset.addSource(100000.0, lsst.afw.geom.Point2D(50.1, 49.8))
+        self.dataset.addSource(100000.0, lsst.afw.geom.Point2D(149.9, 50.3),
+                               lsst.afw.geom.ellipses.Quadrupole(8, 9, 3))
+        with self.dataset.addBlend() as family:
+            family.addChild(60000.0, lsst.afw.geom.Point2D(90.2, 100.4))
+            family.addChild(40000.0, lsst.afw.geom.Point2D(96.7, 104.1))
+        self.refWcs = self.dataset.exposure.getWcs()
+        self.measWcs = self.dataset.makePerturbedWcs(self.refWcs)
+        self.region = self.dataset.transform(self.measWcs).exposure.getBBox()
+
+    def tearDown(self):
+        del self.bbox
+        del self.dataset
+        del self.refWcs
+        del self.measWcs
+        del self.region
+
+    def makeHeavies(self):
+        """Return the parent Footprints of the dataset as HeavyFootprints on a realized exposure."""
+        schema = lsst.meas.base.tests.TestDataset.makeMinimalSchema()
+        exposure, catalog = self.dataset.realize(10.0, schema)
+        return [lsst.afw.detection.makeHeavyFootprint(record.getFootprint(), exposure.getMaskedImage())
+                for record in catalog if record.getParent() == 0]
+
+    def testLinearized(self):
+        """Test that Footprints transformed by linearizing the Wcs mapping agree with those transformed
+        through the full Wcs, up to the pixels on their boundaries.
+        """
+        transformer = lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region,
+                                                          0.05, False)
+        for refRecord in self.dataset.catalog:
+            exact = refRecord.getFootprint().transform(self.refWcs, self.measWcs, self.region)
+            approx = transformer(refRecord.getFootprint())
+            self.assertClose(approx.getArea(), exact.getArea(), rtol=0.1)
+            self.assertClose(approx.getCentroid().getX(), exact.getCentroid().getX(), atol=0.5)
+            self.assertClose(approx.getCentroid().getY(), exact.getCentroid().getY(), atol=0.5)
+            self.assertEqual(len(approx.getPeaks()), len(refRecord.getFootprint().getPeaks()))
+
+    def testTemporaryWcs(self):
+        """Test that the transformer keeps its Wcss alive when it is given temporaries."""
+        transformer = lsst.meas.base.FootprintTransformer(self.refWcs.clone(), self.measWcs.clone(),
+                                                          self.region, 0.05, False)
+        footprint = self.dataset.catalog[0].getFootprint()
+        self.assertEqual(transformer(footprint).getArea(),
+                         lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region,
+                                                             0.05, False)(footprint).getArea())
+
+    def testKeepHeavy(self):
+        """Test that HeavyFootprints are resampled (preserving their flux) only when requested."""
+        keep = lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region, 0.05, True)
+        degrade = lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region, 0.05, False)
+        exact = lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region, 0.0, True)
+        for heavy in self.makeHeavies():
+            result = lsst.afw.detection.cast_HeavyFootprintF(keep(heavy))
+            self.assertIsNotNone(result)
+            self.assertIsNone(lsst.afw.detection.cast_HeavyFootprintF(degrade(heavy)))
+            self.assertIsNone(lsst.afw.detection.cast_HeavyFootprintF(exact(heavy)))
+            # The resampled pixels cover the same spans as the degraded Footprint.
+            self.assertEqual([(s.getY(), s.getX0(), s.getX1()) for s in result.getSpans()],
+                             [(s.getY(), s.getX0(), s.getX1()) for s in degrade(heavy).getSpans()])
+            self.assertEqual(len(result.getImageArray()), result.getArea())
+            self.assertEqual(len(result.getMaskArray()), result.getArea())
+            self.assertEqual(len(result.getVarianceArray()), result.getArea())
+            # Nearest-neighbour resampling with the pixel-area correction should preserve the total
+            # flux, up to the source pixels that are sampled more or less than once on the boundary.
+            self.assertClose(result.getImageArray().sum(), heavy.getImageArray().sum(), rtol=0.02)
+
+    def testTransformCatalog(self):
+        """Test that transformCatalog matches transforming each record's Footprint individually."""
+        transformer = lsst.meas.base.FootprintTransformer(self.refWcs, self.measWcs, self.region,
+                                                          0.05, True)
+        refCat = self.dataset.catalog
+        measCat = lsst.afw.table.SourceCatalog(refCat.schema)
+        measCat.extend(refCat, deep=True)
+        transformer.transformCatalog(refCat, measCat)
+        for refRecord, measRecord in zip(refCat, measCat):
+            self.assertEqual(measRecord.getFootprint().getArea(),
+                             transformer(refRecord.getFootprint()).getArea())
+        del measCat[len(measCat) - 1]
+        self.assertRaises(lsst.pex.exceptions.LengthError, transformer.transformCatalog, refCat, measCat)
+
+    def testForcedKeepHeavy(self):
+        """Test that forced measurement with doKeepHeavyFootprints measures the exposure's pixels,
+        divided between the children by the reference deblend, rather than the reference pixels."""
+        scale = 2.0
+        exposure, truthCatalog = self.dataset.transform(self.measWcs).realize(1.0,
+            lsst.meas.base.tests.TestDataset.makeMinimalSchema())
+        # Make the exposure differ from the reference image, which has the truth fluxes.
+        exposure.getMaskedImage().getImage().getArray()[:] *= scale
+        exposure.getMaskedImage().getVariance().getArray()[:] *= scale**2
+        config = self.makeForcedMeasurementConfig("test_FootprintFlux")
+        config.footprintTransformMaxError = 0.05
+        config.doKeepHeavyFootprints = True
+        task = self.makeForcedMeasurementTask(config=config)
+        refCat = self.dataset.catalog
+        measCat = task.generateMeasCat(exposure, refCat, self.refWcs)
+        task.attachTransformedFootprints(measCat, refCat, exposure, self.refWcs)
+        children = [i for i, refRecord in enumerate(refCat) if refRecord.getParent() != 0]
+        self.assertEqual(len(children), 2)
+        for i in children:
+            self.assertIsNotNone(lsst.afw.detection.cast_HeavyFootprintF(measCat[i].getFootprint()))
+        task.run(measCat, exposure, refCat, self.refWcs)
+        for measRecord, truthRecord in zip(measCat, truthCatalog):
+            self.assertClose(measRecord.get("test_FootprintFlux_flux"), scale*truthRecord.get("truth_flux"),
+                             rtol=0.05)
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(FootprintTransformerTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
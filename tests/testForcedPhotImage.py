@@ -0,0 +1,179 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import lsst.afw.detection
+import lsst.afw.geom
+import lsst.afw.table
+import lsst.pipe.base
+import lsst.utils.tests
+from lsst.meas.base.forcedPhotImage import ProcessImageForcedTask, ProcessImageForcedTaskRunner
+
+
+class StubDataRef(object):
+
+    def __init__(self, visit, patch=None):
+        self.dataId = dict(visit=visit, patch=patch)
+        self.butlerSubset = lsst.pipe.base.Struct(butler=None)
+
+
+class StubMeasurement(object):
+    """Stub for the measurement subtask used by ProcessImageForcedTask.measureExposure."""
+
+    def __init__(self):
+        self.schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+
+    def generateMeasCat(self, exposure, refCat, refWcs, idFactory=None):
+        measCat = lsst.afw.table.SourceCatalog(lsst.afw.table.SourceTable.make(self.schema, idFactory))
+        for refRecord in refCat:
+            measCat.addNew()
+        return measCat
+
+    def run(self, measCat, exposure, refCat, refWcs, exposureId=None):
+        pass
+
+
+class CachingForcedTask(ProcessImageForcedTask):
+    """A ProcessImageForcedTask that runs the real run() and measureExposure() on stub subtasks and
+    I/O, counting the references fetched and Footprints attached.
+    """
+
+    _DefaultName = "cachingForced"
+    dataPrefix = "stub_"
+
+    def __init__(self, shareFootprints=True, butler=None, **kwds):
+        lsst.pipe.base.Task.__init__(self, **kwds)
+        self.config.doApCorr = False
+        self.shareFootprints = shareFootprints
+        self.references = lsst.pipe.base.Struct(getWcs=lambda dataRef: None)
+        self.measurement = StubMeasurement()
+        self.afterburners = lsst.pipe.base.Struct(run=lambda measCat: None)
+        self._referenceCache = {}
+        self.nFetched = 0
+        self.nAttached = 0
+        self.written = []
+
+    def getExposure(self, dataRef):
+        return None
+
+    def getReferenceKey(self, dataRef):
+        return dataRef.dataId["patch"]
+
+    def getFootprintKey(self, dataRef):
+        return dataRef.dataId["patch"] if self.shareFootprints else None
+
+    def makeIdFactory(self, dataRef):
+        return lsst.afw.table.IdFactory.makeSimple()
+
+    def getExposureId(self, dataRef):
+        return dataRef.dataId["visit"]
+
+    def fetchReferences(self, dataRef, exposure):
+        self.nFetched += 1
+        refCat = lsst.afw.table.SourceCatalog(self.measurement.schema)
+        for i in range(3):
+            refCat.addNew()
+        return refCat
+
+    def attachFootprints(self, sources, refCat, exposure, refWcs, dataRef):
+        self.nAttached += 1
+        for record in sources:
+            footprint = lsst.afw.detection.Footprint(lsst.afw.geom.Point2I(self.nAttached, 0), 2.0)
+            record.setFootprint(footprint)
+
+    def writeOutput(self, dataRef, sources):
+        self.written.append((dataRef.dataId["visit"], sources))
+
+
+class ForcedPhotImageTestCase(lsst.utils.tests.TestCase):
+    """Test the sharing of references and Footprints between the exposures ProcessImageForcedTask
+    measures, and the task runner that reuses the task."""
+
+    def makeParsedCmd(self, processes=1):
+        return lsst.pipe.base.Struct(config=CachingForcedTask.ConfigClass(), log=None, doraise=True,
+                                     clobberConfig=False, processes=processes, butler=None)
+
+    def testCache(self):
+        """Test that consecutive exposures with the same keys share references and Footprints."""
+        dataRefList = [StubDataRef(visit, patch) for visit, patch in enumerate("aabbba")]
+        task = CachingForcedTask()
+        for dataRef in dataRefList:
+            task.run(dataRef)
+        self.assertEqual(task.nFetched, 3)
+        self.assertEqual(task.nAttached, 3)
+        self.assertEqual([visit for visit, measCat in task.written], list(range(6)))
+        for (visit, measCat), dataRef in zip(task.written, dataRefList):
+            self.assertEqual(len(measCat), 3)
+        for i, j in ((0, 1), (2, 3), (2, 4)):
+            for a, b in zip(task.written[i][1], task.written[j][1]):
+                self.assertEqual(a.getFootprint().getBBox(), b.getFootprint().getBBox())
+        for a, b in zip(task.written[4][1], task.written[5][1]):
+            self.assertNotEqual(a.getFootprint().getBBox(), b.getFootprint().getBBox())
+        task = CachingForcedTask(shareFootprints=False)
+        for dataRef in dataRefList:
+            task.run(dataRef)
+        self.assertEqual(task.nFetched, 3)
+        self.assertEqual(task.nAttached, 6)
+
+    def testRunnerReusesTask(self):
+        """Test that a single-process runner hands out the same task, with fresh metadata each time."""
+        parsedCmd = self.makeParsedCmd()
+        runner = ProcessImageForcedTaskRunner(CachingForcedTask, parsedCmd)
+        task = runner.makeTask(parsedCmd=parsedCmd)
+        metadataList = []
+        for visit in range(3):
+            dataRef = StubDataRef(visit, "a")
+            self.assertIs(runner.makeTask(args=(dataRef, {})), task)
+            self.assertFalse(task.metadata.exists("visit"))
+            task.metadata.set("visit", visit)
+            task.run(dataRef)
+            metadataList.append(task.metadata)
+        self.assertEqual([metadata.get("visit") for metadata in metadataList], [0, 1, 2])
+        self.assertEqual(task.nFetched, 1)
+
+    def testRunnerMultiprocess(self):
+        """Test that a multiprocessing runner makes a new task each time."""
+        parsedCmd = self.makeParsedCmd(processes=2)
+        runner = ProcessImageForcedTaskRunner(CachingForcedTask, parsedCmd)
+        runner.numProcesses = 2  # in case the stub task can't multiprocess
+        dataRef = StubDataRef(0, "a")
+        self.assertIsNot(runner.makeTask(args=(dataRef, {})), runner.makeTask(args=(dataRef, {})))
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(ForcedPhotImageTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -23,8 +23,10 @@
 
 import unittest
 
+import lsst.afw.image
 import lsst.utils.tests
 import lsst.meas.base.tests
+import testLib
 from lsst.meas.base.tests import (AlgorithmTestCase, CentroidTransformTestCase,
                                   SingleFramePluginTransformSetupHelper)
 
@@ -53,6 +55,36 @@ class GaussianCentroidTestCase(AlgorithmTestCase):
         self.assertClose(x, self.center.getX(), atol=None, rtol=.01)
         self.assertClose(y, self.center.getY(), atol=None, rtol=.01)
 
+    def testMatchesReference(self):
+        """Test that the fitter gives the same centroids and flags as the implementation it replaced.
+
+        The reference fitter in testLib is a verbatim copy of the one GaussianCentroid used before its
+        fitting storage was rewritten.
+        """
+        # faint, blended and edge sources exercise the fitter's failure modes as well as its successes
+        for flux, x, y in [(50000.0, 20.4, 30.6), (2000.0, 60.7, 52.2), (30.0, 90.2, 10.9),
+                           (80000.0, 25.3, 33.9), (40000.0, -18.6, 70.5), (5000.0, 117.2, 127.4)]:
+            self.dataset.addSource(flux, lsst.afw.geom.Point2D(x, y))
+        config = self.makeSingleFrameMeasurementConfig("base_GaussianCentroid")
+        config.doReplaceWithNoise = False   # so every source is measured on the pixels we fit below
+        config.plugins["base_GaussianCentroid"].doFootprintCheck = False   # don't reset to the peak
+        task = self.makeSingleFrameMeasurementTask(config=config)
+        exposure, catalog = self.dataset.realize(10.0, task.schema)
+        task.run(catalog, exposure)
+        image = exposure.getMaskedImage().getImage()
+        for record in catalog:
+            # the same initial guess, in pixel indices, that GaussianCentroidAlgorithm::measure starts from
+            x = int(record.getX() + 0.5) - image.getX0()
+            y = int(record.getY() + 0.5) - image.getY0()
+            expected = testLib.fitReferenceGaussian(image, x, y)
+            self.assertEqual(record.get("base_GaussianCentroid_flag_noPeak"), expected.peak <= 0)
+            if expected.peak <= 0:
+                continue
+            self.assertClose(record.get("base_GaussianCentroid_x"),
+                             lsst.afw.image.indexToPosition(image.getX0()) + expected.x, rtol=0, atol=1E-8)
+            self.assertClose(record.get("base_GaussianCentroid_y"),
+                             lsst.afw.image.indexToPosition(image.getY0()) + expected.y, rtol=0, atol=1E-8)
+
 
 class GaussianCentroidTransformTestCase(CentroidTransformTestCase, SingleFramePluginTransformSetupHelper):
     controlClass = lsst.meas.base.GaussianCentroidControl
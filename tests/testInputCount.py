@@ -149,6 +149,21 @@ class InputCountTest(unittest.TestCase):
             record.setBBox(imageBox)
             record.setValidPolygon(Polygon(afwGeom.Box2D(imageBox)))
 
+        # Count inputs both by testing every input and with a coverage map whose cells are small
+        # enough that the sources fall in both uniform and boundary cells.
+        for useCoverageMap in (False, True):
+            catalog = self._measureInputCounts(exp, sources, value, useCoverageMap=useCoverageMap,
+                                               coverageCellSize=4, doFootprintMin=useCoverageMap)
+            for src, rec in zip(sources, catalog):
+                self.assertEqual(rec.get("base_InputCount_value"), src.count)
+                if useCoverageMap:
+                    self.assertLessEqual(rec.get("base_InputCount_footprintMin"), src.count)
+
+        if display:
+            ccdVennDiagram(exp)
+
+    def _measureInputCounts(self, exp, sources, value, **pluginConfig):
+        """Run InputCount, with the given plugin config overrides, on a catalog of the given sources."""
         # Configure a SingleFrameMeasurementTask to run InputCounts.
         measureSourcesConfig = measBase.SingleFrameMeasurementConfig()
         measureSourcesConfig.plugins.names = ["base_PeakCentroid", "base_InputCount"]
@@ -159,6 +174,8 @@ class InputCountTest(unittest.TestCase):
         measureSourcesConfig.slots.instFlux = None
         measureSourcesConfig.slots.calibFlux = None
         measureSourcesConfig.slots.shape = None
+        for k, v in pluginConfig.items():
+            setattr(measureSourcesConfig.plugins["base_InputCount"], k, v)
         measureSourcesConfig.validate()
         schema = afwTable.SourceTable.makeMinimalSchema()
         task = measBase.SingleFrameMeasurementTask(schema, config=measureSourcesConfig)
@@ -174,12 +191,7 @@ class InputCountTest(unittest.TestCase):
             catalog.addNew().setFootprint(foot)
 
         task.run(catalog, exp)
-
-        for src, rec in zip(sources, catalog):
-            self.assertEqual(rec.get("base_InputCount_value"), src.count)
-
-        if display:
-            ccdVennDiagram(exp)
+        return catalog
 
     def _preparePlugin(self, numCoaddInputs):
         """
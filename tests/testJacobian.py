@@ -48,6 +48,7 @@ class JacobianTestCase(AlgorithmTestCase):
 
         for k, v in (
                 ("EQUINOX", 2000.0),
+                ("RADESYS", 'ICRS'),   # AffineWcsGrid only approximates ICRS Wcs
                 ("CRPIX1" , 5353.0),
                 ("CRPIX2" , -35.0),
                 ("CD1_1"  , 0.0),
@@ -84,6 +85,29 @@ class JacobianTestCase(AlgorithmTestCase):
         self.assertFalse(record.get("base_Jacobian_flag"))
         self.assertAlmostEqual(record.get("base_Jacobian_value"), 1.0200183929088285, 4)
 
+    def testJacobianPluginWcsGrid(self):
+        config = SingleFrameMeasurementConfig()
+        config.plugins.names |= ['base_Jacobian', 'base_SkyCoord']
+        config.plugins['base_Jacobian'].pixelScale = 0.2
+        # Share a grid of linearized Wcs cells between the two plugins
+        for name in ('base_Jacobian', 'base_SkyCoord'):
+            config.plugins[name].wcsGridCellSize = 32.0
+            config.plugins[name].wcsGridTolerance = 1E-3
+        task = self.makeSingleFrameMeasurementTask(config=config)
+        exposure, catalog = self.dataset.realize(10.0, task.schema)
+        exposure.setWcs(self.wcs)
+        task.run(exposure, catalog)
+        # the grid the plugins used, since these arguments match theirs
+        grid = lsst.meas.base.AffineWcsGrid.getCached(exposure.getWcs(),
+                                                      lsst.afw.geom.Box2D(exposure.getBBox()),
+                                                      32.0, 1E-3*lsst.afw.geom.arcseconds)
+        self.assertGreater(grid.getValidCellCount(), 0)
+        record = catalog[0]
+        self.assertFalse(record.get("base_Jacobian_flag"))
+        self.assertAlmostEqual(record.get("base_Jacobian_value"), 1.0200183929088285, 4)
+        expected = self.wcs.pixelToSky(record.getCentroid())
+        self.assertLess(record.getCoord().angularSeparation(expected).asArcseconds(), 1E-3)
+
 def suite():
     lsst.utils.tests.init()
 
@@ -25,6 +25,7 @@
 
 %{
 #include "SillyCentroid.h"
+#include "GaussianCentroidReference.h"
 #include "lsst/afw/math.h"
 #include "lsst/afw/detection.h"
 #include "lsst/pex/logging.h"
@@ -40,3 +41,7 @@
 %convertConfig(test::foo::bar, SillyTransform)
 %feature("notabstract") test::foo::bar::SillyCentroidAlgorithm;
 %include "SillyCentroid.h"
+
+%include "GaussianCentroidReference.h"
+%template(fitReferenceGaussian) test::foo::bar::fitReferenceGaussian<float>;
+%template(fitReferenceGaussian) test::foo::bar::fitReferenceGaussian<double>;
@@ -26,7 +26,9 @@ import unittest
 import numpy
 
 import lsst.utils.tests
+import lsst.daf.base
 import lsst.afw.detection
+import lsst.afw.image
 import lsst.afw.table
 import lsst.meas.base.tests
 
@@ -86,6 +88,120 @@ class NoiseReplacerTestCase(lsst.meas.base.tests.AlgorithmTestCase):
             # some RNG seeds may cause it to fail (indeed, 67% should)
             self.assertLess(record.get("test_NoiseReplacer_outside"), numpy.sqrt(sumVariance))
 
+    def runTiled(self, tileSize, tileHalo, tileMaxFamilySize=None):
+        """Run SingleFrameMeasurementTask.runTiled on the dataset, returning the catalog, the exposure, the
+        boxes read, and the number of times each source was measured."""
+        task = self.makeSingleFrameMeasurementTask("test_NoiseReplacer")
+        task.config.tileSize = tileSize
+        task.config.tileHalo = tileHalo
+        task.config.tileMaxFamilySize = tileMaxFamilySize
+        exposure, catalog = self.dataset.realize(1.0, task.schema)
+        catalog.getTable().setMetadata(lsst.daf.base.PropertyList())
+        reads = []
+        counts = dict((record.getId(), 0) for record in catalog)
+
+        def readExposure(box):
+            reads.append(box)
+            return exposure.Factory(exposure, box, lsst.afw.image.PARENT, True)
+
+        def callMeasure(measRecord, *args, **kwds):
+            counts[measRecord.getId()] += 1
+            return lsst.meas.base.SingleFrameMeasurementTask.callMeasure(task, measRecord, *args, **kwds)
+
+        task.callMeasure = callMeasure
+        task.runTiled(catalog, readExposure, exposure.getBBox())
+        self.assertTrue(all(exposure.getBBox().contains(box) for box in reads))
+        return catalog, exposure, reads, counts
+
+    def isTile(self, box, tileSize, tileHalo):
+        """Return whether box is the region runTiled() reads for a tile of self.bbox"""
+        region = lsst.afw.geom.Box2I(
+            self.bbox.getMin() + lsst.afw.geom.Extent2I(
+                (box.getMinX() + tileHalo - self.bbox.getMinX())//tileSize*tileSize,
+                (box.getMinY() + tileHalo - self.bbox.getMinY())//tileSize*tileSize
+            ),
+            lsst.afw.geom.Extent2I(tileSize, tileSize)
+        )
+        region.grow(tileHalo)
+        region.clip(self.bbox)
+        return region == box
+
+    def testRunTiled(self):
+        """Test that measuring an exposure one tile at a time replaces neighbors with noise within each
+        tile, and measures each family (including ones that straddle tiles) exactly once."""
+        for tileSize, tileHalo in [(100, 20), (50, 0)]:
+            catalog, exposure, reads, counts = self.runTiled(tileSize, tileHalo)
+            self.assertEqual(set(counts.values()), set([1]))
+            # the noise parameters are recorded once, not once per tile
+            for name in ("NOISE_SEED_MULTIPLIER", "NOISE_SOURCE", "NOISE_OFFSET"):
+                self.assertEqual(catalog.getMetadata().valueCount(name), 1)
+            if tileHalo == 0:
+                # the blend straddles the tile boundary at x=80, so it's read on its own
+                self.assertTrue(any(not self.isTile(box, tileSize, tileHalo) for box in reads))
+            sumVariance = exposure.getMaskedImage().getVariance().getArray().sum()
+            for record in catalog:
+                self.assertClose(record.get("test_NoiseReplacer_inside"), record.get("truth_flux"),
+                                 rtol=1E-3)
+                self.assertLess(record.get("test_NoiseReplacer_outside"), numpy.sqrt(sumVariance))
+
+    def testRunTiledMaxFamilySize(self):
+        """Test that runTiled() bounds the sub-exposures read for families that straddle tiles, still
+        measures each source exactly once, and restores the Footprints it clips."""
+        tileSize, tileMaxFamilySize = 50, 20
+        areas = dict((record.getId(), record.getFootprint().getArea())
+                     for record in self.dataset.catalog)
+        catalog, exposure, reads, counts = self.runTiled(tileSize, 0, tileMaxFamilySize)
+        self.assertEqual(set(counts.values()), set([1]))
+        straddlerReads = [box for box in reads if not self.isTile(box, tileSize, 0)]
+        self.assertGreater(len(straddlerReads), 0)
+        for box in straddlerReads:
+            self.assertLessEqual(box.getWidth(), tileMaxFamilySize)
+            self.assertLessEqual(box.getHeight(), tileMaxFamilySize)
+        for record in catalog:
+            self.assertEqual(record.getFootprint().getArea(), areas[record.getId()])
+
+    def testUsedIds(self):
+        """Test that each source is inserted and removed using its own HeavyFootprint, or else that of
+        the first parent in its chain that has one, and that the lookup is cached."""
+        exposure, catalog = self.dataset.realize(1.0, self.dataset.makeMinimalSchema())
+        parent = catalog[2]
+        heavyChild, plainChild = catalog[3], catalog[4]
+        self.assertEqual((heavyChild.getParent(), plainChild.getParent()), (parent.getId(),) * 2)
+        footprints = {}
+        for record in catalog:
+            footprints[record.getId()] = (record.getParent(),
+                                          lsst.afw.detection.Footprint(record.getFootprint()))
+        footprints[heavyChild.getId()] = (
+            parent.getId(),
+            lsst.afw.detection.makeHeavyFootprint(heavyChild.getFootprint(), exposure.getMaskedImage())
+        )
+        # grandchildren, with no HeavyFootprints of their own
+        heavyGrandchildId = max(footprints) + 1
+        plainGrandchildId = heavyGrandchildId + 1
+        footprints[heavyGrandchildId] = (heavyChild.getId(), footprints[heavyChild.getId()][1])
+        footprints[plainGrandchildId] = (plainChild.getId(), footprints[plainChild.getId()][1])
+        expected = {parent.getId(): parent.getId(),
+                    heavyChild.getId(): heavyChild.getId(),
+                    plainChild.getId(): parent.getId(),
+                    heavyGrandchildId: heavyChild.getId(),
+                    plainGrandchildId: parent.getId()}
+
+        replacer = lsst.meas.base.NoiseReplacer(lsst.meas.base.NoiseReplacerConfig(), exposure, footprints)
+        noisyArray = exposure.getMaskedImage().getImage().getArray().copy()
+        for id, usedId in expected.items():
+            self.assertEqual(replacer.getUsedId(id), usedId)
+            self.assertEqual(replacer.usedIds[id], usedId)
+            replacer.insertSource(id)
+            self.assertTrue((exposure.getMaskedImage().getImage().getArray() != noisyArray).any())
+            replacer.removeSource(id)
+            self.assertTrue((exposure.getMaskedImage().getImage().getArray() == noisyArray).all())
+        # Cached lookups no longer need to walk the parent chain.
+        replacer.footprints, footprints = {}, replacer.footprints
+        for id, usedId in expected.items():
+            self.assertEqual(replacer.getUsedId(id), usedId)
+        replacer.footprints = footprints
+        replacer.end()
+
     def tearDown(self):
         del self.bbox
         del self.dataset
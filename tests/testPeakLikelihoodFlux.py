@@ -23,10 +23,113 @@
 
 import unittest
 
+import lsst.afw.geom
+import lsst.afw.image
+import lsst.afw.math
 import lsst.meas.base
+import lsst.meas.base.tests
 import lsst.utils.tests
 
-from lsst.meas.base.tests import FluxTransformTestCase, SingleFramePluginTransformSetupHelper
+from lsst.meas.base.tests import (AlgorithmTestCase, FluxTransformTestCase,
+                                  SingleFramePluginTransformSetupHelper)
+
+class PeakLikelihoodFluxTestCase(AlgorithmTestCase):
+
+    def setUp(self):
+        self.bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0),
+                                        lsst.afw.geom.Extent2I(100, 100))
+        self.dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        self.dataset.addSource(100000.0, lsst.afw.geom.Point2D(50.1, 49.8))
+        self.dataset.addSource(60000.0, lsst.afw.geom.Point2D(20.7, 75.3))
+        self.dataset.addSource(80000.0, lsst.afw.geom.Point2D(81.4, 12.6))
+        # close enough to the edge that the warping kernel doesn't fit, so the flag is set
+        self.dataset.addSource(50000.0, lsst.afw.geom.Point2D(2.2, 40.5))
+
+    def tearDown(self):
+        del self.bbox
+        del self.dataset
+
+    def testEffectiveAreaCache(self):
+        """Test that caching the PSF effective area per tile doesn't change any result for a spatially
+        constant PSF.
+        """
+        results = []
+        exposure, catalog = None, None
+        for tileSize in (0, 16, 64):
+            config = self.makeSingleFrameMeasurementConfig("base_PeakLikelihoodFlux")
+            config.doReplaceWithNoise = False
+            config.plugins["base_PeakLikelihoodFlux"].psfAreaCacheTileSize = tileSize
+            task = self.makeSingleFrameMeasurementTask(config=config)
+            if exposure is None:
+                exposure, catalog = self.dataset.realize(10.0, task.schema)
+            measCat = catalog.copy(deep=True)
+            task.run(exposure, measCat)
+            results.append([(record.get("base_PeakLikelihoodFlux_flux"),
+                             record.get("base_PeakLikelihoodFlux_fluxSigma"),
+                             record.get("base_PeakLikelihoodFlux_flag"))
+                            for record in measCat])
+        self.assertTrue(results[0][-1][2])
+        for result in results[1:]:
+            self.assertEqual(len(result), len(results[0]))
+            for (flux, fluxSigma, flag), (flux0, fluxSigma0, flag0) in zip(result, results[0]):
+                self.assertEqual(flag, flag0)
+                if not flag0:
+                    self.assertEqual(flux, flux0)
+                    self.assertEqual(fluxSigma, fluxSigma0)
+
+    def computeReferenceFlux(self, exposure, center):
+        """Compute the flux the way the algorithm originally did: by evaluating the warping kernel at the
+        source's fractional offset and convolving at one point.
+
+        Only non-negative offsets are supported, which avoids having to shift the kernel center.
+        """
+        xInd, xFrac = lsst.afw.image.positionToIndex(center.getX(), True)
+        yInd, yFrac = lsst.afw.image.positionToIndex(center.getY(), True)
+        self.assertGreaterEqual(xFrac, 0.0)
+        self.assertGreaterEqual(yFrac, 0.0)
+        kernel = lsst.afw.math.makeWarpingKernel("lanczos4")
+        kernel.setKernelParameters([xFrac, yFrac])
+        kernelImage = lsst.afw.image.ImageD(kernel.getDimensions())
+        kernel.computeImage(kernelImage, True)
+        ctrPix = lsst.afw.geom.Point2I(xInd, yInd)
+        bbox = lsst.afw.geom.Box2I(ctrPix - lsst.afw.geom.Extent2I(kernel.getCtr()), kernel.getDimensions())
+        image = exposure.getMaskedImage().getImage()
+        subImage = image.Factory(image, bbox, lsst.afw.image.PARENT)
+        value = (kernelImage.getArray()*subImage.getArray()).sum()
+        psfImage = exposure.getPsf().computeImage(lsst.afw.geom.Point2D(ctrPix)).getArray()
+        return value*psfImage.sum()**2/(psfImage**2).sum()
+
+    def testWarpingTaps(self):
+        """Test the warping taps, computed exactly and tabulated, against the warping kernel evaluated
+        directly.
+
+        Exact taps, and tabulated ones for offsets that fall on the table's steps, should agree to
+        rounding error; others are interpolated between steps 1/512 pixel apart, which the algorithm
+        documents as changing fluxes by up to about 1e-6.
+        """
+        dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        onSteps = [(50.25, 50.125), (30.375, 70.0625)]
+        offSteps = [(70.3, 25.2), (20.41, 30.07)]
+        for x, y in onSteps + offSteps:
+            dataset.addSource(100000.0, lsst.afw.geom.Point2D(x, y))
+        exposure, catalog = None, None
+        for shiftSteps in (0, 256):
+            config = self.makeSingleFrameMeasurementConfig("base_PeakLikelihoodFlux")
+            config.doReplaceWithNoise = False
+            config.plugins["base_PeakLikelihoodFlux"].warpingShiftSteps = shiftSteps
+            task = self.makeSingleFrameMeasurementTask(config=config)
+            if exposure is None:
+                exposure, catalog = dataset.realize(10.0, task.schema)
+            measCat = catalog.copy(deep=True)
+            task.run(exposure, measCat)
+            for record in measCat:
+                center = record.getCentroid()
+                self.assertFalse(record.get("base_PeakLikelihoodFlux_flag"))
+                onStep = shiftSteps == 0 or (center.getX(), center.getY()) in onSteps
+                self.assertClose(record.get("base_PeakLikelihoodFlux_flux"),
+                                 self.computeReferenceFlux(exposure, center),
+                                 rtol=(1E-10 if onStep else 1E-6))
+
 
 class PeakLikelihoodFluxTransformTestCase(FluxTransformTestCase, SingleFramePluginTransformSetupHelper):
     controlClass = lsst.meas.base.PeakLikelihoodFluxControl
@@ -42,6 +145,7 @@ def suite():
     lsst.utils.tests.init()
 
     suites = []
+    suites += unittest.makeSuite(PeakLikelihoodFluxTestCase)
     suites += unittest.makeSuite(PeakLikelihoodFluxTransformTestCase)
     suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
     return unittest.TestSuite(suites)
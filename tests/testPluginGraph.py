@@ -0,0 +1,127 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+"""
+Tests for the dependency graph used to order and select measurement plugins
+"""
+import unittest
+
+import lsst.afw.table
+import lsst.utils.tests as utilsTests
+
+from lsst.meas.base.pluginsBase import BasePlugin
+from lsst.meas.base.pluginRegistry import PluginGraph
+from lsst.meas.base.baseMeasurement import SourceSlotConfig
+from lsst.meas.base.sfm import SingleFrameMeasurementTask
+
+
+def makePlugin(name, executionOrder, dependencies=()):
+    """Return a (executionOrder, name, config, PluginClass) entry for a plugin with the given dependencies;
+    dependencies=() uses the default derived from the execution order."""
+    typeDict = dict(getExecutionOrder=classmethod(lambda cls: executionOrder))
+    if dependencies != ():
+        typeDict["getDependencies"] = classmethod(lambda cls: dependencies)
+    return (executionOrder, name, None, type(name, (BasePlugin,), typeDict))
+
+
+class PluginGraphTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.slots = SourceSlotConfig()
+        self.slots.centroid = "zCentroid"
+        self.slots.shape = "shape"
+        self.slots.psfFlux = "psfFlux"
+        self.slots.apFlux = "apFlux_3_0"
+        self.slots.modelFlux = None
+        self.slots.instFlux = None
+        self.slots.calibFlux = None
+        self.entries = [
+            makePlugin("aCentroid", BasePlugin.CENTROID_ORDER),
+            makePlugin("zCentroid", BasePlugin.CENTROID_ORDER),
+            makePlugin("shape", BasePlugin.SHAPE_ORDER),
+            makePlugin("psfFlux", BasePlugin.FLUX_ORDER, ("slot_Centroid",)),
+            makePlugin("apFlux", BasePlugin.FLUX_ORDER, ("slot_Centroid",)),
+            makePlugin("gaussFlux", BasePlugin.FLUX_ORDER),
+            makePlugin("ratio", BasePlugin.FLUX_ORDER, ("slot_PsfFlux", "gaussFlux")),
+            makePlugin("apCorr", BasePlugin.APCORR_ORDER),
+        ]
+
+    def testSort(self):
+        """Dependencies come first, and the execution order breaks ties; by default, centroid plugins
+        depend on the slot centroid, so it runs first."""
+        graph = PluginGraph(self.entries, self.slots)
+        names = [entry[1] for entry in graph.sort()]
+        self.assertEqual(names, ["zCentroid", "aCentroid", "shape", "apFlux", "gaussFlux", "psfFlux",
+                                 "ratio", "apCorr"])
+        self.assertEqual(graph.dependencies["apFlux"], set(["zCentroid"]))
+        self.assertEqual(graph.dependencies["zCentroid"], set())
+        self.assertEqual(graph.dependencies["apCorr"], set(entry[1] for entry in self.entries[:-1]))
+
+    def testDefaultConfigOrder(self):
+        """The default single-frame measurement plugins run in the order they did before PluginGraph:
+        the slot centroid first, then the rest sorted by (executionOrder, name)."""
+        schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        task = SingleFrameMeasurementTask(schema=schema)
+        config = task.config
+        entries = sorted(config.plugins.apply(), key=lambda entry: entry[:2])
+        expected = [config.slots.centroid] + [entry[1] for entry in entries
+                                              if entry[1] != config.slots.centroid]
+        self.assertEqual(list(task.plugins.keys()), expected)
+        graph = PluginGraph(config.plugins.apply(), config.slots)
+        self.assertEqual([entry[1] for entry in graph.sort()], expected)
+
+    def testRequired(self):
+        """Requesting some plugins keeps only them, their dependencies, and the slot plugins."""
+        graph = PluginGraph(self.entries, self.slots)
+        required = graph.getRequired(["ratio"])
+        self.assertEqual(required, set(["zCentroid", "shape", "psfFlux", "apFlux", "gaussFlux", "ratio"]))
+        names = [entry[1] for entry in graph.sort(required)]
+        self.assertEqual(names, ["zCentroid", "shape", "apFlux", "gaussFlux", "psfFlux", "ratio"])
+        self.assertRaises(ValueError, graph.getRequired, ["notAPlugin"])
+
+    def testErrors(self):
+        """Unknown plugins and cycles are reported."""
+        entries = self.entries + [makePlugin("bad", BasePlugin.FLUX_ORDER, ("notAPlugin",))]
+        self.assertRaises(ValueError, PluginGraph, entries, self.slots)
+        entries = self.entries + [makePlugin("first", BasePlugin.FLUX_ORDER, ("second",)),
+                                  makePlugin("second", BasePlugin.FLUX_ORDER, ("first",))]
+        graph = PluginGraph(entries, self.slots)
+        self.assertRaises(ValueError, graph.sort)
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+    utilsTests.init()
+
+    suites = []
+    suites += unittest.makeSuite(PluginGraphTestCase)
+    suites += unittest.makeSuite(utilsTests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+
+def run(shouldExit=False):
+    """Run the tests"""
+    utilsTests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -134,6 +134,87 @@ class PsfFluxTestCase(AlgorithmTestCase):
             self.assertClose(fluxSigmaMean, fluxStandardDeviation, rtol=0.10)   # rng dependent
             self.assertLess(fluxMean - flux, 2.0*fluxSigmaMean / nSamples**0.5)   # rng dependent
 
+    def testMeasureN(self):
+        """Test that a joint fit to a blend recovers the fluxes of all the children, and that it agrees
+        with measure() for an isolated source.
+        """
+        algorithm, schema = self.makeAlgorithm()
+        exposure, catalog = self.dataset.realize(10.0, schema)
+        record = catalog[0]
+        algorithm.measure(record, exposure)
+        flux, fluxSigma = record.get("base_PsfFlux_flux"), record.get("base_PsfFlux_fluxSigma")
+        algorithm.measureN(catalog, exposure)
+        self.assertClose(record.get("base_PsfFlux_flux"), flux, rtol=1E-6)
+        self.assertClose(record.get("base_PsfFlux_fluxSigma"), fluxSigma, rtol=1E-6)
+
+        dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        with dataset.addBlend() as family:
+            family.addChild(100000.0, lsst.afw.geom.Point2D(45.3, 50.2))
+            family.addChild(50000.0, lsst.afw.geom.Point2D(50.6, 49.4))
+        exposure, catalog = dataset.realize(0.0, schema)
+        children = catalog[1:]
+        for record in children:
+            algorithm.measure(record, exposure)
+            # on the full image, each child absorbs some of its neighbour's flux
+            self.assertGreater(record.get("base_PsfFlux_flux"), record.get("truth_flux")*1.01)
+        algorithm.measureN(children, exposure)
+        for record in children:
+            self.assertFalse(record.get("base_PsfFlux_flag"))
+            self.assertClose(record.get("base_PsfFlux_flux"), record.get("truth_flux"), rtol=1E-3)
+
+    def testMeasureNFailsSingleChild(self):
+        """Test that measureN() replaces the flags measure() set, and that a child it can't measure is
+        failed on its own without affecting the rest of the family.
+        """
+        algorithm, schema = self.makeAlgorithm()
+        dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        with dataset.addBlend() as family:
+            family.addChild(100000.0, lsst.afw.geom.Point2D(45.3, 50.2))
+            family.addChild(50000.0, lsst.afw.geom.Point2D(50.6, 49.4))
+            family.addChild(70000.0, lsst.afw.geom.Point2D(55.1, 52.8))
+        exposure, catalog = dataset.realize(0.0, schema)
+        children = catalog[1:]
+        for record in children:
+            record.set("base_PsfFlux_flag", True)
+            record.set("base_PsfFlux_flag_edge", True)
+        bad = children[2]
+        bad.set("truth_x", float("nan"))
+        bad.set("truth_flag", True)
+        bad.setFootprint(None)
+        algorithm.measureN(children, exposure)
+        self.assertTrue(bad.get("base_PsfFlux_flag"))
+        self.assertFalse(bad.get("base_PsfFlux_flag_edge"))
+        self.assertTrue(numpy.isnan(bad.get("base_PsfFlux_flux")))
+        for record in children[:2]:
+            self.assertFalse(record.get("base_PsfFlux_flag"))
+            self.assertFalse(record.get("base_PsfFlux_flag_edge"))
+            self.assertTrue(numpy.isfinite(record.get("base_PsfFlux_flux")))
+
+    def testMeasureNCoincident(self):
+        """Test that measureN() fails every child of a family whose joint fit is degenerate, rather than
+        giving all the flux to one of them."""
+        algorithm, schema = self.makeAlgorithm()
+        dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        with dataset.addBlend() as family:
+            family.addChild(100000.0, lsst.afw.geom.Point2D(50.6, 49.4))
+            family.addChild(50000.0, lsst.afw.geom.Point2D(50.6, 49.4))
+        exposure, catalog = dataset.realize(10.0, schema)
+        children = catalog[1:]
+        algorithm.measureN(children, exposure)
+        for record in children:
+            self.assertTrue(record.get("base_PsfFlux_flag"))
+            self.assertTrue(numpy.isnan(record.get("base_PsfFlux_flux")))
+
+    def testMeasureNConfig(self):
+        """Test that the joint fit is only enabled on request."""
+        config = self.makeSingleFrameMeasurementConfig("base_PsfFlux")
+        self.assertFalse(config.plugins["base_PsfFlux"].doMeasureN)
+        config.plugins["base_PsfFlux"].doMeasureN = True
+        task = self.makeSingleFrameMeasurementTask(config=config)
+        exposure, catalog = self.dataset.realize(10.0, task.schema)
+        task.run(exposure, catalog)
+        self.assertFalse(catalog[0].get("base_PsfFlux_flag"))
+
     def testSingleFramePlugin(self):
         task = self.makeSingleFrameMeasurementTask("base_PsfFlux")
         exposure, catalog = self.dataset.realize(10.0, task.schema)
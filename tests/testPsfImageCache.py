@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import numpy
+
+import lsst.afw.geom
+import lsst.afw.detection
+import lsst.utils.tests
+import lsst.meas.base
+
+
+class PsfImageCacheTestCase(lsst.utils.tests.TestCase):
+
+    def setUp(self):
+        self.psf = lsst.afw.detection.GaussianPsf(25, 25, 2.0)
+        self.cache = lsst.meas.base.PsfImageCache()
+
+    def tearDown(self):
+        del self.cache
+        del self.psf
+
+    def testUncached(self):
+        """Test that a non-positive tile size computes the image exactly and leaves the cache alone."""
+        position = lsst.afw.geom.Point2D(30.3, 40.8)
+        image = self.cache.computeImage(self.psf, position, 0, 10)
+        expected = self.psf.computeImage(position)
+        self.assertEqual(image.getBBox(), expected.getBBox())
+        self.assertClose(image.getArray(), expected.getArray())
+        self.assertEqual(self.cache.getSize(), 0)
+        self.assertEqual(self.cache.getMissCount(), 0)
+
+    def testQuantizedPhase(self):
+        """Test that positions with the same quantised phase share an image, shifted into place."""
+        for position in [lsst.afw.geom.Point2D(30.3, 40.8), lsst.afw.geom.Point2D(33.3, 38.8),
+                         lsst.afw.geom.Point2D(-7.5, 12.25)]:
+            image = self.cache.computeImage(self.psf, position, 64, 20)
+            expected = self.psf.computeImage(position)
+            self.assertEqual(image.getBBox(), expected.getBBox())
+            self.assertClose(image.getArray(), expected.getArray(), atol=1E-6)
+        self.assertEqual(self.cache.getMissCount(), 2)
+        self.assertEqual(self.cache.getHitCount(), 1)
+        self.assertEqual(self.cache.getSize(), 2)
+
+    def testHalfPixelBBox(self):
+        """Test that positions near a half-pixel boundary get images with the same bbox as computeImage."""
+        for phaseSteps in (1, 2, 5, 10):
+            for x, y in [(30.49, 40.0), (30.5, 40.5), (30.51, 40.499), (-7.499, -12.5), (-7.5, 12.46)]:
+                position = lsst.afw.geom.Point2D(x, y)
+                image = self.cache.computeImage(self.psf, position, 64, phaseSteps)
+                expected = self.psf.computeImage(position)
+                self.assertEqual(image.getBBox(), expected.getBBox())
+
+    def testEviction(self):
+        """Test that the least recently used images are evicted when the pixel limit is reached."""
+        nPixels = self.psf.computeImage().getBBox().getArea()
+        self.cache.setMaxPixels(2*nPixels)
+        a = lsst.afw.geom.Point2D(10.0, 10.0)
+        b = lsst.afw.geom.Point2D(100.0, 10.0)
+        c = lsst.afw.geom.Point2D(200.0, 10.0)
+        self.cache.computeImage(self.psf, a, 64, 10)
+        self.cache.computeImage(self.psf, b, 64, 10)
+        self.cache.computeImage(self.psf, a, 64, 10)
+        self.cache.computeImage(self.psf, c, 64, 10)   # should evict b, not a
+        self.assertEqual(self.cache.getEvictionCount(), 1)
+        self.assertEqual(self.cache.getPixelCount(), 2*nPixels)
+        self.cache.computeImage(self.psf, a, 64, 10)
+        self.assertEqual(self.cache.getHitCount(), 2)
+        self.cache.computeImage(self.psf, b, 64, 10)
+        self.assertEqual(self.cache.getMissCount(), 4)
+
+    def testNewPsf(self):
+        """Test that the cache is flushed when it's given a different Psf."""
+        position = lsst.afw.geom.Point2D(30.3, 40.8)
+        self.cache.computeImage(self.psf, position, 64, 10)
+        psf = lsst.afw.detection.GaussianPsf(25, 25, 3.0)
+        image = self.cache.computeImage(psf, position, 64, 10)
+        self.assertClose(image.getArray(), psf.computeImage(position).getArray(), atol=1E-6)
+        self.assertEqual(self.cache.getSize(), 1)
+        self.assertEqual(self.cache.getMissCount(), 2)
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(PsfImageCacheTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
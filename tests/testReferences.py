@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import numpy
+
+import lsst.afw.coord
+import lsst.afw.geom
+import lsst.afw.image
+import lsst.afw.table
+import lsst.utils.tests
+from lsst.meas.base.references import BaseReferencesTask, ReferenceIndex
+
+
+class ReferenceIndexTestCase(lsst.utils.tests.TestCase):
+    """Test that ReferenceIndex.subset returns exactly what BaseReferencesTask.subset does, in the same
+    order, around the places where the bucketing could go wrong.
+    """
+
+    def setUp(self):
+        self.schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        self.task = BaseReferencesTask()
+        self.task.schema = self.schema
+        self.bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0), lsst.afw.geom.Extent2I(100, 100))
+
+    def tearDown(self):
+        del self.schema
+        del self.task
+        del self.bbox
+
+    def makeWcs(self, ra, dec, scale=0.2):
+        """Make a TAN Wcs with the given center (degrees) at pixel (50, 50) and pixel scale (arcsec)."""
+        crval = lsst.afw.coord.IcrsCoord(ra*lsst.afw.geom.degrees, dec*lsst.afw.geom.degrees)
+        cd = scale/3600.0
+        return lsst.afw.image.makeWcs(crval, lsst.afw.geom.Point2D(50.0, 50.0), cd, 0.0, 0.0, cd)
+
+    def makeCatalog(self, wcs, nParents=400, seed=1):
+        """Make a catalog of parents scattered over (and well beyond) the bounding box, with every fifth
+        one deblended into two children.  The records are shuffled, so the catalog is unsorted.
+        """
+        rng = numpy.random.RandomState(seed)
+        catalog = lsst.afw.table.SourceCatalog(self.schema)
+        for i in range(nParents):
+            position = lsst.afw.geom.Point2D(*rng.uniform(-150.0, 250.0, 2))
+            parent = catalog.addNew()
+            parent.setCoord(wcs.pixelToSky(position))
+            if i % 5 == 0:
+                for j in range(2):
+                    child = catalog.addNew()
+                    child.setParent(parent.getId())
+                    offset = lsst.afw.geom.Extent2D(*rng.uniform(-3.0, 3.0, 2))
+                    child.setCoord(wcs.pixelToSky(position + offset))
+        shuffled = lsst.afw.table.SourceCatalog(self.schema)
+        for k in rng.permutation(len(catalog)):
+            shuffled.append(catalog[int(k)])
+        return shuffled
+
+    def checkSubset(self, wcs, bucketSizes=(1.0, 7.0, 30.0, 3600.0)):
+        catalog = self.makeCatalog(wcs)
+        boxes = [lsst.afw.geom.Box2D(self.bbox)]
+        for dx, dy in ((0.3, -17.7), (-41.1, 23.4), (60.5, 60.5)):
+            box = lsst.afw.geom.Box2D(self.bbox)
+            box.shift(lsst.afw.geom.Extent2D(dx, dy))
+            boxes.append(box)
+        for bucketSize in bucketSizes:
+            index = ReferenceIndex(catalog, self.schema, bucketSize*lsst.afw.geom.arcseconds)
+            for box in boxes:
+                expected = [record.getId() for record in self.task.subset(catalog, box, wcs)]
+                result = list(index.subset(box, wcs))
+                self.assertGreater(len(expected), 0)
+                self.assertEqual([record.getId() for record in result], expected)
+                self.checkFamilies(catalog, result)
+
+    def checkFamilies(self, catalog, result):
+        """Check that every child in result follows its parent, and that all of a parent's children are
+        returned with it.
+        """
+        seen = set()
+        returnedChildren = {}
+        for record in result:
+            if record.getParent() != 0:
+                self.assertIn(record.getParent(), seen)
+                returnedChildren.setdefault(record.getParent(), set()).add(record.getId())
+            seen.add(record.getId())
+        allChildren = {}
+        for record in catalog:
+            if record.getParent() != 0:
+                allChildren.setdefault(record.getParent(), set()).add(record.getId())
+        for parentId in seen:
+            self.assertEqual(returnedChildren.get(parentId, set()), allChildren.get(parentId, set()))
+
+    def testEquator(self):
+        self.checkSubset(self.makeWcs(45.0, 0.0))
+
+    def testRaWrap(self):
+        """The box straddles RA=0, so buckets at both ends of the RA range must be searched."""
+        self.checkSubset(self.makeWcs(0.0, 10.0))
+        self.checkSubset(self.makeWcs(359.999, -30.0))
+
+    def testPole(self):
+        """The box contains (or is very close to) a pole, where the RA bins are narrowest."""
+        self.checkSubset(self.makeWcs(120.0, 89.999))
+        self.checkSubset(self.makeWcs(300.0, -89.9995))
+
+    def testBucketEdges(self):
+        """With buckets no larger than the box, many parents lie close to their edges."""
+        self.checkSubset(self.makeWcs(10.0, 45.0, scale=0.05), bucketSizes=(0.3, 1.0, 5.0))
+
+    def testEmpty(self):
+        index = ReferenceIndex([], self.schema, 30.0*lsst.afw.geom.arcseconds)
+        self.assertEqual(list(index.subset(self.bbox, self.makeWcs(45.0, 0.0))), [])
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(ReferenceIndexTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import lsst.afw.geom
+import lsst.afw.image
+import lsst.utils.tests
+import lsst.meas.base
+
+
+class ScratchArenaTestCase(lsst.utils.tests.TestCase):
+
+    def setUp(self):
+        self.arena = lsst.meas.base.ScratchArena(1024)
+
+    def tearDown(self):
+        del self.arena
+
+    def testMakeImage(self):
+        """Test that images from the arena cover the requested box, and can be written to."""
+        bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(3, 4), lsst.afw.geom.Extent2I(5, 6))
+        image = self.arena.makeImageF(bbox)
+        self.assertEqual(image.getBBox(lsst.afw.image.PARENT), bbox)
+        image.set(1.5)
+        self.assertClose(image.getArray(), 1.5)
+        # 120 bytes, rounded up to a multiple of the alignment
+        self.assertEqual(self.arena.getBytesInUse(), 128)
+        self.assertEqual(self.arena.getBlockCount(), 1)
+        self.assertEqual(self.arena.getCapacity(), 1024)
+
+    def testReset(self):
+        """Test that reset() coalesces the blocks, so the same allocations then need no more of them."""
+        big = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0), lsst.afw.geom.Extent2I(20, 20))
+        small = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0), lsst.afw.geom.Extent2I(10, 10))
+        self.arena.makeImageD(big)      # 3200 bytes: too big for a default block, so gets its own
+        self.arena.makeImageF(small)    # 416 bytes: doesn't fit after that, so needs a new block
+        self.assertEqual(self.arena.getBlockCount(), 2)
+        self.assertEqual(self.arena.getHeapAllocationCount(), 2)
+        self.assertEqual(self.arena.getBytesInUse(), 3616)
+        self.arena.reset()
+        self.assertEqual(self.arena.getBytesInUse(), 0)
+        self.assertEqual(self.arena.getBlockCount(), 1)
+        self.assertEqual(self.arena.getCapacity(), 3200 + 1024)
+        self.assertEqual(self.arena.getHeapAllocationCount(), 3)
+        for i in range(3):
+            self.arena.makeImageD(big)
+            self.arena.makeImageF(small)
+            self.arena.reset()
+        self.assertEqual(self.arena.getHeapAllocationCount(), 3)
+        self.assertEqual(self.arena.getHighWaterMark(), 3616)
+
+    def testScope(self):
+        """Test that a ScratchScope gives back what was allocated within it, unless the arena is reset."""
+        bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0), lsst.afw.geom.Extent2I(4, 4))
+        self.arena.makeImageF(bbox)
+        scope = lsst.meas.base.ScratchScope(self.arena)
+        self.arena.makeImageF(bbox)
+        self.arena.makeImageD(bbox)
+        self.assertEqual(self.arena.getBytesInUse(), 64 + 64 + 128)
+        del scope
+        self.assertEqual(self.arena.getBytesInUse(), 64)
+        scope = lsst.meas.base.ScratchScope(self.arena)
+        self.arena.makeImageF(bbox)
+        self.arena.reset()
+        self.arena.makeImageD(bbox)
+        del scope
+        self.assertEqual(self.arena.getBytesInUse(), 128)
+
+    def testThreadArena(self):
+        """Test that getThreadArena() always returns the same arena within a thread."""
+        arena = lsst.meas.base.ScratchArena.getThreadArena()
+        self.assertEqual(arena.getBlockSize(), lsst.meas.base.ScratchArena.DEFAULT_BLOCK_SIZE)
+        arena.makeImageF(lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(0, 0), lsst.afw.geom.Extent2I(4, 4)))
+        self.assertEqual(lsst.meas.base.ScratchArena.getThreadArena().getBytesInUse(), arena.getBytesInUse())
+        arena.reset()
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(ScratchArenaTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -112,6 +112,37 @@ class SdssCentroidTestCase(AlgorithmTestCase):
             self.assertLess(xMean - x, 3.0*xSigmaMean / nSamples**0.5)   # rng dependent
             self.assertLess(yMean - y, 3.0*ySigmaMean / nSamples**0.5)   # rng dependent
 
+    def testKernelCache(self):
+        """Test that caching PSF kernels on a coarse grid doesn't change the answer for a constant Psf,
+        and that repeated measurements with the cache populated (or with every kernel evicted) are
+        identical.
+        """
+        exact, schema = self.makeAlgorithm()
+        exposure, catalog = self.dataset.realize(10.0, schema)
+        record = catalog[0]
+        exact.measure(record, exposure)
+        x, y = record.get("base_SdssCentroid_x"), record.get("base_SdssCentroid_y")
+        for maxPixels in (lsst.meas.base.SdssCentroidControl().kernelCacheMaxPixels, 1):
+            ctrl = lsst.meas.base.SdssCentroidControl()
+            ctrl.kernelCacheCellSize = 64
+            ctrl.kernelCacheMaxPixels = maxPixels
+            cached, _ = self.makeAlgorithm(ctrl)
+            for repeat in range(2):
+                cached.measure(record, exposure)
+                self.assertClose(record.get("base_SdssCentroid_x"), x, rtol=1E-6)
+                self.assertClose(record.get("base_SdssCentroid_y"), y, rtol=1E-6)
+
+    def testScratchArena(self):
+        """Test that the kernel is taken from the thread's ScratchArena, and given back.
+        """
+        alg, schema = self.makeAlgorithm()
+        exposure, catalog = self.dataset.realize(10.0, schema)
+        arena = lsst.meas.base.ScratchArena.getThreadArena()
+        arena.reset()
+        alg.measure(catalog[0], exposure)
+        self.assertEqual(arena.getBytesInUse(), 0)
+        self.assertGreater(arena.getHighWaterMark(), 0)
+
     def testEdge(self):
         task = self.makeSingleFrameMeasurementTask("base_SdssCentroid")
         exposure, catalog = self.dataset.realize(10.0, task.schema)
@@ -0,0 +1,185 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2016 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+import unittest
+
+import lsst.afw.geom
+import lsst.afw.table
+import lsst.meas.base
+import lsst.meas.base.tests
+import lsst.utils.tests
+from lsst.meas.base.forcedMeasurement import ForcedMeasurementTask
+
+BROKEN_CHAIN_MESSAGE = ("Reference catalog contains a child for which at least "
+                        "one parent in its parent chain is not in the catalog.")
+
+
+class SourceFamiliesTestCase(lsst.utils.tests.TestCase):
+
+    def setUp(self):
+        self.schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+
+    def tearDown(self):
+        del self.schema
+
+    def makeCatalog(self, pairs):
+        """Make a catalog from a sequence of (id, parent) pairs, in the given order."""
+        catalog = lsst.afw.table.SourceCatalog(self.schema)
+        for id, parent in pairs:
+            record = catalog.addNew()
+            record.setId(id)
+            record.setParent(parent)
+        return catalog
+
+    def checkFamilies(self, pairs):
+        """Check SourceFamilies against a brute-force reading of the (id, parent) pairs."""
+        families = lsst.meas.base.SourceFamilies(self.makeCatalog(pairs))
+        self.assertEqual(families.size(), len(pairs))
+        index = {id: i for i, (id, parent) in enumerate(pairs)}
+        self.assertEqual(list(families.getParentIndices()),
+                         [i for i, (id, parent) in enumerate(pairs) if parent == 0])
+        for i, (id, parent) in enumerate(pairs):
+            self.assertEqual(families.getParentIndex(i), index[parent] if parent != 0 else -1)
+            self.assertEqual(list(families.getChildIndices(i)),
+                             [j for j, (childId, childParent) in enumerate(pairs) if childParent == id])
+        return families
+
+    def testSorted(self):
+        self.checkFamilies([(1, 0), (2, 0), (3, 0), (4, 2), (5, 2), (6, 3)])
+
+    def testUnsorted(self):
+        """Test a catalog sorted neither by id nor by parent, with children before their parents and
+        separated from their siblings, and a grandchild."""
+        families = self.checkFamilies([(5, 2), (3, 0), (9, 0), (2, 0), (6, 3), (4, 2), (7, 6), (1, 0)])
+        self.assertEqual(list(families.getChildIndices(3)), [0, 5])
+
+    def testEmpty(self):
+        families = self.checkFamilies([])
+        self.assertEqual(len(families.getParentIndices()), 0)
+
+    def testBrokenChain(self):
+        """Test that a child whose parent (or grandparent) is missing raises the same error as the
+        Python check SourceFamilies replaced."""
+        for pairs in ([(1, 0), (2, 8)],
+                      [(1, 0), (3, 2), (4, 3)],
+                      [(4, 3), (3, 2), (1, 0)]):
+            with self.assertRaises(RuntimeError) as context:
+                lsst.meas.base.SourceFamilies(self.makeCatalog(pairs))
+            self.assertIn(BROKEN_CHAIN_MESSAGE, str(context.exception))
+
+    def testCircularChain(self):
+        for pairs in ([(1, 0), (2, 3), (3, 2)],
+                      [(1, 1)],
+                      [(1, 0), (2, 4), (3, 2), (4, 3), (5, 3)]):
+            with self.assertRaises(RuntimeError) as context:
+                lsst.meas.base.SourceFamilies(self.makeCatalog(pairs))
+            self.assertIn("circular", str(context.exception))
+
+
+class ForcedFamiliesTestCase(lsst.meas.base.tests.AlgorithmTestCase):
+    """Test that forced measurement handles unsorted reference catalogs and non-contiguous children."""
+
+    def setUp(self):
+        self.bbox = lsst.afw.geom.Box2I(lsst.afw.geom.Point2I(-20, -30),
+                                        lsst.afw.geom.Extent2I(240, 260))
+        self.dataset = lsst.meas.base.tests.TestDataset(self.bbox)
+        self.dataset.addSource(100000.0, lsst.afw.geom.Point2D(50.1, 49.8))
+        self.dataset.addSource(120000.0, lsst.afw.geom.Point2D(149.9, 50.3))
+        with self.dataset.addBlend() as family:
+            family.addChild(110000.0, lsst.afw.geom.Point2D(65.2, 150.7))
+            family.addChild(140000.0, lsst.afw.geom.Point2D(72.3, 149.1))
+            family.addChild(90000.0, lsst.afw.geom.Point2D(68.5, 156.9))
+
+    def tearDown(self):
+        del self.bbox
+        del self.dataset
+
+    def testMakeSubset(self):
+        catalog = self.dataset.catalog
+        contiguous = ForcedMeasurementTask._makeSubset(catalog, [2, 3, 4])
+        self.assertTrue(contiguous.isContiguous())
+        self.assertEqual([r.getId() for r in contiguous], [catalog[i].getId() for i in (2, 3, 4)])
+        copied = ForcedMeasurementTask._makeSubset(catalog, [0, 2, 4])
+        self.assertEqual([r.getId() for r in copied], [catalog[i].getId() for i in (0, 2, 4)])
+        # the copy shares its records with the original catalog
+        copied[1].setParent(12345)
+        self.assertEqual(catalog[2].getParent(), 12345)
+        self.assertEqual(len(ForcedMeasurementTask._makeSubset(catalog, [])), 0)
+
+    def testUnsortedReferences(self):
+        """Test that measuring a shuffled reference catalog, in which the children of the blend are
+        separated by other records, gives the same results as the sorted one."""
+        task = self.makeForcedMeasurementTask("base_PsfFlux")
+        task.config.doReplaceWithNoise = False
+        refWcs = self.dataset.exposure.getWcs()
+        measDataset = self.dataset.transform(self.dataset.makePerturbedWcs(refWcs))
+        exposure, truthCatalog = measDataset.realize(10.0, measDataset.makeMinimalSchema())
+        sortedRefCat = self.dataset.catalog
+        # order: child, parent, blend parent, child, parent, child
+        order = [3, 0, 2, 4, 1, 5]
+        self.assertEqual([sortedRefCat[i].getParent() != 0 for i in order],
+                         [True, False, False, True, False, True])
+        shuffledRefCat = lsst.afw.table.SourceCatalog(sortedRefCat.getTable())
+        for i in order:
+            shuffledRefCat.append(sortedRefCat[i])
+        families = lsst.meas.base.SourceFamilies(shuffledRefCat)
+        childIndices = list(families.getChildIndices(2))
+        self.assertEqual(len(childIndices), 3)
+        self.assertNotEqual(childIndices[-1] - childIndices[0] + 1, len(childIndices))
+
+        results = {}
+        for refCat in (sortedRefCat, shuffledRefCat):
+            measCat = task.generateMeasCat(exposure, refCat, refWcs)
+            task.attachTransformedFootprints(measCat, refCat, exposure, refWcs)
+            task.run(measCat, exposure, refCat, refWcs)
+            results[len(results)] = {refRecord.getId(): (measRecord.get("base_PsfFlux_flux"),
+                                                         measRecord.get("base_PsfFlux_flag"))
+                                     for refRecord, measRecord in zip(refCat, measCat)}
+        self.assertEqual(results[0], results[1])
+
+        # With noise replacement, the families must still be measured without errors.
+        task = self.makeForcedMeasurementTask("base_PsfFlux")
+        measCat = task.generateMeasCat(exposure, shuffledRefCat, refWcs)
+        task.attachTransformedFootprints(measCat, shuffledRefCat, exposure, refWcs)
+        task.run(measCat, exposure, shuffledRefCat, refWcs)
+        for measRecord in measCat:
+            self.assertFalse(measRecord.get("base_PsfFlux_flag"))
+
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    lsst.utils.tests.init()
+
+    suites = []
+    suites += unittest.makeSuite(SourceFamiliesTestCase)
+    suites += unittest.makeSuite(ForcedFamiliesTestCase)
+    suites += unittest.makeSuite(lsst.utils.tests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    lsst.utils.tests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -173,14 +173,16 @@ class BadCentroidTest(unittest.TestCase):
         variance = measBase.SingleFrameVariancePlugin(measBase.SingleFrameVarianceConfig(),
                                                       "variance", schema, None)
         catalog = afwTable.SourceCatalog(schema)
+        exposure = afwImage.ExposureF(10, 10)
 
         # The centroid is not flagged as bad, but there's no way the algorithm can run without
-        # valid data in the SourceRecord and Exposure: this should throw a logic error.
+        # valid data in the SourceRecord: this should throw a logic error, which the measurement
+        # framework handles by calling fail() without the exception.
         record = catalog.addNew()
         record.set("centroid_flag", False)
-        with self.assertRaises(pexExcept.LogicError) as measErr:
-            variance.measure(record, None)
-        variance.fail(record, measErr.exception)
+        with self.assertRaises(pexExcept.LogicError):
+            variance.measure(record, exposure)
+        variance.fail(record)
         self.assertTrue(record.get("variance_flag"))
         self.assertFalse(record.get("variance_flag_badCentroid"))
 
@@ -189,7 +191,7 @@ class BadCentroidTest(unittest.TestCase):
         record = catalog.addNew()
         record.set("centroid_flag", True)
         with self.assertRaises(measBase.MeasurementError) as measErr:
-            variance.measure(record, None)
+            variance.measure(record, exposure)
         variance.fail(record, measErr.exception)
         self.assertTrue(record.get("variance_flag"))
         self.assertTrue(record.get("variance_flag_badCentroid"))